@@ -11,6 +11,8 @@ files = [
  "opa_lcell.vhd",
  "opa_prim_ternary.vhd",
  "opa_prim_mul.vhd",
+ "opa_prim_div.vhd",
+ "opa_prim_fpu.vhd",
  "opa_lfsr.vhd",
  "opa_prefixsum.vhd",
  "opa_predict.vhd",
@@ -90,7 +90,7 @@ architecture rtl of opa is
   constant c_num_fast  : natural := f_opa_num_fast (g_config);
   constant c_num_slow  : natural := f_opa_num_slow (g_config);
   constant c_num_back  : natural := f_opa_num_back (g_isa,g_config);
-  constant c_num_arch  : natural := f_opa_num_arch (g_isa);
+  constant c_num_arch  : natural := f_opa_num_arch (g_isa,g_config);
   constant c_num_stat  : natural := f_opa_num_stat (g_config);
   constant c_page_size : natural := f_opa_page_size (g_isa);
   constant c_dline_size: natural := f_opa_dline_size(g_config);
@@ -101,7 +101,7 @@ architecture rtl of opa is
   constant c_num_dway  : natural := f_opa_num_dway (g_config);
   constant c_back_wide : natural := f_opa_back_wide(g_isa,g_config);
   constant c_stat_wide : natural := f_opa_stat_wide(g_config);
-  constant c_arch_wide : natural := f_opa_arch_wide(g_isa);
+  constant c_arch_wide : natural := f_opa_arch_wide(g_isa,g_config);
   constant c_reg_wide  : natural := f_opa_reg_wide(g_config);
   constant c_adr_wide  : natural := f_opa_adr_wide(g_config);
   constant c_arg_wide  : natural := f_opa_arg_wide(g_config);
@@ -109,7 +109,7 @@ architecture rtl of opa is
   constant c_fet_wide  : natural := f_opa_fet_wide(g_config);
   constant c_aux_wide  : natural := f_opa_aux_wide(g_config);
   constant c_ren_wide  : natural := f_opa_ren_wide(g_config);
-  constant c_alias_high: natural := f_opa_alias_high(g_isa);
+  constant c_alias_high: natural := f_opa_alias_high(g_isa,g_config);
   constant c_alias_low : natural := f_opa_alias_low (g_config);
   
   signal predict_icache_pc      : std_logic_vector(c_adr_wide-1 downto c_op_align);
@@ -135,7 +135,10 @@ architecture rtl of opa is
   signal decode_rename_fast     : std_logic_vector(c_renamers-1 downto 0);
   signal decode_rename_slow     : std_logic_vector(c_renamers-1 downto 0);
   signal decode_rename_order    : std_logic_vector(c_renamers-1 downto 0);
+  signal decode_rename_safe     : std_logic_vector(c_renamers-1 downto 0);
+  signal decode_rename_long     : std_logic_vector(c_renamers-1 downto 0);
   signal decode_rename_setx     : std_logic_vector(c_renamers-1 downto 0);
+  signal decode_rename_move     : std_logic_vector(c_renamers-1 downto 0);
   signal decode_rename_geta     : std_logic_vector(c_renamers-1 downto 0);
   signal decode_rename_getb     : std_logic_vector(c_renamers-1 downto 0);
   signal decode_rename_aux      : std_logic_vector(c_aux_wide-1 downto 0);
@@ -159,6 +162,8 @@ architecture rtl of opa is
   signal rename_issue_fast      : std_logic_vector(c_renamers-1 downto 0);
   signal rename_issue_slow      : std_logic_vector(c_renamers-1 downto 0);
   signal rename_issue_order     : std_logic_vector(c_renamers-1 downto 0);
+  signal rename_issue_safe      : std_logic_vector(c_renamers-1 downto 0);
+  signal rename_issue_long      : std_logic_vector(c_renamers-1 downto 0);
   signal rename_issue_geta      : std_logic_vector(c_renamers-1 downto 0);
   signal rename_issue_getb      : std_logic_vector(c_renamers-1 downto 0);
   signal rename_issue_aux       : std_logic_vector(c_aux_wide-1 downto 0);
@@ -169,9 +174,12 @@ architecture rtl of opa is
   signal rename_issue_statb     : t_opa_matrix(c_renamers-1 downto 0, c_stat_wide-1 downto 0);
   
   signal issue_rename_stall     : std_logic;
+  signal issue_rename_drain     : std_logic;
   signal issue_rename_bakx      : t_opa_matrix(c_renamers-1 downto 0, c_back_wide-1 downto 0);
   signal issue_eu_oldest        : std_logic_vector(c_executers-1 downto 0);
   signal issue_rename_fault     : std_logic;
+  signal issue_rename_resume    : std_logic;
+  signal issue_rename_redir     : std_logic;
   signal issue_rename_mask      : std_logic_vector(c_renamers-1 downto 0);
   signal issue_rename_pc        : std_logic_vector(c_adr_wide-1 downto c_op_align);
   signal issue_rename_pcf       : std_logic_vector(c_fet_wide-1 downto 0);
@@ -183,8 +191,11 @@ architecture rtl of opa is
   signal issue_regfile_dec      : t_opa_matrix(c_executers-1 downto 0, c_ren_wide-1 downto 0);
   signal issue_regfile_baka     : t_opa_matrix(c_executers-1 downto 0, c_back_wide-1 downto 0);
   signal issue_regfile_bakb     : t_opa_matrix(c_executers-1 downto 0, c_back_wide-1 downto 0);
+  signal issue_regfile_long     : std_logic_vector(c_executers-1 downto 0);
+  signal issue_regfile_stat     : t_opa_matrix(c_executers-1 downto 0, c_stat_wide-1 downto 0);
   signal issue_regfile_wstb     : std_logic_vector(c_executers-1 downto 0);
   signal issue_regfile_bakx     : t_opa_matrix(c_executers-1 downto 0, c_back_wide-1 downto 0);
+  signal issue_l1d_alias        : std_logic;
   
   signal regfile_eu_stb         : std_logic_vector(c_executers-1 downto 0);
   signal regfile_eu_rega        : t_opa_matrix(c_executers-1 downto 0, c_reg_wide-1  downto 0);
@@ -198,24 +209,37 @@ architecture rtl of opa is
   signal eu_regfile_regx        : t_opa_matrix(c_executers-1 downto 0, c_reg_wide-1 downto 0);
   signal eu_issue_retry         : std_logic_vector(c_executers-1 downto 0);
   signal eu_issue_fault         : std_logic_vector(c_executers-1 downto 0);
+  signal eu_issue_redir         : std_logic_vector(c_executers-1 downto 0);
   signal eu_issue_pc            : t_opa_matrix(c_executers-1 downto 0, c_adr_wide-1 downto c_op_align);
   signal eu_issue_pcf           : t_opa_matrix(c_executers-1 downto 0, c_fet_wide-1 downto 0);
   signal eu_issue_pcn           : t_opa_matrix(c_executers-1 downto 0, c_adr_wide-1 downto c_op_align);
+  signal regfile_issue_retry    : std_logic_vector(c_executers-1 downto 0);
+  signal s_issue_retry          : std_logic_vector(c_executers-1 downto 0);
+  signal s_issue_fault          : std_logic_vector(c_executers-1 downto 0);
+  signal s_issue_redir          : std_logic_vector(c_executers-1 downto 0);
   
   signal slow_l1d_stb           : std_logic_vector(c_num_slow-1 downto 0);
   signal slow_l1d_we            : std_logic_vector(c_num_slow-1 downto 0);
   signal slow_l1d_sext          : std_logic_vector(c_num_slow-1 downto 0);
   signal slow_l1d_size          : t_opa_matrix(c_num_slow-1 downto 0, 1 downto 0);
+  signal slow_l1d_pref          : std_logic_vector(c_num_slow-1 downto 0);
+  signal slow_l1d_pc            : t_opa_matrix(c_num_slow-1 downto 0, c_adr_wide-1 downto c_op_align);
   signal slow_l1d_addr          : t_opa_matrix(c_num_slow-1 downto 0, c_reg_wide-1 downto 0);
   signal slow_l1d_data          : t_opa_matrix(c_num_slow-1 downto 0, c_reg_wide-1 downto 0);
   signal slow_l1d_oldest        : std_logic_vector(c_num_slow-1 downto 0);
   
   signal l1d_slow_retry         : std_logic_vector(c_num_slow-1 downto 0);
+  signal l1d_slow_fault         : std_logic_vector(c_num_slow-1 downto 0);
+  signal l1d_slow_trap          : std_logic_vector(c_adr_wide-1 downto c_op_align);
   signal l1d_slow_data          : t_opa_matrix(c_num_slow-1 downto 0, c_reg_wide-1 downto 0);
   signal l1d_issue_store        : std_logic;
   signal l1d_issue_load         : std_logic_vector(c_num_slow-1 downto 0);
   signal l1d_issue_addr         : t_opa_matrix(c_num_slow-1 downto 0, c_alias_high downto c_alias_low);
   signal l1d_issue_mask         : t_opa_matrix(c_num_slow-1 downto 0, c_reg_wide/8-1 downto 0);
+  signal l1d_decode_wait        : std_logic;
+  signal l1d_decode_pc          : std_logic_vector(c_adr_wide-1 downto c_op_align);
+  signal l1d_decode_io          : std_logic;
+  signal l1d_decode_iopc        : std_logic_vector(c_adr_wide-1 downto c_op_align);
   signal l1d_dbus_req           : t_opa_dbus_request;
   signal l1d_dbus_radr          : std_logic_vector(c_adr_wide-1 downto 0);
   signal l1d_dbus_way           : std_logic_vector(c_num_dway-1 downto 0);
@@ -228,8 +252,12 @@ architecture rtl of opa is
   signal l1d_pbus_sel           : std_logic_vector(c_reg_wide/8-1 downto 0);
   signal l1d_pbus_dat           : std_logic_vector(c_reg_wide  -1 downto 0);
   signal l1d_pbus_pop           : std_logic;
+  signal l1d_pbus_fault         : std_logic;
+  signal l1d_pbus_fpage         : std_logic_vector(c_adr_wide-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+  signal l1d_pbus_fpc           : std_logic_vector(c_adr_wide-1 downto c_op_align);
   
   signal dbus_l1d_busy          : std_logic;
+  signal dbus_l1d_fill          : std_logic;
   signal dbus_l1d_we            : std_logic_vector(c_num_dway-1 downto 0);
   signal dbus_l1d_adr           : std_logic_vector(c_adr_wide-1 downto 0);
   signal dbus_l1d_valid         : std_logic_vector(c_dline_size  -1 downto 0);
@@ -239,6 +267,10 @@ architecture rtl of opa is
   signal pbus_l1d_full          : std_logic;
   signal pbus_l1d_err           : std_logic;
   signal pbus_l1d_dat           : std_logic_vector(c_reg_wide-1 downto 0);
+  signal pbus_l1d_vm            : std_logic;
+  signal pbus_l1d_root          : std_logic_vector(c_adr_wide-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+  signal pbus_l1d_flush         : std_logic;
+  signal pbus_l1d_trap          : std_logic_vector(c_adr_wide-1 downto c_op_align);
   
   type t_reg  is array (c_executers-1 downto 0) of std_logic_vector(c_reg_wide -1 downto 0);
   type t_arg  is array (c_executers-1 downto 0) of std_logic_vector(c_arg_wide -1 downto 0);
@@ -247,6 +279,7 @@ architecture rtl of opa is
   type t_pcf  is array (c_executers-1 downto 0) of std_logic_vector(c_fet_wide -1 downto 0);
   type t_size is array (c_num_slow -1 downto 0) of std_logic_vector(1 downto 0);
   type t_adr  is array (c_num_slow -1 downto 0) of std_logic_vector(c_reg_wide -1 downto 0);
+  type t_spc  is array (c_num_slow -1 downto 0) of std_logic_vector(c_adr_wide -1 downto c_op_align);
   type t_dat  is array (c_num_slow -1 downto 0) of std_logic_vector(c_reg_wide -1 downto 0);
   
   signal s_regfile_eu_rega : t_reg;
@@ -262,6 +295,7 @@ architecture rtl of opa is
   signal s_eu_issue_pcn    : t_pc;
   signal s_slow_l1d_size   : t_size;
   signal s_slow_l1d_addr   : t_adr;
+  signal s_slow_l1d_pc     : t_spc;
   signal s_slow_l1d_data   : t_dat;
   signal s_l1d_slow_data   : t_dat;
   
@@ -317,10 +351,75 @@ begin
     report "num_slow must be >= 1"
     severity failure;
   
+  check_clust_min :
+    assert (g_config.num_clust >= 1)
+    report "num_clust must be >= 1"
+    severity failure;
+  
+  check_clust_fast :
+    assert (g_config.num_fast mod g_config.num_clust = 0)
+    report "num_fast must be divisible by num_clust"
+    severity failure;
+  
+  check_clust_rename :
+    assert (g_config.num_rename mod g_config.num_clust = 0)
+    report "num_rename must be divisible by num_clust"
+    severity failure;
+  
+  check_rf_banks :
+    assert (g_config.rf_banks = 0 or 2**f_opa_log2(g_config.rf_banks) = g_config.rf_banks)
+    report "rf_banks must be 0 or a power of 2"
+    severity failure;
+  
+  check_fin_ready :
+    assert (not g_config.fin_ready or g_config.rf_banks = 0)
+    report "fin_ready requires rf_banks = 0 (a bank conflict retries any op)"
+    severity failure;
+  
+  check_ftq_min :
+    assert (g_config.ftq_size >= 2)
+    report "ftq_size must be >= 2"
+    severity failure;
+  
+  check_ftq_pow :
+    assert (2**f_opa_log2(g_config.ftq_size) = g_config.ftq_size)
+    report "ftq_size must be a power of 2"
+    severity failure;
+  
+  check_dq_min :
+    assert (g_config.dq_size >= g_config.num_fetch + 2*g_config.num_rename - 1)
+    report "dq_size must be >= num_fetch + 2*num_rename - 1"
+    severity failure;
+  
+  check_dpf_pow :
+    assert (g_config.dpf_size = 0 or (g_config.dpf_size >= 2 and 2**f_opa_log2(g_config.dpf_size) = g_config.dpf_size))
+    report "dpf_size must be 0 or a power of 2 >= 2"
+    severity failure;
+  
+  check_pbus_fifo :
+    assert (g_config.pbus_fifo >= 4 and 2**f_opa_log2(g_config.pbus_fifo) = g_config.pbus_fifo)
+    report "pbus_fifo must be a power of 2 >= 4"
+    severity failure;
+  
+  check_alias_tag :
+    assert (g_config.alias_tag <= g_config.adr_width - f_opa_log2(f_opa_page_size(g_isa)))
+    report "alias_tag must not exceed the page number width"
+    severity failure;
+  
+  check_lwt_pow :
+    assert (g_config.lwt_size = 0 or (g_config.lwt_size >= 2 and 2**f_opa_log2(g_config.lwt_size) = g_config.lwt_size))
+    report "lwt_size must be 0 or a power of 2 >= 2"
+    severity failure;
+  
+  check_dtlb :
+    assert (g_config.dtlb_ways = 0 or c_adr_wide - f_opa_log2(c_page_size) + 10 <= g_config.reg_width)
+    report "dtlb_ways > 0 requires the physical page number to fit in a PTE above bit 10"
+    severity failure;
+  
   check_ieee_fp :
-    assert (not g_config.ieee_fp)
-    report "IEEE fp currently unsupported"
-    severity warning;
+    assert (not g_config.ieee_fp or g_config.reg_width = 32)
+    report "ieee_fp implements single precision only, which requires reg_width=32"
+    severity failure;
   
   check_dway_pow :
     assert (2**f_opa_log2(g_config.dc_ways) = g_config.dc_ways)
@@ -462,7 +561,10 @@ begin
       rename_fast_o    => decode_rename_fast,
       rename_slow_o    => decode_rename_slow,
       rename_order_o   => decode_rename_order,
+      rename_safe_o    => decode_rename_safe,
+      rename_long_o    => decode_rename_long,
       rename_setx_o    => decode_rename_setx,
+      rename_move_o    => decode_rename_move,
       rename_geta_o    => decode_rename_geta,
       rename_getb_o    => decode_rename_getb,
       rename_aux_o     => decode_rename_aux,
@@ -473,6 +575,10 @@ begin
       rename_pc_i      => rename_decode_pc,
       rename_pcf_i     => rename_decode_pcf,
       rename_pcn_i     => rename_decode_pcn,
+      l1d_wait_i       => l1d_decode_wait,
+      l1d_pc_i         => l1d_decode_pc,
+      l1d_io_i         => l1d_decode_io,
+      l1d_iopc_i       => l1d_decode_iopc,
       regfile_stb_o    => decode_regfile_stb,
       regfile_aux_o    => decode_regfile_aux,
       regfile_arg_o    => decode_regfile_arg,
@@ -494,7 +600,10 @@ begin
       decode_fast_i  => decode_rename_fast,
       decode_slow_i  => decode_rename_slow,
       decode_order_i => decode_rename_order,
+      decode_safe_i  => decode_rename_safe,
+      decode_long_i  => decode_rename_long,
       decode_setx_i  => decode_rename_setx,
+      decode_move_i  => decode_rename_move,
       decode_geta_i  => decode_rename_geta,
       decode_getb_i  => decode_rename_getb,
       decode_aux_i   => decode_rename_aux,
@@ -503,9 +612,12 @@ begin
       decode_archb_i => decode_rename_archb,
       issue_stb_o    => rename_issue_stb,
       issue_stall_i  => issue_rename_stall,
+      issue_drain_i  => issue_rename_drain,
       issue_fast_o   => rename_issue_fast,
       issue_slow_o   => rename_issue_slow,
       issue_order_o  => rename_issue_order,
+      issue_safe_o   => rename_issue_safe,
+      issue_long_o   => rename_issue_long,
       issue_geta_o   => rename_issue_geta,
       issue_getb_o   => rename_issue_getb,
       issue_aux_o    => rename_issue_aux,
@@ -516,6 +628,8 @@ begin
       issue_statb_o  => rename_issue_statb,
       issue_bakx_i   => issue_rename_bakx,
       issue_fault_i  => issue_rename_fault,
+      issue_resume_i => issue_rename_resume,
+      issue_redir_i  => issue_rename_redir,
       issue_mask_i   => issue_rename_mask,
       issue_pc_i     => issue_rename_pc,
       issue_pcf_i    => issue_rename_pcf,
@@ -535,9 +649,12 @@ begin
       rst_n_i        => rst_n_i,
       rename_stb_i   => rename_issue_stb,
       rename_stall_o => issue_rename_stall,
+      rename_drain_o => issue_rename_drain,
       rename_fast_i  => rename_issue_fast,
       rename_slow_i  => rename_issue_slow,
       rename_order_i => rename_issue_order,
+      rename_safe_i  => rename_issue_safe,
+      rename_long_i  => rename_issue_long,
       rename_geta_i  => rename_issue_geta,
       rename_getb_i  => rename_issue_getb,
       rename_aux_i   => rename_issue_aux,
@@ -548,12 +665,15 @@ begin
       rename_statb_i => rename_issue_statb,
       rename_bakx_o  => issue_rename_bakx,
       eu_oldest_o    => issue_eu_oldest,
-      eu_retry_i     => eu_issue_retry,
-      eu_fault_i     => eu_issue_fault,
+      eu_retry_i     => s_issue_retry,
+      eu_fault_i     => s_issue_fault,
+      eu_redir_i     => s_issue_redir,
       eu_pc_i        => eu_issue_pc,
       eu_pcf_i       => eu_issue_pcf,
       eu_pcn_i       => eu_issue_pcn,
       rename_fault_o => issue_rename_fault,
+      rename_resume_o=> issue_rename_resume,
+      rename_redir_o => issue_rename_redir,
       rename_mask_o  => issue_rename_mask,
       rename_pc_o    => issue_rename_pc,
       rename_pcf_o   => issue_rename_pcf,
@@ -565,12 +685,15 @@ begin
       regfile_dec_o  => issue_regfile_dec,
       regfile_baka_o => issue_regfile_baka,
       regfile_bakb_o => issue_regfile_bakb,
+      regfile_long_o => issue_regfile_long,
+      regfile_stat_o => issue_regfile_stat,
       regfile_wstb_o => issue_regfile_wstb,
       regfile_bakx_o => issue_regfile_bakx,
       l1d_store_i    => l1d_issue_store,
       l1d_load_i     => l1d_issue_load,
       l1d_addr_i     => l1d_issue_addr,
-      l1d_mask_i     => l1d_issue_mask);
+      l1d_mask_i     => l1d_issue_mask,
+      l1d_alias_o    => issue_l1d_alias);
   
   regfile : opa_regfile
     generic map(
@@ -594,6 +717,8 @@ begin
       issue_dec_i  => issue_regfile_dec,
       issue_baka_i => issue_regfile_baka,
       issue_bakb_i => issue_regfile_bakb,
+      issue_long_i => issue_regfile_long,
+      issue_stat_i => issue_regfile_stat,
       eu_stb_o     => regfile_eu_stb,
       eu_rega_o    => regfile_eu_rega,
       eu_regb_o    => regfile_eu_regb,
@@ -604,7 +729,13 @@ begin
       eu_pcn_o     => regfile_eu_pcn,
       issue_wstb_i => issue_regfile_wstb,
       issue_bakx_i => issue_regfile_bakx,
-      eu_regx_i    => eu_regfile_regx);
+      eu_regx_i    => eu_regfile_regx,
+      issue_retry_o => regfile_issue_retry);
+  
+  -- An EU denied its register read ran on garbage; it must neither fault nor finish
+  s_issue_retry <= eu_issue_retry or regfile_issue_retry;
+  s_issue_fault <= eu_issue_fault and not regfile_issue_retry;
+  s_issue_redir <= eu_issue_redir and not regfile_issue_retry;
   
   -- Relabel matrix between issue+regfile and EUs
   eus : for u in 0 to c_executers-1 generate
@@ -640,6 +771,9 @@ begin
       slow_l1d_data(u,b) <= s_slow_l1d_data(u)(b);
       s_l1d_slow_data(u)(b) <= l1d_slow_data(u,b);
     end generate;
+    pc : for b in c_op_align to c_adr_wide-1 generate
+      slow_l1d_pc(u,b) <= s_slow_l1d_pc(u)(b);
+    end generate;
   end generate;
   
   fastx : for i in 0 to c_num_fast-1 generate
@@ -663,12 +797,15 @@ begin
         issue_oldest_i => issue_eu_oldest  (f_opa_fast_index(g_config, i)),
         issue_retry_o  => eu_issue_retry   (f_opa_fast_index(g_config, i)),
         issue_fault_o  => eu_issue_fault   (f_opa_fast_index(g_config, i)),
+        issue_redir_o  => eu_issue_redir   (f_opa_fast_index(g_config, i)),
         issue_pc_o     => s_eu_issue_pc    (f_opa_fast_index(g_config, i)),
         issue_pcf_o    => s_eu_issue_pcf   (f_opa_fast_index(g_config, i)),
         issue_pcn_o    => s_eu_issue_pcn   (f_opa_fast_index(g_config, i)));
   end generate;
   
   slowx : for i in 0 to c_num_slow-1 generate
+    eu_issue_redir(f_opa_slow_index(g_config, i)) <= '0';
+    
     slow : opa_slow
       generic map(
         g_isa    => g_isa,
@@ -690,10 +827,14 @@ begin
         l1d_we_o       => slow_l1d_we      (i),
         l1d_sext_o     => slow_l1d_sext    (i),
         l1d_size_o     => s_slow_l1d_size  (i),
+        l1d_pref_o     => slow_l1d_pref    (i),
+        l1d_pc_o       => s_slow_l1d_pc    (i),
         l1d_addr_o     => s_slow_l1d_addr  (i),
         l1d_data_o     => s_slow_l1d_data  (i),
         l1d_oldest_o   => slow_l1d_oldest  (i),
         l1d_retry_i    => l1d_slow_retry   (i),
+        l1d_fault_i    => l1d_slow_fault   (i),
+        l1d_trap_i     => l1d_slow_trap,
         l1d_data_i     => s_l1d_slow_data  (i),
         issue_oldest_i => issue_eu_oldest  (f_opa_slow_index(g_config, i)),
         issue_retry_o  => eu_issue_retry   (f_opa_slow_index(g_config, i)),
@@ -715,15 +856,24 @@ begin
       slow_we_i     => slow_l1d_we,
       slow_sext_i   => slow_l1d_sext,
       slow_size_i   => slow_l1d_size,
+      slow_pref_i   => slow_l1d_pref,
+      slow_pc_i     => slow_l1d_pc,
       slow_addr_i   => slow_l1d_addr,
       slow_data_i   => slow_l1d_data,
       slow_oldest_i => slow_l1d_oldest,
       slow_retry_o  => l1d_slow_retry,
+      slow_fault_o  => l1d_slow_fault,
+      slow_trap_o   => l1d_slow_trap,
       slow_data_o   => l1d_slow_data,
       issue_store_o => l1d_issue_store,
       issue_load_o  => l1d_issue_load,
       issue_addr_o  => l1d_issue_addr,
       issue_mask_o  => l1d_issue_mask,
+      issue_alias_i => issue_l1d_alias,
+      decode_wait_o => l1d_decode_wait,
+      decode_pc_o   => l1d_decode_pc,
+      decode_io_o   => l1d_decode_io,
+      decode_iopc_o => l1d_decode_iopc,
       dbus_req_o    => l1d_dbus_req,
       dbus_radr_o   => l1d_dbus_radr,
       dbus_way_o    => l1d_dbus_way,
@@ -731,6 +881,7 @@ begin
       dbus_dirty_o  => l1d_dbus_dirty,
       dbus_data_o   => l1d_dbus_data,
       dbus_busy_i   => dbus_l1d_busy,
+      dbus_fill_i   => dbus_l1d_fill,
       dbus_we_i     => dbus_l1d_we,
       dbus_adr_i    => dbus_l1d_adr,
       dbus_valid_i  => dbus_l1d_valid,
@@ -744,7 +895,14 @@ begin
       pbus_pop_o    => l1d_pbus_pop,
       pbus_full_i   => pbus_l1d_full,
       pbus_err_i    => pbus_l1d_err,
-      pbus_dat_i    => pbus_l1d_dat);
+      pbus_dat_i    => pbus_l1d_dat,
+      pbus_vm_i     => pbus_l1d_vm,
+      pbus_root_i   => pbus_l1d_root,
+      pbus_flush_i  => pbus_l1d_flush,
+      pbus_trap_i   => pbus_l1d_trap,
+      pbus_fault_o  => l1d_pbus_fault,
+      pbus_fpage_o  => l1d_pbus_fpage,
+      pbus_fpc_o    => l1d_pbus_fpc);
   
   dbus : opa_dbus
     generic map(
@@ -771,6 +929,7 @@ begin
       l1d_dirty_i => l1d_dbus_dirty,
       l1d_data_i  => l1d_dbus_data,
       l1d_busy_o  => dbus_l1d_busy,
+      l1d_fill_o  => dbus_l1d_fill,
       l1d_we_o    => dbus_l1d_we,
       l1d_adr_o   => dbus_l1d_adr,
       l1d_valid_o => dbus_l1d_valid,
@@ -803,7 +962,14 @@ begin
       l1d_pop_i   => l1d_pbus_pop,
       l1d_full_o  => pbus_l1d_full,
       l1d_err_o   => pbus_l1d_err,
-      l1d_dat_o   => pbus_l1d_dat);
+      l1d_dat_o   => pbus_l1d_dat,
+      l1d_vm_o    => pbus_l1d_vm,
+      l1d_root_o  => pbus_l1d_root,
+      l1d_flush_o => pbus_l1d_flush,
+      l1d_trap_o  => pbus_l1d_trap,
+      l1d_fault_i => l1d_pbus_fault,
+      l1d_fpage_i => l1d_pbus_fpage,
+      l1d_fpc_i   => l1d_pbus_fpc);
   
   status_o <= issue_regfile_rstb;
 
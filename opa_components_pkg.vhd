@@ -100,14 +100,46 @@ package opa_components_pkg is
       g_wide   : natural;
       g_regout : boolean;
       g_regwal : boolean;
+      g_split  : boolean;
       g_target : t_opa_target);
     port(
       clk_i    : in  std_logic;
+      sexta_i  : in  std_logic;
+      sextb_i  : in  std_logic;
       a_i      : in  std_logic_vector(  g_wide-1 downto 0);
       b_i      : in  std_logic_vector(  g_wide-1 downto 0);
       x_o      : out std_logic_vector(2*g_wide-1 downto 0));
   end component;
   
+  component opa_prim_div is
+    generic(
+      g_wide   : natural);
+    port(
+      clk_i    : in  std_logic;
+      rst_n_i  : in  std_logic;
+      stb_i    : in  std_logic;
+      old_i    : in  std_logic;
+      sign_i   : in  std_logic;
+      a_i      : in  std_logic_vector(g_wide-1 downto 0);
+      b_i      : in  std_logic_vector(g_wide-1 downto 0);
+      done_o   : out std_logic;
+      q_o      : out std_logic_vector(g_wide-1 downto 0);
+      r_o      : out std_logic_vector(g_wide-1 downto 0));
+  end component;
+  
+  component opa_prim_fpu is
+    generic(
+      g_target : t_opa_target);
+    port(
+      clk_i    : in  std_logic;
+      op_i     : in  std_logic_vector(2 downto 0);
+      fn_i     : in  std_logic_vector(1 downto 0);
+      rm_i     : in  std_logic_vector(2 downto 0);
+      a_i      : in  std_logic_vector(31 downto 0);
+      b_i      : in  std_logic_vector(31 downto 0);
+      x_o      : out std_logic_vector(31 downto 0));
+  end component;
+  
   component opa_prefixsum is
     generic(
       g_target  : t_opa_target;
@@ -223,13 +255,16 @@ package opa_components_pkg is
       rename_fast_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_slow_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_order_o : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      rename_safe_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      rename_long_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_setx_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      rename_move_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_geta_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_getb_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_aux_o   : out std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
-      rename_archx_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
-      rename_archa_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
-      rename_archb_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
+      rename_archx_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
+      rename_archa_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
+      rename_archb_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
 
       -- Accept faults
       rename_fault_i : in  std_logic;
@@ -237,6 +272,12 @@ package opa_components_pkg is
       rename_pcf_i   : in  std_logic_vector(f_opa_fet_wide(g_config)-1 downto 0);
       rename_pcn_i   : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       
+      -- Loads which ran ahead of an aliased store, or read I/O before they were oldest
+      l1d_wait_i     : in  std_logic;
+      l1d_pc_i       : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+      l1d_io_i       : in  std_logic;
+      l1d_iopc_i     : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+      
       -- Give the regfile the information EUs will need for these operations
       regfile_stb_o  : out std_logic;
       regfile_aux_o  : out std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
@@ -262,20 +303,26 @@ package opa_components_pkg is
       decode_fast_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       decode_slow_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       decode_order_i : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      decode_safe_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      decode_long_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       decode_setx_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      decode_move_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       decode_geta_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       decode_getb_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       decode_aux_i   : in  std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
-      decode_archx_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
-      decode_archa_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
-      decode_archb_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
+      decode_archx_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
+      decode_archa_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
+      decode_archb_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
       
       -- Values we provide to the issuer
       issue_stb_o    : out std_logic;
       issue_stall_i  : in  std_logic;
+      issue_drain_i  : in  std_logic;
       issue_fast_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       issue_slow_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       issue_order_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      issue_safe_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      issue_long_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       issue_geta_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       issue_getb_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       issue_aux_o    : out std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
@@ -288,6 +335,8 @@ package opa_components_pkg is
       
       -- Feed faults back up the pipeline
       issue_fault_i  : in  std_logic;
+      issue_resume_i : in  std_logic;
+      issue_redir_i  : in  std_logic;
       issue_mask_i   : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       issue_pc_i     : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       issue_pcf_i    : in  std_logic_vector(f_opa_fet_wide(g_config)-1 downto 0);
@@ -310,9 +359,12 @@ package opa_components_pkg is
       -- Values the renamer provides us
       rename_stb_i   : in  std_logic;
       rename_stall_o : out std_logic;
+      rename_drain_o : out std_logic;
       rename_fast_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_slow_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_order_i : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      rename_safe_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+      rename_long_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_geta_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_getb_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_aux_i   : in  std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
@@ -327,12 +379,15 @@ package opa_components_pkg is
       eu_oldest_o    : out std_logic_vector(f_opa_executers(g_config)-1 downto 0);
       eu_retry_i     : in  std_logic_vector(f_opa_executers(g_config)-1 downto 0);
       eu_fault_i     : in  std_logic_vector(f_opa_executers(g_config)-1 downto 0);
+      eu_redir_i     : in  std_logic_vector(f_opa_executers(g_config)-1 downto 0);
       eu_pc_i        : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       eu_pcf_i       : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_fet_wide(g_config)-1 downto 0);
       eu_pcn_i       : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       
       -- Selected fault fed back up pipeline
       rename_fault_o : out std_logic;
+      rename_resume_o: out std_logic;
+      rename_redir_o : out std_logic;
       rename_mask_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
       rename_pc_o    : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       rename_pcf_o   : out std_logic_vector(f_opa_fet_wide(g_config)-1 downto 0);
@@ -346,6 +401,8 @@ package opa_components_pkg is
       regfile_dec_o  : out t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_ren_wide (g_config)-1 downto 0);
       regfile_baka_o : out t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide(g_isa,g_config)-1 downto 0);
       regfile_bakb_o : out t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide(g_isa,g_config)-1 downto 0);
+      regfile_long_o : out std_logic_vector(f_opa_executers(g_config)-1 downto 0);
+      regfile_stat_o : out t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_stat_wide(g_config)-1 downto 0);
       
       -- Regfile should capture result from EU
       regfile_wstb_o : out std_logic_vector(f_opa_executers(g_config)-1 downto 0);
@@ -354,10 +411,11 @@ package opa_components_pkg is
       -- Gather information from L1d about aliased loads
       l1d_store_i    : in  std_logic;
       l1d_load_i     : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
-      l1d_addr_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_alias_high(g_isa) downto f_opa_alias_low(g_config));
-      l1d_mask_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)/8-1 downto 0));
+      l1d_addr_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_alias_high(g_isa,g_config) downto f_opa_alias_low(g_config));
+      l1d_mask_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)/8-1 downto 0);
+      l1d_alias_o    : out std_logic);
   end component;
-  
+
   component opa_regfile is
     generic(
       g_isa    : t_opa_isa;
@@ -384,6 +442,8 @@ package opa_components_pkg is
       issue_dec_i  : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_ren_wide  (g_config)-1 downto 0);
       issue_baka_i : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide (g_isa,g_config)-1 downto 0);
       issue_bakb_i : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide (g_isa,g_config)-1 downto 0);
+      issue_long_i : in  std_logic_vector(f_opa_executers(g_config)-1 downto 0); -- result one cycle late
+      issue_stat_i : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_stat_wide (g_config)-1 downto 0); -- lower is older
       
       -- Feed the EUs one cycle later (they register this => result is two cycles later)
       eu_stb_o     : out std_logic_vector(f_opa_executers(g_config)-1 downto 0);
@@ -400,7 +460,8 @@ package opa_components_pkg is
       issue_bakx_i : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide(g_isa,g_config)-1 downto 0);
       
       -- The results arrive two cycles after the issue said they would
-      eu_regx_i    : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0));
+      eu_regx_i    : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0);
+      issue_retry_o : out std_logic_vector(f_opa_executers(g_config)-1 downto 0));
   end component;
   
   component opa_fast is
@@ -425,6 +486,7 @@ package opa_components_pkg is
       issue_oldest_i : in  std_logic;
       issue_retry_o  : out std_logic;
       issue_fault_o  : out std_logic;
+      issue_redir_o  : out std_logic;
       issue_pc_o     : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       issue_pcf_o    : out std_logic_vector(f_opa_fet_wide(g_config)-1 downto 0);
       issue_pcn_o    : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa)));
@@ -453,10 +515,14 @@ package opa_components_pkg is
       l1d_we_o       : out std_logic;
       l1d_sext_o     : out std_logic;
       l1d_size_o     : out std_logic_vector(1 downto 0);
+      l1d_pref_o     : out std_logic;
+      l1d_pc_o       : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       l1d_addr_o     : out std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0);
       l1d_data_o     : out std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0);
       l1d_oldest_o   : out std_logic; -- delivered 1 cycle after stb
       l1d_retry_i    : in  std_logic; -- valid 1 cycle after stb_o 
+      l1d_fault_i    : in  std_logic; -- valid 1 cycle after stb_o
+      l1d_trap_i     : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       l1d_data_i     : in  std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0); -- 2 cycles
       
       issue_oldest_i : in  std_logic;
@@ -473,7 +539,6 @@ package opa_components_pkg is
     OPA_DBUS_WAIT_STORE_LOAD,
     OPA_DBUS_STORE_LOAD, -- request forbidden
     OPA_DBUS_LOAD_STORE,
-    OPA_DBUS_WAIT_LOAD,
     OPA_DBUS_WAIT_STORE,
     OPA_DBUS_LOAD,
     OPA_DBUS_STORE);     -- request forbidden
@@ -492,17 +557,28 @@ package opa_components_pkg is
       slow_we_i     : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
       slow_sext_i   : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
       slow_size_i   : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, 1 downto 0);
+      slow_pref_i   : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
+      slow_pc_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       slow_addr_i   : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0);
       slow_data_i   : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0);
       slow_oldest_i : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
       slow_retry_o  : out std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
+      slow_fault_o  : out std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
+      slow_trap_o   : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       slow_data_o   : out t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0);
       
       -- Share information about the addresses we are loading/storing
       issue_store_o : out std_logic;
       issue_load_o  : out std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
-      issue_addr_o  : out t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_alias_high(g_isa) downto f_opa_alias_low(g_config));
+      issue_addr_o  : out t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_alias_high(g_isa,g_config) downto f_opa_alias_low(g_config));
       issue_mask_o  : out t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)/8-1 downto 0);
+      issue_alias_i : in  std_logic;
+      
+      -- Train decode with loads that ran ahead of an aliased store or read I/O early
+      decode_wait_o : out std_logic;
+      decode_pc_o   : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+      decode_io_o   : out std_logic;
+      decode_iopc_o : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       
       -- L1d requests action
       dbus_req_o    : out t_opa_dbus_request;
@@ -513,6 +589,7 @@ package opa_components_pkg is
       dbus_data_o   : out std_logic_vector(f_opa_dline_size(g_config)*8-1 downto 0);
       
       dbus_busy_i   : in  std_logic; -- can accept a req_i
+      dbus_fill_i   : in  std_logic; -- busy only with the line at dbus_adr_i
       dbus_we_i     : in  std_logic_vector(f_opa_num_dway  (g_config)  -1 downto 0);
       dbus_adr_i    : in  std_logic_vector(f_opa_adr_wide  (g_config)  -1 downto 0);
       dbus_valid_i  : in  std_logic_vector(f_opa_dline_size(g_config)  -1 downto 0);
@@ -528,7 +605,17 @@ package opa_components_pkg is
       pbus_pop_o    : out std_logic;
       pbus_full_i   : in  std_logic;
       pbus_err_i    : in  std_logic;
-      pbus_dat_i    : in  std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0));
+      pbus_dat_i    : in  std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0);
+      
+      pbus_vm_i     : in  std_logic;
+      pbus_root_i   : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+      pbus_flush_i  : in  std_logic;
+      pbus_trap_i   : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+      
+      -- The oldest op took a page fault
+      pbus_fault_o  : out std_logic;
+      pbus_fpage_o  : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+      pbus_fpc_o    : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa)));
   end component;
 
   component opa_dbus is
@@ -560,6 +647,7 @@ package opa_components_pkg is
       l1d_data_i  : in  std_logic_vector(f_opa_dline_size(g_config)*8-1 downto 0);
       
       l1d_busy_o  : out std_logic; -- can accept a req_i
+      l1d_fill_o  : out std_logic; -- busy only with the line at l1d_adr_o
       l1d_we_o    : out std_logic_vector(f_opa_num_dway  (g_config)  -1 downto 0);
       l1d_adr_o   : out std_logic_vector(f_opa_adr_wide  (g_config)  -1 downto 0);
       l1d_valid_o : out std_logic_vector(f_opa_dline_size(g_config)  -1 downto 0);
@@ -597,7 +685,17 @@ package opa_components_pkg is
       l1d_pop_i   : in  std_logic;
       l1d_full_o  : out std_logic;
       l1d_err_o   : out std_logic;
-      l1d_dat_o   : out std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0));
+      l1d_dat_o   : out std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0);
+      
+      l1d_vm_o    : out std_logic;
+      l1d_root_o  : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+      l1d_flush_o : out std_logic;
+      l1d_trap_o  : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+      
+      -- Page faults are recorded for the handler
+      l1d_fault_i : in  std_logic;
+      l1d_fpage_i : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+      l1d_fpc_i   : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa)));
   end component;
 
 end package;
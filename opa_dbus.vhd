@@ -64,6 +64,7 @@ entity opa_dbus is
     l1d_data_i  : in  std_logic_vector(f_opa_dline_size(g_config)*8-1 downto 0);
     
     l1d_busy_o  : out std_logic; -- can accept a req_i
+    l1d_fill_o  : out std_logic; -- busy only with the line at l1d_adr_o
     l1d_we_o    : out std_logic_vector(f_opa_num_dway  (g_config)  -1 downto 0);
     l1d_adr_o   : out std_logic_vector(f_opa_adr_wide  (g_config)  -1 downto 0);
     l1d_valid_o : out std_logic_vector(f_opa_dline_size(g_config)  -1 downto 0);
@@ -79,6 +80,7 @@ architecture rtl of opa_dbus is
   constant c_adr_wide : natural := f_opa_adr_wide(g_config);
   constant c_num_slow : natural := f_opa_num_slow(g_config);
   constant c_num_dway : natural := f_opa_num_dway(g_config);
+  constant c_num_mshr : natural := g_config.num_mshr;
   
   constant c_idx_low    : natural := f_opa_log2(c_reg_wide/8);
   constant c_idx_high   : natural := f_opa_log2(c_dline_size);
@@ -92,6 +94,9 @@ architecture rtl of opa_dbus is
   signal r_cyc      : std_logic := '0';
   signal r_stb      : std_logic := '0';
   signal r_we       : std_logic := '1'; -- May only be '0' if r_cyc='1'
+  signal r_ack_we   : std_logic := '1'; -- Is the burst being acked a write?
+  signal s_rack     : std_logic;
+  signal s_done     : std_logic;
   signal r_idle1    : std_logic; -- was idle last cycle?
   signal s_sel      : std_logic_vector(c_reg_wide/8-1 downto 0);
   signal r_sel      : std_logic_vector(c_reg_wide/8-1 downto 0);
@@ -119,6 +124,10 @@ architecture rtl of opa_dbus is
   signal s_dirty_mux: std_logic_vector(c_dline_size-1 downto 0);
   signal s_storeline_mux : std_logic_vector(c_dline_size*8-1 downto 0);
   signal s_wadr_mux : std_logic_vector(c_adr_wide-1 downto 0);
+  signal s_req      : t_opa_dbus_request;
+  signal s_radr     : std_logic_vector(c_adr_wide-1 downto 0);
+  signal s_rway     : std_logic_vector(c_num_dway-1 downto 0);
+  signal s_pending  : std_logic;
 
 begin
 
@@ -133,7 +142,7 @@ begin
           r_radr(c_ones'high downto c_ones'low)
             <= std_logic_vector(unsigned(r_radr(c_ones'high downto c_ones'low)) + 1);
         when OPA_DBUS_IDLE =>
-          r_radr <= l1d_radr_i;
+          r_radr <= s_radr;
         when others =>
           r_radr <= r_radr;
       end case;
@@ -144,11 +153,119 @@ begin
   begin
     if rising_edge(clk_i) then
       if r_state = OPA_DBUS_IDLE then
-        r_way <= l1d_way_i;
+        r_way <= s_rway;
       end if;
     end if;
   end process;
   
+  -- Clean line fills which arrive while we are busy wait in the MSHRs.
+  -- The L1d keeps serving hits meanwhile, and the missing loads retry until
+  -- their line is filled. Requests with a dirty victim are not queued.
+  -- Each fill reserves its victim way (the L1d blocks stores until the queue
+  -- is empty, so it stays clean). A request whose victim is already reserved
+  -- by the active or a queued fill is dropped, so one fill never evicts the
+  -- line another just brought in; that load retries and picks again.
+  mshr : if c_num_mshr > 0 generate
+    b : block is
+      type t_adr is array(natural range <>) of std_logic_vector(c_adr_wide-1 downto 0);
+      type t_way is array(natural range <>) of std_logic_vector(c_num_dway-1 downto 0);
+      
+      signal r_valid : std_logic_vector(c_num_mshr-1 downto 0) := (others => '0');
+      signal r_madr  : t_adr(c_num_mshr-1 downto 0);
+      signal r_mway  : t_way(c_num_mshr-1 downto 0);
+      signal s_hit   : std_logic_vector(c_num_mshr downto 0);
+      signal s_clash : std_logic_vector(c_num_mshr downto 0);
+      signal s_busy  : std_logic;
+      signal s_pop   : std_logic;
+      signal s_push  : std_logic;
+    begin
+      -- Is the line already being filled or waiting to be filled?
+      s_busy <= not f_opa_bit(r_state = OPA_DBUS_IDLE or r_state = OPA_DBUS_WIPE);
+      s_hit(c_num_mshr) <= s_busy and 
+        f_opa_eq(r_radr(c_adr_wide-1 downto c_idx_high), l1d_radr_i(c_adr_wide-1 downto c_idx_high));
+      hits : for i in 0 to c_num_mshr-1 generate
+        s_hit(i) <= r_valid(i) and 
+          f_opa_eq(r_madr(i)(c_adr_wide-1 downto c_idx_high), l1d_radr_i(c_adr_wide-1 downto c_idx_high));
+      end generate;
+      
+      -- Would the request replace a way some other fill has reserved?
+      s_clash(c_num_mshr) <= s_busy and f_opa_or(r_way and l1d_way_i) and
+        f_opa_eq(r_radr(c_ones'range), l1d_radr_i(c_ones'range));
+      clashes : for i in 0 to c_num_mshr-1 generate
+        s_clash(i) <= r_valid(i) and f_opa_or(r_mway(i) and l1d_way_i) and
+          f_opa_eq(r_madr(i)(c_ones'range), l1d_radr_i(c_ones'range));
+      end generate;
+      
+      s_pending <= r_valid(0);
+      s_pop  <= f_opa_bit(r_state = OPA_DBUS_IDLE) and r_valid(0);
+      s_push <= f_opa_bit(l1d_req_i = OPA_DBUS_LOAD) and (s_busy or r_valid(0)) 
+                and not f_opa_or(s_hit) and not f_opa_or(s_clash) and not r_valid(c_num_mshr-1);
+      
+      -- Oldest miss is at the bottom of the queue
+      s_req  <= OPA_DBUS_LOAD when r_valid(0) = '1' else l1d_req_i;
+      s_radr <= r_madr(0)     when r_valid(0) = '1' else l1d_radr_i;
+      s_rway <= r_mway(0)     when r_valid(0) = '1' else l1d_way_i;
+      
+      control : process(clk_i, rst_n_i) is
+        variable v_valid : std_logic_vector(c_num_mshr downto 0);
+        variable v_done  : boolean;
+      begin
+        if rst_n_i = '0' then
+          r_valid <= (others => '0');
+        elsif rising_edge(clk_i) then
+          v_valid := '0' & r_valid;
+          if s_pop = '1' then
+            v_valid := '0' & v_valid(c_num_mshr downto 1);
+          end if;
+          v_done := false;
+          for i in 0 to c_num_mshr-1 loop
+            if not v_done and v_valid(i) = '0' then
+              v_valid(i) := s_push;
+              v_done := true;
+            end if;
+          end loop;
+          r_valid <= v_valid(r_valid'range);
+        end if;
+      end process;
+      
+      main : process(clk_i) is
+        variable v_madr : t_adr(c_num_mshr downto 0);
+        variable v_mway : t_way(c_num_mshr downto 0);
+        variable v_free : std_logic_vector(c_num_mshr downto 0);
+        variable v_done : boolean;
+      begin
+        if rising_edge(clk_i) then
+          v_madr := (others => (others => '-'));
+          v_mway := (others => (others => '-'));
+          v_madr(r_madr'range) := r_madr;
+          v_mway(r_mway'range) := r_mway;
+          v_free := '1' & not r_valid;
+          if s_pop = '1' then
+            v_madr(r_madr'range) := v_madr(c_num_mshr downto 1);
+            v_mway(r_mway'range) := v_mway(c_num_mshr downto 1);
+            v_free := '1' & v_free(c_num_mshr downto 1);
+          end if;
+          v_done := false;
+          for i in 0 to c_num_mshr-1 loop
+            if not v_done and v_free(i) = '1' then
+              v_madr(i) := l1d_radr_i;
+              v_mway(i) := l1d_way_i;
+              v_done := true;
+            end if;
+          end loop;
+          r_madr <= v_madr(r_madr'range);
+          r_mway <= v_mway(r_mway'range);
+        end if;
+      end process;
+    end block;
+  end generate;
+  nomshr : if c_num_mshr = 0 generate
+    s_pending <= '0';
+    s_req     <= l1d_req_i;
+    s_radr    <= l1d_radr_i;
+    s_rway    <= l1d_way_i;
+  end generate;
+  
   count : if c_line_words > 1 generate
     b : block is
       signal r_out : unsigned(c_idx_wide-1 downto 0);
@@ -171,24 +288,33 @@ begin
         end if;
       end process;
       
-      s_last_ack <= d_ack_i       and f_opa_eq(r_in,  c_line_words-1);
-      s_last_stb <= not d_stall_i and f_opa_eq(r_out, c_line_words-1);
+      s_last_ack <= d_ack_i                 and f_opa_eq(r_in,  c_line_words-1);
+      s_last_stb <= r_stb and not d_stall_i and f_opa_eq(r_out, c_line_words-1);
     end block;
   end generate;
   nocount : if c_line_words = 1 generate
     s_last_ack <= d_ack_i;
-    s_last_stb <= not d_stall_i;
+    s_last_stb <= r_stb and not d_stall_i;
   end generate;
   
+  -- A bus cycle carries at most two back-to-back bursts: the fill and the
+  -- writeback of its dirty victim. The second burst is strobed as soon as
+  -- the first has been accepted, so both are outstanding at once. Acks
+  -- return in order, and r_ack_we flips after the last ack of each burst.
+  s_rack <= d_ack_i and not r_ack_we;
+  s_done <= s_last_ack and (r_ack_we xnor r_we);
+  
   fsm : process(clk_i, rst_n_i) is
   begin
     if rst_n_i = '0' then
-      r_state <= OPA_DBUS_WIPE;
-      r_cyc   <= '0';
-      r_stb   <= '0';
-      r_we    <= '1';
-      r_sel   <= (others => '-');
+      r_state  <= OPA_DBUS_WIPE;
+      r_cyc    <= '0';
+      r_stb    <= '0';
+      r_we     <= '1';
+      r_ack_we <= '1';
+      r_sel    <= (others => '-');
     elsif rising_edge(clk_i) then
+      r_ack_we <= r_ack_we xor s_last_ack;
       case r_state is
         when OPA_DBUS_WIPE =>
           if r_radr(c_ones'range) = c_ones then
@@ -201,9 +327,9 @@ begin
           r_we  <= '1';
           r_sel <= (others => '1');
         when OPA_DBUS_IDLE =>
-          r_state <= l1d_req_i;
+          r_state <= s_req;
           r_sel   <= (others => '1');
-          case l1d_req_i is
+          case s_req is
             when OPA_DBUS_IDLE =>
               r_cyc <= '0';
               r_stb <= '0';
@@ -213,61 +339,55 @@ begin
               r_stb <= '0';
               r_we  <= '1';
             when OPA_DBUS_LOAD_STORE | OPA_DBUS_LOAD =>
-              r_cyc <= '1';
-              r_stb <= '1';
-              r_we  <= '0';
+              r_cyc    <= '1';
+              r_stb    <= '1';
+              r_we     <= '0';
+              r_ack_we <= '0';
             when others => -- impossible cases
               r_cyc <= '-';
               r_stb <= '-';
               r_we  <= '-';
           end case;
-        when OPA_DBUS_WAIT_STORE_LOAD =>
-          r_state <= OPA_DBUS_STORE_LOAD;
-          r_cyc   <= '1';
-          r_stb   <= '1';
-          r_we    <= '1';
-          r_sel   <= s_sel;
+        when OPA_DBUS_WAIT_STORE_LOAD | OPA_DBUS_WAIT_STORE =>
+          if r_state = OPA_DBUS_WAIT_STORE_LOAD then
+            r_state <= OPA_DBUS_STORE_LOAD;
+          else
+            r_state <= OPA_DBUS_STORE;
+          end if;
+          r_cyc    <= '1';
+          r_stb    <= '1';
+          r_we     <= '1';
+          r_ack_we <= '1';
+          r_sel    <= s_sel;
         when OPA_DBUS_STORE_LOAD =>
-          r_stb <= r_stb and not s_last_stb;
-          if s_last_ack = '1' then
-            r_state <= OPA_DBUS_WAIT_LOAD;
-            r_cyc   <= '0';
-            r_we    <= '1';
-            r_sel   <= (others => '-');
+          -- Write back the dirty line, then strobe the fill right behind it
+          r_cyc <= '1';
+          r_stb <= '1';
+          if s_last_stb = '1' then
+            r_state <= OPA_DBUS_LOAD;
+            r_we    <= '0';
+            r_sel   <= (others => '1');
           else
             r_state <= OPA_DBUS_STORE_LOAD;
-            r_cyc   <= '1';
             r_we    <= '1';
             r_sel   <= s_sel;
           end if;
         when OPA_DBUS_LOAD_STORE =>
-          r_stb <= r_stb and not s_last_stb;
-          if s_last_ack = '1' then
-            r_state <= OPA_DBUS_WAIT_STORE;
-            r_cyc   <= '0';
+          -- Fill first; the victim waits in r_storeline until the fill is strobed
+          r_cyc <= '1';
+          r_stb <= '1';
+          if s_last_stb = '1' then
+            r_state <= OPA_DBUS_STORE;
             r_we    <= '1';
-            r_sel   <= (others => '-');
+            r_sel   <= s_sel;
           else
             r_state <= OPA_DBUS_LOAD_STORE;
-            r_cyc   <= '1';
             r_we    <= '0';
             r_sel   <= (others => '1');
           end if;
-        when OPA_DBUS_WAIT_LOAD =>
-          r_state <= OPA_DBUS_LOAD;
-          r_cyc   <= '1';
-          r_stb   <= '1';
-          r_we    <= '0';
-          r_sel   <= (others => '1');
-        when OPA_DBUS_WAIT_STORE =>
-          r_state <= OPA_DBUS_STORE;
-          r_cyc   <= '1';
-          r_stb   <= '1';
-          r_we    <= '1';
-          r_sel   <= s_sel;
         when OPA_DBUS_LOAD =>
           r_stb <= r_stb and not s_last_stb;
-          if s_last_ack = '1' then
+          if s_done = '1' then
             r_state <= OPA_DBUS_IDLE;
             r_cyc   <= '0';
             r_we    <= '1';
@@ -280,7 +400,7 @@ begin
           end if;
         when OPA_DBUS_STORE =>
           r_stb <= r_stb and not s_last_stb;
-          if s_last_ack = '1' then
+          if s_done = '1' then
             r_state <= OPA_DBUS_IDLE;
             r_cyc   <= '0';
             r_we    <= '1';
@@ -299,13 +419,13 @@ begin
     load_big : if c_big_endian generate
       s_loadat <= std_logic_vector(rotate_right(unsigned(r_loadat), 1));
       onehot : for i in 0 to c_line_words-1 generate
-        s_loadat_in(i) <= f_opa_eq(unsigned(l1d_radr_i(c_idx_high-1 downto c_idx_low)), (c_line_words-1)-i);
+        s_loadat_in(i) <= f_opa_eq(unsigned(s_radr(c_idx_high-1 downto c_idx_low)), (c_line_words-1)-i);
       end generate;
     end generate;
     load_small : if not c_big_endian generate
       s_loadat <= std_logic_vector(rotate_left(unsigned(r_loadat), 1));
       onehot : for i in 0 to c_line_words-1 generate
-        s_loadat_in(i) <= f_opa_eq(unsigned(l1d_radr_i(c_idx_high-1 downto c_idx_low)), i);
+        s_loadat_in(i) <= f_opa_eq(unsigned(s_radr(c_idx_high-1 downto c_idx_low)), i);
       end generate;
     end generate;
   end generate;
@@ -333,8 +453,7 @@ begin
           -- does not matter if this rotates also on writes => complete rotation before read
           r_loadat <= s_loadat;
         end if;
-        if (not r_we and d_ack_i) = '1' then
-          -- need to be more careful here; note: r_we=0 implies r_cyc=1
+        if s_rack = '1' then
           r_loaded <= r_loaded or s_loadat;
         end if;
       end if;
@@ -350,9 +469,7 @@ begin
     if rising_edge(clk_i) then
       if r_state = OPA_DBUS_WIPE then
         r_loadline <= (others => '0');
-      elsif d_ack_i = '1' then
-        -- ack only needs to be '1' at the correct times during a load cycle
-        -- any garbage accepted will just get overwritten => harmless
+      elsif s_rack = '1' then
         r_loadline <= s_loadline;
       end if;
     end if;
@@ -365,14 +482,16 @@ begin
         when OPA_DBUS_WIPE =>
           r_adr <= (others => '-');
         when OPA_DBUS_IDLE =>
-          r_adr(l1d_radr_i'range) <= l1d_radr_i;
+          r_adr(s_radr'range) <= s_radr;
         when OPA_DBUS_WAIT_STORE_LOAD | OPA_DBUS_WAIT_STORE =>
           r_adr(r_wadr'range) <= s_wadr_mux;
-        when OPA_DBUS_WAIT_LOAD =>
-          r_adr(r_radr'range) <= r_radr;
         when OPA_DBUS_STORE_LOAD | OPA_DBUS_LOAD_STORE | OPA_DBUS_LOAD | OPA_DBUS_STORE =>
           r_adr <= r_adr;
-          if d_stall_i = '0' and c_line_words > 1 then -- next output address
+          if s_last_stb = '1' and r_state = OPA_DBUS_STORE_LOAD then
+            r_adr(r_radr'range) <= r_radr;
+          elsif s_last_stb = '1' and r_state = OPA_DBUS_LOAD_STORE then
+            r_adr(r_wadr'range) <= s_wadr_mux;
+          elsif d_stall_i = '0' and c_line_words > 1 then -- next output address
             r_adr(c_idx_high-1 downto c_idx_low) <= 
               std_logic_vector(unsigned(r_adr(c_idx_high-1 downto c_idx_low)) + 1);
           end if;
@@ -394,13 +513,15 @@ begin
   end generate;
   
   -- Need this bypass to setup r_sel and r_adr
+  -- The victim is captured the cycle after the request and only rotates on
+  -- accepted write beats, so it waits intact while its fill is strobed.
   s_dirty_mux <= 
-    s_dirty     when (r_stb and not d_stall_i) = '1' else 
-    l1d_dirty_i when r_idle1                   = '1' else
+    s_dirty     when (r_stb and r_we and not d_stall_i) = '1' else 
+    l1d_dirty_i when r_idle1                            = '1' else
     r_dirty;
   s_storeline_mux <=
-    s_storeline when (r_stb and not d_stall_i) = '1' else
-    l1d_data_i  when r_idle1                   = '1' else
+    s_storeline when (r_stb and r_we and not d_stall_i) = '1' else
+    l1d_data_i  when r_idle1                            = '1' else
     r_storeline;
   s_wadr_mux <= l1d_wadr_i when r_idle1 = '1' else r_wadr;
   
@@ -421,8 +542,11 @@ begin
   d_sel_o  <= r_sel;
   d_data_o <= s_lineout;
   
-  l1d_busy_o  <= not f_opa_bit(r_state = OPA_DBUS_IDLE);
-  s_way_ack   <= (others => d_ack_i and not r_we);
+  -- Busy for the current line alone (no wipe, no queued misses) leaves the L1d
+  -- write port free whenever l1d_we_o is low, except for that line's set
+  l1d_busy_o  <= not f_opa_bit(r_state = OPA_DBUS_IDLE) or s_pending;
+  l1d_fill_o  <= not f_opa_bit(r_state = OPA_DBUS_IDLE or r_state = OPA_DBUS_WIPE) and not s_pending;
+  s_way_ack   <= (others => s_rack);
   s_wipe      <= (others => f_opa_bit(r_state = OPA_DBUS_WIPE));
   l1d_we_o    <= (r_way and s_way_ack) or s_wipe;
   l1d_adr_o   <= r_radr(l1d_adr_o'range);
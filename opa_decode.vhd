@@ -74,13 +74,16 @@ entity opa_decode is
     rename_fast_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_slow_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_order_o : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    rename_safe_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    rename_long_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_setx_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    rename_move_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_geta_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_getb_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_aux_o   : out std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
-    rename_archx_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
-    rename_archa_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
-    rename_archb_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
+    rename_archx_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
+    rename_archa_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
+    rename_archb_o : out t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
 
     -- Accept faults
     rename_fault_i : in  std_logic;
@@ -88,6 +91,12 @@ entity opa_decode is
     rename_pcf_i   : in  std_logic_vector(f_opa_fet_wide(g_config)-1 downto 0);
     rename_pcn_i   : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     
+    -- Loads which ran ahead of an aliased store, or read I/O before they were oldest
+    l1d_wait_i     : in  std_logic;
+    l1d_pc_i       : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+    l1d_io_i       : in  std_logic;
+    l1d_iopc_i     : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+    
     -- Give the regfile the information EUs will need for these operations
     regfile_stb_o  : out std_logic;
     regfile_aux_o  : out std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
@@ -104,16 +113,20 @@ architecture rtl of opa_decode is
   constant c_op_align : natural := f_opa_op_align(g_isa);
   constant c_op_wide  : natural := f_opa_op_wide (g_isa);
   constant c_imm_wide : natural := f_opa_imm_wide(g_isa);
-  constant c_arch_wide: natural := f_opa_arch_wide(g_isa);
+  constant c_arch_wide: natural := f_opa_arch_wide(g_isa,g_config);
   constant c_fetchers : natural := f_opa_fetchers(g_config);
   constant c_renamers : natural := f_opa_renamers(g_config);
-  constant c_buffers  : natural := c_fetchers + 2*c_renamers - 1;
+  constant c_buffers  : natural := g_config.dq_size;
   constant c_num_aux  : natural := f_opa_num_aux (g_config);
   constant c_adr_wide : natural := f_opa_adr_wide(g_config);
   constant c_fet_wide : natural := f_opa_fet_wide(g_config);
   constant c_buf_wide : natural := f_opa_log2(c_buffers+1); -- [0, c_buffers] inclusive
   constant c_aux_wide : natural := f_opa_aux_wide(g_config);
   constant c_fetch_align : natural := f_opa_fetch_align(g_isa,g_config);
+  constant c_stat_period : natural := 65536; -- cycles between occupancy reports (simulation only)
+  constant c_lwt_size : natural := g_config.lwt_size;
+  constant c_fin_ready: std_logic := f_opa_bit(g_config.fin_ready);
+  constant c_fast_shift:boolean := g_config.fast_shift;
   
   constant c_min_imm_pc : natural := f_opa_choose(c_imm_wide<c_adr_wide, c_imm_wide, c_adr_wide);
   
@@ -121,6 +134,81 @@ architecture rtl of opa_decode is
   type t_pc_array  is array(natural range <>) of std_logic_vector(c_adr_wide-1 downto c_op_align);
   type t_pcf_array is array(natural range <>) of std_logic_vector(c_fet_wide-1 downto 0);
   
+  type t_raw_array is array(natural range <>) of std_logic_vector(c_op_wide-1 downto 0);
+  type t_cidx_array is array(natural range <>) of unsigned(c_fet_wide-1 downto 0);
+  
+  -- An op absorbed by its predecessor must not look like a jump
+  function f_squash(x : t_opa_op) return t_opa_op is
+    variable result : t_opa_op := x;
+  begin
+    result.jump  := '0';
+    result.take  := '0';
+    result.force := '0';
+    result.pop   := '0';
+    result.push  := '0';
+    return result;
+  end f_squash;
+  
+  -- With fast_shift, the fast EUs take shifts and sign extension off the slow EUs
+  function f_fast_shift(x : t_opa_op) return t_opa_op is
+    variable result : t_opa_op := x;
+  begin
+    if c_fast_shift and x.fast = '0' then
+      if f_opa_eq(x.arg.smode, c_opa_slow_shift) = '1' then
+        result.fast      := '1';
+        result.arg.fmode := c_opa_fast_shift;
+      end if;
+      if f_opa_eq(x.arg.smode, c_opa_slow_sext) = '1' then
+        result.fast      := '1';
+        result.arg.fmode := c_opa_fast_sext;
+      end if;
+    end if;
+    return result;
+  end f_fast_shift;
+  
+  -- The result is operand a unchanged: addi rd, rs, 0 (mv, li 0) and or rd, rs, r0 (LM32 mv).
+  -- The latter relies on r0 reading as zero, which both ISAs' ABIs guarantee.
+  function f_move(x : t_opa_op) return std_logic is
+    variable addi : std_logic;
+    variable orr0 : std_logic;
+  begin
+    addi := f_opa_eq(x.arg.fmode, c_opa_fast_addl) and
+            not (x.arg.adder.eq or x.arg.adder.nota or x.arg.adder.notb or x.arg.adder.cin) and
+            not x.getb and not f_opa_or(x.imm(c_imm_wide-1 downto 0));
+    orr0 := f_opa_eq(x.arg.fmode, c_opa_fast_lut) and f_opa_eq(x.arg.lut, "1110") and
+            x.getb and not f_opa_or(x.archb(c_arch_wide-1 downto 0));
+    return x.fast and x.geta and x.setx and (addi or orr0);
+  end f_move;
+  
+  -- Only branches and jumps fault in a fast EU; only loads and stores retry in a slow EU.
+  -- Division is left out, so that it may iterate by retrying.
+  function f_safe(x : t_opa_op) return std_logic is
+    variable fast : std_logic;
+    variable slow : std_logic;
+  begin
+    fast := not f_opa_eq(x.arg.fmode, c_opa_fast_jump) and
+            not (f_opa_eq(x.arg.fmode, c_opa_fast_addh) and x.arg.adder.fault);
+    slow := (f_opa_eq(x.arg.smode, c_opa_slow_mul) and not x.arg.mul.divide) or
+            f_opa_eq(x.arg.smode, c_opa_slow_shift) or
+            f_opa_eq(x.arg.smode, c_opa_slow_sext) or
+            f_opa_eq(x.arg.smode, c_opa_slow_fp);
+    if ((x.fast and fast) or (not x.fast and slow)) = '1' then
+      return '1';
+    else
+      return '0'; -- including don't-care fields
+    end if;
+  end f_safe;
+  
+  -- Floating point results leave the slow EU one cycle late
+  function f_long(x : t_opa_op) return std_logic is
+  begin
+    if (not x.fast and f_opa_eq(x.arg.smode, c_opa_slow_fp)) = '1' then
+      return '1';
+    else
+      return '0';
+    end if;
+  end f_long;
+  
   function f_flip(x : natural) return natural is
   begin
     if c_big_endian then
@@ -131,6 +219,14 @@ architecture rtl of opa_decode is
   end f_flip;
 
   signal s_pc_off      : unsigned(c_fet_wide-1 downto 0);
+  signal s_raw_in      : t_raw_array(c_fetchers-1 downto 0);
+  signal s_dec_in      : t_op_array(c_fetchers-1 downto 0);
+  signal s_fuse_in     : t_op_array(c_fetchers-1 downto 0);
+  signal s_fuse        : std_logic_vector(c_fetchers-1 downto 0); -- op absorbs the next
+  signal s_kill        : std_logic_vector(c_fetchers-1 downto 0); -- op was absorbed
+  signal s_keep        : std_logic_vector(c_fetchers-1 downto 0); -- op enters the buffer
+  signal s_after       : std_logic_vector(c_fetchers-1 downto 0); -- op follows a taken jump
+  signal s_cidx        : t_cidx_array(c_fetchers-1 downto 0);     -- compacted fetch group
   signal s_ops_in      : t_op_array(c_fetchers-1 downto 0);
   signal s_pc_in       : t_pc_array(c_fetchers-1 downto 0);
   signal s_immb_in     : t_pc_array(c_fetchers-1 downto 0);
@@ -161,6 +257,7 @@ architecture rtl of opa_decode is
   signal s_pcn_taken  : std_logic_vector(c_adr_wide-1 downto c_op_align);
   signal r_pcn_taken  : std_logic_vector(c_adr_wide-1 downto c_op_align);
   signal s_jal_pc     : std_logic_vector(c_adr_wide-1 downto c_op_align);
+  signal s_jal_skip   : std_logic;
 
   signal s_ops      : t_op_array (c_buffers-1 downto 0);
   signal r_ops      : t_op_array (c_buffers-1 downto 0);
@@ -177,6 +274,8 @@ architecture rtl of opa_decode is
   signal s_ops_sub  : unsigned(c_fet_wide-1 downto 0);
   signal r_fill     : unsigned(c_buf_wide-1 downto 0) := (others => '0');
   signal r_aux      : unsigned(c_aux_wide-1 downto 0) := (others => '0');
+  signal s_wait     : std_logic_vector(c_renamers-1 downto 0);
+  signal s_io       : std_logic_vector(c_renamers-1 downto 0);
   
 begin
 
@@ -189,6 +288,8 @@ begin
       assert (f_opa_safe(icache_stb_i)     = '1') report "decode: icache_stb_i has metavalue" severity failure;
       assert (f_opa_safe(rename_stall_i)   = '1') report "decode: rename_stall_i has metavalue" severity failure;
       assert (f_opa_safe(rename_fault_i)   = '1') report "decode: rename_fault_i has metavalue" severity failure;
+      assert (f_opa_safe(l1d_wait_i)       = '1') report "decode: l1d_wait_i has metavalue" severity failure;
+      assert (f_opa_safe(l1d_io_i)         = '1') report "decode: l1d_io_i has metavalue" severity failure;
       -- combinatorial control (safe for when/if)
       assert (f_opa_safe(s_stall)      = '1') report "decode: s_stall has metavalue" severity failure;
       assert (f_opa_safe(s_stb)        = '1') report "decode: s_stb has metavalue" severity failure;
@@ -205,16 +306,37 @@ begin
   -- Decode the flow control information from the instructions
   off1p : if c_fetchers > 1 generate
     s_pc_off <= unsigned(icache_pc_i(c_fetch_align-1 downto c_op_align));
-    s_ops_sub <= unsigned(f_opa_1hot_dec(f_opa_reverse(s_jump_taken))) + s_pc_off;
   end generate;
   off1 : if c_fetchers = 1 generate
     s_pc_off  <= "0";
-    s_ops_sub <= "0";
+  end generate;
+  
+  -- Fuse adjacent pairs within the fetch group. The first op of a pair is never
+  -- the second op of another pair, so there is no chain to resolve.
+  fuse1p : if c_fetchers > 1 generate
+    pairs : for i in 0 to c_fetchers-2 generate
+      s_fuse_in(i) <= f_opa_isa_fuse(g_isa, g_config, s_raw_in(i), s_raw_in(i+1));
+      s_fuse(i) <= s_fuse_in(i).fuse and not s_mask_skip(i);
+    end generate;
+    s_fuse_in(c_fetchers-1) <= c_opa_op_undef;
+    s_fuse(c_fetchers-1) <= '0';
+    s_kill(c_fetchers-1 downto 1) <= s_fuse(c_fetchers-2 downto 0);
+    s_kill(0) <= '0';
+  end generate;
+  fuse1 : if c_fetchers = 1 generate
+    s_fuse_in(0) <= c_opa_op_undef;
+    s_fuse <= "0";
+    s_kill <= "0";
   end generate;
   
   s_mask_tail(0) <= '0';
   decode : for i in 0 to c_fetchers-1 generate
-    s_ops_in(i) <= f_opa_isa_decode(g_isa, g_config, icache_dat_i((f_flip(i)+1)*c_op_wide-1 downto f_flip(i)*c_op_wide));
+    s_raw_in(i) <= icache_dat_i((f_flip(i)+1)*c_op_wide-1 downto f_flip(i)*c_op_wide);
+    s_dec_in(i) <= f_fast_shift(f_opa_isa_decode(g_isa, g_config, s_raw_in(i)));
+    s_ops_in(i) <= 
+      s_fuse_in(i)           when s_fuse(i) = '1' else
+      f_squash(s_dec_in(i))  when s_kill(i) = '1' else
+      s_dec_in(i);
     fet1 : if c_fetchers = 1 generate
       s_pc_in(i)  <= icache_pc_i(c_adr_wide-1 downto c_fetch_align);
     end generate;
@@ -296,26 +418,63 @@ begin
   subpc : if c_fetchers > 1 generate
     s_jal_pc(c_fetch_align-1 downto c_op_align)  <= f_opa_1hot_dec(s_jump_taken);
   end generate;
+  s_jal_skip <= f_opa_or(s_fuse and s_jump_taken); -- a fused call returns past both ops
   predict_push_o <= f_opa_or(s_push and s_jump_taken) and s_accept;
-  predict_ret_o  <= std_logic_vector(1 + unsigned(s_jal_pc));
+  predict_ret_o  <= std_logic_vector(1 + unsigned(s_jal_pc) + ("" & s_jal_skip));
   
   -- Flow control from fetch and to rename
-  s_stall    <= '1' when r_fill >= 2*c_renamers else '0';
+  -- Ops before the fetch PC, absorbed by fusion, and after a taken jump are
+  -- squeezed out of each fetch group, so the next group lands directly behind.
+  -- Any slack beyond c_fetchers+2*c_renamers-1 absorbs fetch bubbles.
+  s_stall    <= '1' when r_fill > c_buffers-c_fetchers else '0';
   s_stb      <= '1' when r_fill >=   c_renamers else '0';
   s_pcn_reg  <= '1' when r_fill =    c_renamers else '0';
   s_progress <= s_stb and not rename_stall_i;
   s_accept   <= icache_stb_i and not r_use_static and not s_stall;
   
+  -- Ops before the fetch PC, absorbed by a fusion, or after a taken jump are dropped
+  s_after(0) <= '0';
+  after : for i in 1 to c_fetchers-1 generate
+    s_after(i) <= s_after(i-1) or s_jump_taken(i-1);
+  end generate;
+  s_keep <= not s_mask_skip and not s_kill and not s_after;
+  
+  -- Squeeze the kept ops to the front of the group; s_cidx(p) is the p-th kept op
+  compact : process(s_keep) is
+    variable v_cidx : t_cidx_array(c_fetchers-1 downto 0);
+    variable v_cnt  : unsigned(c_fet_wide-1 downto 0);
+  begin
+    for p in 0 to c_fetchers-1 loop
+      v_cidx(p) := to_unsigned(p, c_fet_wide);
+    end loop;
+    v_cnt := (others => '0');
+    if f_opa_safe(s_keep) = '1' then
+      for i in 0 to c_fetchers-1 loop
+        if s_keep(i) = '1' then
+          v_cidx(to_integer(v_cnt)) := to_unsigned(i, c_fet_wide);
+          v_cnt := v_cnt + 1;
+        end if;
+      end loop;
+    else
+      v_cnt := (others => 'X');
+    end if;
+    s_cidx <= v_cidx;
+    -- The op at the fetch PC is always kept, so at most c_fetchers-1 are dropped
+    s_ops_sub <= to_unsigned(c_fetchers mod 2**c_fet_wide, c_fet_wide) - v_cnt;
+  end process;
+  
   -- Select the new buffer fill state
   buf1p : if c_fetchers > 1 generate
     index : block is
       type t_idx_array is array(natural range <>) of unsigned(c_fet_wide-1 downto 0);
       signal s_idx_base : unsigned(c_fet_wide-1 downto 0);
+      signal s_pos      : t_idx_array(c_buffers-1 downto 0);
       signal s_idx      : t_idx_array(c_buffers-1 downto 0);
     begin
-      s_idx_base <= s_pc_off - r_fill(s_idx_base'range);
+      s_idx_base <= 0 - r_fill(s_idx_base'range);
       ops : for i in 0 to c_buffers-1 generate
-        s_idx(i) <= s_idx_base + to_unsigned(i mod c_fetchers, c_fet_wide);
+        s_pos(i) <= s_idx_base + to_unsigned(i mod c_fetchers, c_fet_wide);
+        s_idx(i) <= s_cidx(to_integer(s_pos(i))) when f_opa_safe(s_pos(i))='1' else (others => 'X');
         s_ops(i) <= r_ops(i) when i < r_fill else s_ops_in(to_integer(s_idx(i))) when f_opa_safe(s_idx(i))='1' else c_opa_op_undef;
         s_pc (i) <= r_pc (i) when i < r_fill else s_pc_in (to_integer(s_idx(i))) when f_opa_safe(s_idx(i))='1' else (others => 'X');
         s_pcf(i) <= r_pcf(i) when i < r_fill else icache_pc_i(c_fetch_align-1 downto c_op_align);
@@ -407,13 +566,105 @@ begin
   
   icache_stall_o <= s_stall and not rename_fault_i;
   
+  -- synthesis translate_off
+  stats : process(clk_i) is
+    type t_hist is array(0 to c_buffers) of natural;
+    variable v_hist    : t_hist  := (others => 0);
+    variable v_cycles  : natural := 0;
+    variable v_starved : natural := 0;
+  begin
+    if rising_edge(clk_i) and rst_n_i = '1' and f_opa_safe(r_fill) = '1' then
+      v_hist(to_integer(r_fill)) := v_hist(to_integer(r_fill)) + 1;
+      if (not s_stb and not rename_stall_i) = '1' then
+        v_starved := v_starved + 1;
+      end if;
+      v_cycles := v_cycles + 1;
+      if v_cycles = c_stat_period then
+        for i in v_hist'range loop
+          report "decode: " & integer'image(v_hist(i)) & " cycles with " & integer'image(i) & " ops buffered" severity note;
+        end loop;
+        report "decode: rename starved for " & integer'image(v_starved) & " of " & integer'image(v_cycles) & " cycles" severity note;
+        v_hist    := (others => 0);
+        v_cycles  := 0;
+        v_starved := 0;
+      end if;
+    end if;
+  end process;
+  -- synthesis translate_on
+  
+  -- Load-wait table: loads which once ran ahead of an aliased store are ordered.
+  -- The table forgets everything periodically, so loads which stop aliasing recover.
+  lwt : if c_lwt_size > 0 generate
+    constant c_lwt_wide : natural := f_opa_log2(c_lwt_size);
+    constant c_age_wide : natural := 14; -- clear the table every 16k cycles
+    
+    signal r_lwt : std_logic_vector(c_lwt_size-1 downto 0) := (others => '0');
+    signal r_age : unsigned(c_age_wide-1 downto 0) := (others => '0');
+  begin
+    control : process(clk_i, rst_n_i) is
+    begin
+      if rst_n_i = '0' then
+        r_lwt <= (others => '0');
+        r_age <= (others => '0');
+      elsif rising_edge(clk_i) then
+        r_age <= r_age + 1;
+        if f_opa_and(std_logic_vector(r_age)) = '1' then
+          r_lwt <= (others => '0');
+        elsif l1d_wait_i = '1' then
+          r_lwt(to_integer(unsigned(l1d_pc_i(c_op_align+c_lwt_wide-1 downto c_op_align)))) <= '1';
+        end if;
+      end if;
+    end process;
+    
+    ops : for d in 0 to c_renamers-1 generate
+      s_wait(d) <=
+        r_lwt(to_integer(unsigned(r_pc(d)(c_op_align+c_lwt_wide-1 downto c_op_align))))
+        and not r_ops(d).fast and not r_ops(d).arg.ldst.store
+        and f_opa_eq(r_ops(d).arg.smode, c_opa_slow_ldst)
+        when f_opa_safe(r_pc(d)(c_op_align+c_lwt_wide-1 downto c_op_align)) = '1' else '0';
+    end generate;
+  end generate;
+  nolwt : if c_lwt_size = 0 generate
+    s_wait <= (others => '0');
+  end generate;
+  
+  -- Loads which once read I/O before they were oldest are ordered for good.
+  -- They can only retry until oldest, so this bit is never aged like the table above.
+  iot : block is
+    constant c_iot_wide : natural := 6;
+    
+    signal r_iot : std_logic_vector(2**c_iot_wide-1 downto 0) := (others => '0');
+  begin
+    control : process(clk_i, rst_n_i) is
+    begin
+      if rst_n_i = '0' then
+        r_iot <= (others => '0');
+      elsif rising_edge(clk_i) then
+        if l1d_io_i = '1' then
+          r_iot(to_integer(unsigned(l1d_iopc_i(c_op_align+c_iot_wide-1 downto c_op_align)))) <= '1';
+        end if;
+      end if;
+    end process;
+    
+    ops : for d in 0 to c_renamers-1 generate
+      s_io(d) <=
+        r_iot(to_integer(unsigned(r_pc(d)(c_op_align+c_iot_wide-1 downto c_op_align))))
+        and not r_ops(d).fast and not r_ops(d).arg.ldst.store
+        and f_opa_eq(r_ops(d).arg.smode, c_opa_slow_ldst)
+        when f_opa_safe(r_pc(d)(c_op_align+c_iot_wide-1 downto c_op_align)) = '1' else '0';
+    end generate;
+  end block;
+  
   rename_stb_o <= s_stb;
   rename_aux_o <= std_logic_vector(r_aux);
   ops_out : for d in 0 to c_renamers-1 generate
     rename_fast_o (d) <= r_ops(d).fast;
     rename_slow_o (d) <= not r_ops(d).fast;
-    rename_order_o(d) <= r_ops(d).order;
+    rename_order_o(d) <= r_ops(d).order or s_wait(d) or s_io(d);
+    rename_safe_o (d) <= f_safe(r_ops(d)) and c_fin_ready;
+    rename_long_o (d) <= f_long(r_ops(d));
     rename_setx_o (d) <= r_ops(d).setx;
+    rename_move_o (d) <= f_move(r_ops(d));
     rename_geta_o (d) <= r_ops(d).geta;
     rename_getb_o (d) <= r_ops(d).getb;
     bits : for b in 0 to c_arch_wide-1 generate
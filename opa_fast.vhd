@@ -57,6 +57,7 @@ entity opa_fast is
       issue_oldest_i : in  std_logic;
       issue_retry_o  : out std_logic;
       issue_fault_o  : out std_logic;
+      issue_redir_o  : out std_logic;
       issue_pc_o     : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
       issue_pcf_o    : out std_logic_vector(f_opa_fet_wide(g_config)-1 downto 0);
       issue_pcn_o    : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa)));
@@ -67,6 +68,34 @@ architecture rtl of opa_fast is
   constant c_imm_wide : natural := f_opa_imm_wide(g_isa);
   constant c_adr_wide : natural := f_opa_adr_wide(g_config);
   constant c_sum_wide : natural := f_opa_choose(c_imm_wide<c_adr_wide,c_imm_wide,c_adr_wide);
+  constant c_reg_wide : natural := f_opa_reg_wide(g_config);
+  constant c_log_wide : natural := f_opa_log2(c_reg_wide);
+  constant c_log_bytes: natural := c_log_wide - 3;
+  
+  -- Each shifter level is a 2**k:1 mux; with its k select bits it fits one LUT
+  function f_digit(lut : natural) return natural is
+    variable k : natural := 1;
+  begin
+    while 2**(k+1) + (k+1) <= lut loop
+      k := k + 1;
+    end loop;
+    return k;
+  end f_digit;
+  
+  constant c_digit    : natural := f_digit(g_target.lut_width);
+  constant c_levels   : natural := (c_log_wide + c_digit - 1) / c_digit;
+  
+  function f_pow(m : natural) return natural is begin return 8*2**m; end f_pow;
+  
+  function f_reverse(x : std_logic_vector) return std_logic_vector is
+    alias y : std_logic_vector(x'length-1 downto 0) is x;
+    variable result : std_logic_vector(x'length-1 downto 0);
+  begin
+    for i in y'range loop
+      result(i) := y(y'high-i);
+    end loop;
+    return result;
+  end f_reverse;
 
   signal s_arg   : t_opa_arg;
   signal s_adder : t_opa_adder;
@@ -89,7 +118,9 @@ architecture rtl of opa_fast is
   signal r_sign : std_logic;
   signal r_eq   : std_logic;
   signal r_fault: std_logic;
-  signal r_mode : std_logic_vector(1 downto 0);
+  signal r_mode : std_logic_vector(2 downto 0);
+  signal r_shift: t_opa_shift;
+  signal r_sext : t_opa_sext;
 
   type t_logic is array(natural range <>) of unsigned(1 downto 0);
   signal s_logic_in : t_logic(r_rega'range);
@@ -104,9 +135,15 @@ architecture rtl of opa_fast is
   signal s_sum_low    : std_logic_vector(r_rega'range);
   signal s_comparison : std_logic_vector(r_rega'range);
   signal s_pc_next_pad: std_logic_vector(r_rega'range) := (others => '0');
+  signal s_shout      : std_logic_vector(r_rega'range);
+  signal s_sext       : std_logic_vector(r_rega'range);
+  
+  type t_reg is array(natural range <>) of std_logic_vector(c_reg_wide-1 downto 0);
+  signal s_sext_mux   : t_reg(c_log_bytes-1 downto 0);
   
   signal s_pc_imm     : unsigned(regfile_pcn_i'range);
   signal s_pc_next    : std_logic_vector(regfile_pcn_i'range);
+  signal s_pc_link    : std_logic_vector(regfile_pcn_i'range);
   signal r_pc_next    : std_logic_vector(regfile_pcn_i'range);
   signal r_pc_jump    : std_logic_vector(regfile_pcn_i'range);
   signal r_pc_sum     : std_logic_vector(regfile_pcn_i'range);
@@ -126,6 +163,8 @@ architecture rtl of opa_fast is
   attribute dont_merge of r_sign : signal is true;
   attribute dont_merge of r_fault: signal is true;
   attribute dont_merge of r_mode : signal is true;
+  attribute dont_merge of r_shift: signal is true;
+  attribute dont_merge of r_sext : signal is true;
   
   -- These are fanned out to 64 bits; make it easier to fit
   -- attribute maxfan of r_lut  : signal is 8;
@@ -155,6 +194,8 @@ begin
       r_cin  <= s_adder.cin;
       r_sign <= s_adder.sign;
       r_fault<= s_adder.fault;
+      r_shift<= s_arg.shift;
+      r_sext <= s_arg.sext;
     end if;
   end process;
   
@@ -183,10 +224,55 @@ begin
   s_comparison(0) <= s_widex(r_rega'left+2) xor ((r_rega(31) xor r_regb(31)) and r_sign);
   s_comparison(r_rega'left downto 1) <= (others => '0');
   
-  -- Result is a jump return address
+  -- Result is a jump return address; a fused call (sign) links past both ops
   s_pc_next <= std_logic_vector(unsigned(r_pc) + 1);
-  s_pc_next_pad(s_pc_next'high-1 downto s_pc_next'low) <= std_logic_vector(s_pc_next(s_pc_next'high-1 downto s_pc_next'low));
-  s_pc_next_pad(r_rega'high downto s_pc_next'high) <= (others => s_pc_next(s_pc_next'high));
+  s_pc_link <= std_logic_vector(unsigned(r_pc) + 2) when r_sign = '1' else s_pc_next;
+  s_pc_next_pad(s_pc_link'high-1 downto s_pc_link'low) <= std_logic_vector(s_pc_link(s_pc_link'high-1 downto s_pc_link'low));
+  s_pc_next_pad(r_rega'high downto s_pc_link'high) <= (others => s_pc_link(s_pc_link'high));
+  
+  -- Result is a shift; left shifts run through the right shifter bit-reversed
+  -- The barrel shifter sits unregistered on the fast EU result mux, so no preset
+  -- enables fast_shift until its effect on fmax has been measured.
+  shift : if g_config.fast_shift generate
+    shifter : process(r_rega, r_regb, r_shift) is
+      variable x   : signed(c_reg_wide downto 0); -- top bit fills
+      variable amt : unsigned(c_log_wide-1 downto 0);
+      variable lo  : natural;
+      variable hi  : natural;
+    begin
+      amt := unsigned(r_regb(c_log_wide-1 downto 0));
+      if f_opa_safe(amt) = '1' and f_opa_safe(r_shift.right) = '1' then
+        if r_shift.right = '1' then
+          x := signed((r_shift.sext and r_rega(r_rega'high)) & r_rega);
+        else
+          x := signed('0' & f_reverse(r_rega));
+        end if;
+        for l in 0 to c_levels-1 loop
+          lo := l*c_digit;
+          hi := f_opa_choose(lo+c_digit < c_log_wide, lo+c_digit, c_log_wide);
+          x := shift_right(x, to_integer(amt(hi-1 downto lo)) * 2**lo);
+        end loop;
+        if r_shift.right = '1' then
+          s_shout <= std_logic_vector(x(c_reg_wide-1 downto 0));
+        else
+          s_shout <= f_reverse(std_logic_vector(x(c_reg_wide-1 downto 0)));
+        end if;
+      else
+        s_shout <= (others => 'X');
+      end if;
+    end process;
+    
+    -- Result is a sign extension
+    sextmux : for i in s_sext_mux'range generate
+      s_sext_mux(i)(c_reg_wide-1 downto f_pow(i)) <= (others => r_rega(f_pow(i)-1));
+      s_sext_mux(i)(f_pow(i)-1 downto 0) <= r_rega(f_pow(i)-1 downto 0);
+    end generate;
+    s_sext <= s_sext_mux(to_integer(unsigned(r_sext.size))) when f_opa_safe(r_sext.size)='1' else (others => 'X');
+  end generate;
+  noshift : if not g_config.fast_shift generate
+    s_shout <= (others => 'X');
+    s_sext  <= (others => 'X');
+  end generate;
   
   -- Send result to regfile
   with r_mode select
@@ -195,6 +281,8 @@ begin
     s_sum_low       when c_opa_fast_addl,
     s_comparison    when c_opa_fast_addh,
     s_pc_next_pad   when c_opa_fast_jump,
+    s_shout         when c_opa_fast_shift,
+    s_sext          when c_opa_fast_sext,
     (others => 'X') when others;
   
   -- Pack immediate into sum format
@@ -216,6 +304,8 @@ begin
         when c_opa_fast_addh => r_fmux(0) <= not r_fault or s_comparison(0);
                                 r_fmux(1) <= not r_fault;
         when c_opa_fast_jump => r_fmux <= "10";
+        when c_opa_fast_shift=> r_fmux <= "11";
+        when c_opa_fast_sext => r_fmux <= "11";
         when others          => r_fmux <= "XX";
       end case;
     end if;
@@ -238,6 +328,7 @@ begin
   
   issue_retry_o   <= s_br_fault;
   issue_fault_o   <= s_br_fault and issue_oldest_i;
+  issue_redir_o   <= s_br_fault and not issue_oldest_i;
   issue_pcf_o     <= r_pcf1;
   issue_pc_o      <= r_pc1;
   issue_pcn_o     <= s_br_target;
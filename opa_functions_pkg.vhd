@@ -61,12 +61,12 @@ package opa_functions_pkg is
   
   -- ISA dependant values
   function f_opa_big_endian(isa : t_opa_isa) return boolean;
-  function f_opa_num_arch (isa : t_opa_isa) return natural;
+  function f_opa_num_arch (isa : t_opa_isa; conf : t_opa_config) return natural;
   function f_opa_imm_wide (isa : t_opa_isa) return natural;
   function f_opa_op_wide  (isa : t_opa_isa) return natural;
   function f_opa_op_align (isa : t_opa_isa) return natural;
   function f_opa_page_size(isa : t_opa_isa) return natural;
-  function f_opa_arch_wide(isa : t_opa_isa) return natural;
+  function f_opa_arch_wide(isa : t_opa_isa; conf : t_opa_config) return natural;
   
   -- Decode config into useful values
   function f_opa_fetchers (conf : t_opa_config) return natural;
@@ -87,7 +87,7 @@ package opa_functions_pkg is
   function f_opa_fet_wide (conf : t_opa_config) return natural;
   function f_opa_dline_size(conf : t_opa_config) return natural;
   function f_opa_iline_size(conf : t_opa_config) return natural;
-  function f_opa_alias_high (isa  : t_opa_isa)    return natural;
+  function f_opa_alias_high (isa  : t_opa_isa; conf : t_opa_config) return natural;
   function f_opa_alias_low  (conf : t_opa_config) return natural;
 
   function f_opa_num_back   (isa : t_opa_isa; conf : t_opa_config) return natural;
@@ -100,6 +100,10 @@ package opa_functions_pkg is
   function f_opa_support_fp(conf : t_opa_config) return boolean;
   function f_opa_fast_index(conf : t_opa_config; u : natural) return natural;
   function f_opa_slow_index(conf : t_opa_config; u : natural) return natural;
+  function f_opa_num_clust (conf : t_opa_config) return natural;
+  function f_opa_fast_clust(conf : t_opa_config; u : natural) return natural; -- cluster of fast EU u
+  function f_opa_stat_clust(conf : t_opa_config; s : natural) return natural; -- cluster of station s
+  function f_opa_bypass    (conf : t_opa_config; u, v : natural) return boolean; -- EU u sees EU v at once?
 
   type t_opa_matrix is array(natural range <>, natural range <>) of std_logic;
   
@@ -260,9 +264,14 @@ package body opa_functions_pkg is
     return f_opa_isa_info(isa).big_endian;
   end f_opa_big_endian;
   
-  function f_opa_num_arch(isa : t_opa_isa) return natural is
+  -- FP registers follow the integer registers, so rename treats them alike
+  function f_opa_num_arch(isa : t_opa_isa; conf : t_opa_config) return natural is
   begin
-    return f_opa_isa_info(isa).num_arch;
+    if conf.ieee_fp then
+      return f_opa_isa_info(isa).num_arch + f_opa_isa_info(isa).num_fp;
+    else
+      return f_opa_isa_info(isa).num_arch;
+    end if;
   end f_opa_num_arch;
   
   function f_opa_imm_wide(isa : t_opa_isa) return natural is
@@ -285,9 +294,9 @@ package body opa_functions_pkg is
     return f_opa_isa_info(isa).page_size;
   end f_opa_page_size;
   
-  function f_opa_arch_wide(isa : t_opa_isa) return natural is
+  function f_opa_arch_wide(isa : t_opa_isa; conf : t_opa_config) return natural is
   begin 
-    return f_opa_log2(f_opa_num_arch(isa));
+    return f_opa_log2(f_opa_num_arch(isa, conf));
   end f_opa_arch_wide;
   
   function f_opa_fetchers(conf : t_opa_config) return natural is
@@ -397,9 +406,9 @@ package body opa_functions_pkg is
     return conf.ieee_fp;
   end f_opa_support_fp;
   
-  function f_opa_alias_high (isa : t_opa_isa) return natural is
+  function f_opa_alias_high (isa : t_opa_isa; conf : t_opa_config) return natural is
   begin
-    return f_opa_log2(f_opa_page_size(isa))-1;
+    return f_opa_log2(f_opa_page_size(isa))-1 + conf.alias_tag;
   end f_opa_alias_high;
   
   function f_opa_alias_low  (conf : t_opa_config) return natural is
@@ -417,10 +426,36 @@ package body opa_functions_pkg is
     return u + conf.num_fast;
   end f_opa_slow_index;
   
+  function f_opa_num_clust(conf : t_opa_config) return natural is
+  begin
+    return conf.num_clust;
+  end f_opa_num_clust;
+  
+  function f_opa_fast_clust(conf : t_opa_config; u : natural) return natural is
+  begin
+    return u / (conf.num_fast / conf.num_clust);
+  end f_opa_fast_clust;
+  
+  -- A station only ever holds ops from one rename lane; the lane picks the cluster
+  function f_opa_stat_clust(conf : t_opa_config; s : natural) return natural is
+  begin
+    return (s mod conf.num_rename) mod conf.num_clust;
+  end f_opa_stat_clust;
+  
+  -- Slow EUs are shared by all clusters, so they see and are seen by everyone
+  function f_opa_bypass(conf : t_opa_config; u, v : natural) return boolean is
+  begin
+    if u < conf.num_fast and v < conf.num_fast then
+      return f_opa_fast_clust(conf, u) = f_opa_fast_clust(conf, v);
+    else
+      return true;
+    end if;
+  end f_opa_bypass;
+  
   function f_opa_num_back(isa : t_opa_isa; conf : t_opa_config) return natural is
     constant pipeline_depth : natural := 1;
   begin
-    return f_opa_num_arch(isa) +
+    return f_opa_num_arch(isa, conf) +
            f_opa_num_stat(conf) +
            f_opa_renamers(conf)*pipeline_depth;
   end f_opa_num_back;
@@ -34,6 +34,7 @@ package opa_isa_base_pkg is
   type t_opa_isa_info is record
     big_endian : boolean;
     num_arch   : natural;
+    num_fp     : natural; -- extra architectural registers when ieee_fp
     imm_wide   : natural;
     op_wide    : natural;
     page_size  : natural;
@@ -43,48 +44,55 @@ package opa_isa_base_pkg is
   constant c_imm_wide_max : natural := 128;
   constant c_log_arch_max : natural := 8; -- log2(num_arch)
 
-  -- Fast execute units operate in one of four modes
+  -- Fast execute units operate in one of six modes
   -- An example of instructions each mode can handle:
   --   lut:   XORI, ORI,  ANDI,  XOR, OR, AND, LUI
   --   addlu: AUIPC, ADDI, ADD, SUB
   --   addhs: BLT,  BGE,  SLTI,  SLT, BLTU, BGEU, SLTIU, SLTU, BEQ, BNE
   --   jump:  JAL,  JALR
+  --   shift: SLLI, SRLI, SRAI, SLL, SRL, SRA  (fast_shift only; see slow shift)
+  --   sext:  SEXTB, SEXTH                     (fast_shift only; see slow sext)
   
-  constant c_opa_fast_lut  : std_logic_vector(1 downto 0) := "00";
-  constant c_opa_fast_addl : std_logic_vector(1 downto 0) := "01";
-  constant c_opa_fast_addh : std_logic_vector(1 downto 0) := "10";
-  constant c_opa_fast_jump : std_logic_vector(1 downto 0) := "11";
+  constant c_opa_fast_lut   : std_logic_vector(2 downto 0) := "000";
+  constant c_opa_fast_addl  : std_logic_vector(2 downto 0) := "001";
+  constant c_opa_fast_addh  : std_logic_vector(2 downto 0) := "010";
+  constant c_opa_fast_jump  : std_logic_vector(2 downto 0) := "011";
+  constant c_opa_fast_shift : std_logic_vector(2 downto 0) := "100";
+  constant c_opa_fast_sext  : std_logic_vector(2 downto 0) := "101";
   
   type t_opa_adder is record 
     eq    : std_logic;
     nota  : std_logic;
     notb  : std_logic;
     cin   : std_logic;
-    sign  : std_logic;
+    sign  : std_logic; -- jump: link skips the op fused into this one
     fault : std_logic;
   end record t_opa_adder;
   
-  -- Slow execute units operate in one of four modes
-  --   mul   (00)
-  --   shift (01)
-  --   load  (10)
-  --   store (11)
+  -- Slow execute units operate in one of five modes
+  --   mul   (000)
+  --   shift (001)
+  --   ldst  (010)
+  --   sext  (011)
+  --   fp    (100)
   -- An example of instructions each mode can handle:
-  --   mul:   MUL, MULH, MULHSU, MULHU  [DIV, DIVU, REM, REMU]
+  --   mul:   MUL, MULH, MULHSU, MULHU, DIV, DIVU, REM, REMU
   --   shift: SLLI, SRLI, SRAI, SLL, SRL, SRA
-  --   load:  LB, LH, LW, LBU, LHU
-  --   store: SB, SH, SW
+  --   ldst:  LB, LH, LW, LBU, LHU, SB, SH, SW, FLW, FSW  (load to r0 => prefetch)
+  --   sext:  SEXTB, SEXTH
+  --   fp:    FADD.S, FSUB.S, FMUL.S, FCVT.*, FSGNJ*.S, FMIN.S, FMAX.S, FEQ.S, FLT.S, FLE.S, FCLASS.S
   
-  constant c_opa_slow_mul   : std_logic_vector(1 downto 0) := "00";
-  constant c_opa_slow_shift : std_logic_vector(1 downto 0) := "01";
-  constant c_opa_slow_ldst  : std_logic_vector(1 downto 0) := "10";
-  constant c_opa_slow_sext  : std_logic_vector(1 downto 0) := "11";
+  constant c_opa_slow_mul   : std_logic_vector(2 downto 0) := "000";
+  constant c_opa_slow_shift : std_logic_vector(2 downto 0) := "001";
+  constant c_opa_slow_ldst  : std_logic_vector(2 downto 0) := "010";
+  constant c_opa_slow_sext  : std_logic_vector(2 downto 0) := "011";
+  constant c_opa_slow_fp    : std_logic_vector(2 downto 0) := "100";
   
   type t_opa_mul is record
-    sexta  : std_logic; -- DIV|DIVU
+    sexta  : std_logic; -- divide: signed operands (sexta=sextb)
     sextb  : std_logic;
     high   : std_logic; -- MULH|REM vs. MUL|DIV
-    divide : std_logic;
+    divide : std_logic; -- iterates in opa_prim_div, retrying until done
   end record t_opa_mul;
   
   type t_opa_shift is record
@@ -101,21 +109,38 @@ package opa_isa_base_pkg is
     store  : std_logic;
     sext   : std_logic;
     size   : std_logic_vector(1 downto 0); -- 1,2,4,8
+    pref   : std_logic; -- load without writeback; only warms the L1d
   end record t_opa_ldst;
   
   type t_opa_sext is record
     size   : std_logic_vector(1 downto 0);
   end record t_opa_sext;
   
+  -- Single precision ops; fn selects within the class (RISC-V funct3 where it has one)
+  constant c_opa_fp_arith : std_logic_vector(2 downto 0) := "000"; -- fn: 00=add 01=sub 10=mul
+  constant c_opa_fp_i2f   : std_logic_vector(2 downto 0) := "001"; -- fn(0): unsigned
+  constant c_opa_fp_f2i   : std_logic_vector(2 downto 0) := "010"; -- fn(0): unsigned
+  constant c_opa_fp_sgnj  : std_logic_vector(2 downto 0) := "011"; -- fn: 00=sgnj 01=sgnjn 10=sgnjx
+  constant c_opa_fp_minmax: std_logic_vector(2 downto 0) := "100"; -- fn: 00=min 01=max
+  constant c_opa_fp_cmp   : std_logic_vector(2 downto 0) := "101"; -- fn: 00=le 01=lt 10=eq
+  constant c_opa_fp_class : std_logic_vector(2 downto 0) := "110";
+  
+  type t_opa_fp is record
+    op     : std_logic_vector(2 downto 0);
+    fn     : std_logic_vector(1 downto 0);
+    rm     : std_logic_vector(2 downto 0); -- RISC-V rounding mode; dynamic (111) rounds to nearest even
+  end record t_opa_fp;
+  
   type t_opa_arg is record
-    fmode : std_logic_vector(1 downto 0);
+    fmode : std_logic_vector(2 downto 0);
     adder : t_opa_adder;
     lut   : std_logic_vector(3 downto 0);
-    smode : std_logic_vector(1 downto 0);
+    smode : std_logic_vector(2 downto 0);
     mul   : t_opa_mul;
     shift : t_opa_shift;
     ldst  : t_opa_ldst;
     sext  : t_opa_sext;
+    fp    : t_opa_fp;
   end record t_opa_arg;
   
   -- General information every instruction must provide
@@ -135,6 +160,7 @@ package opa_isa_base_pkg is
     pop   : std_logic; -- pop  return stack; '-' when jump=0
     push  : std_logic; -- push return stack; '-' when jump=0
     immb  : std_logic_vector(c_imm_wide_max-1 downto 0); -- branch immediates; less cases than imm.
+    fuse  : std_logic; -- this op absorbed the op that follows it
     -- Information for the issue stage
     fast  : std_logic; -- goes to fast/slow EU
     order : std_logic; -- don't issue it unless it is last
@@ -157,6 +183,7 @@ package opa_isa_base_pkg is
     pop   => '-',
     push  => '-',
     immb  => (others => '-'),
+    fuse  => '0',
     fast  => '-',
     order => '-',
     imm   => (others => '-'),
@@ -167,8 +194,9 @@ package opa_isa_base_pkg is
       smode => (others => '-'),
       mul   => (sexta => '-', sextb => '-', high => '-', divide => '-'),
       shift => (right => '-', sext => '-'),
-      ldst  => (store => '-', sext => '-', size => (others => '-')),
-      sext  => (size => (others => '-'))));
+      ldst  => (store => '-', sext => '-', size => (others => '-'), pref => '-'),
+      sext  => (size => (others => '-')),
+      fp    => (op => (others => '-'), fn => (others => '-'), rm => (others => '-'))));
   
   constant c_opa_op_undef : t_opa_op := (
     archa => (others => 'X'),
@@ -184,6 +212,7 @@ package opa_isa_base_pkg is
     pop   => 'X',
     push  => 'X',
     immb  => (others => 'X'),
+    fuse  => 'X',
     fast  => 'X',
     order => 'X',
     imm   => (others => 'X'),
@@ -194,8 +223,9 @@ package opa_isa_base_pkg is
       smode => (others => 'X'),
       mul   => (sexta => 'X', sextb => 'X', high => 'X', divide => 'X'),
       shift => (right => 'X', sext => 'X'),
-      ldst  => (store => 'X', sext => 'X', size => (others => 'X')),
-      sext  => (size => (others => 'X'))));
+      ldst  => (store => 'X', sext => 'X', size => (others => 'X'), pref => 'X'),
+      sext  => (size => (others => 'X')),
+      fp    => (op => (others => 'X'), fn => (others => 'X'), rm => (others => 'X'))));
   
   -- Even ISAs need this function
   function f_opa_log2(x : natural) return natural;
@@ -203,7 +233,7 @@ package opa_isa_base_pkg is
   function f_opa_or(x : std_logic_vector) return std_logic;
   
   -- Define the arguments needed for operations in our execution units
-  constant c_arg_wide : natural := 26;
+  constant c_arg_wide : natural := 37;
   function f_opa_vec_from_arg(x : t_opa_arg) return std_logic_vector;
   function f_opa_arg_from_vec(x : std_logic_vector(c_arg_wide-1 downto 0)) return t_opa_arg;
     
@@ -219,35 +249,40 @@ package body opa_isa_base_pkg is
       x.adder.eq & x.adder.nota & x.adder.notb & x.adder.cin & x.adder.sign & x.adder.fault &
       x.lut &
       x.smode &
-      x.mul.sexta & x.mul.sextb & x.mul.high & x.mul.high &
+      x.mul.sexta & x.mul.sextb & x.mul.high & x.mul.divide &
       x.shift.right & x.shift.sext &
-      x.ldst.store & x.ldst.sext & x.ldst.size & 
-      x.sext.size;
+      x.ldst.store & x.ldst.sext & x.ldst.size & x.ldst.pref &
+      x.sext.size &
+      x.fp.op & x.fp.fn & x.fp.rm;
     return result;
   end f_opa_vec_from_arg;
   
   function f_opa_arg_from_vec(x : std_logic_vector(c_arg_wide-1 downto 0)) return t_opa_arg is
     variable result : t_opa_arg;
   begin
-    result.fmode       := x(25 downto 24);
-    result.adder.eq    := x(23);
-    result.adder.nota  := x(22);
-    result.adder.notb  := x(21);
-    result.adder.cin   := x(20);
-    result.adder.sign  := x(19);
-    result.adder.fault := x(18);
-    result.lut         := x(17 downto 14);
-    result.smode       := x(13 downto 12);
-    result.mul.sexta   := x(11);
-    result.mul.sextb   := x(10);
-    result.mul.high    := x(9);
-    result.mul.divide  := x(8);
-    result.shift.right := x(7);
-    result.shift.sext  := x(6);
-    result.ldst.store  := x(5);
-    result.ldst.sext   := x(4);
-    result.ldst.size   := x(3 downto 2);
-    result.sext.size   := x(1 downto 0);
+    result.fmode       := x(36 downto 34);
+    result.adder.eq    := x(33);
+    result.adder.nota  := x(32);
+    result.adder.notb  := x(31);
+    result.adder.cin   := x(30);
+    result.adder.sign  := x(29);
+    result.adder.fault := x(28);
+    result.lut         := x(27 downto 24);
+    result.smode       := x(23 downto 21);
+    result.mul.sexta   := x(20);
+    result.mul.sextb   := x(19);
+    result.mul.high    := x(18);
+    result.mul.divide  := x(17);
+    result.shift.right := x(16);
+    result.shift.sext  := x(15);
+    result.ldst.store  := x(14);
+    result.ldst.sext   := x(13);
+    result.ldst.size   := x(12 downto 11);
+    result.ldst.pref   := x(10);
+    result.sext.size   := x(9 downto 8);
+    result.fp.op       := x(7 downto 5);
+    result.fp.fn       := x(4 downto 3);
+    result.fp.rm       := x(2 downto 0);
     return result;
   end f_opa_arg_from_vec;
 
@@ -39,6 +39,7 @@ package opa_isa_pkg is
   function f_opa_isa_info(isa : t_opa_isa) return t_opa_isa_info;
   function f_opa_isa_accept(isa : t_opa_isa; config : t_opa_config) return std_logic;
   function f_opa_isa_decode(isa : t_opa_isa; config : t_opa_config; x : std_logic_vector) return t_opa_op;
+  function f_opa_isa_fuse  (isa : t_opa_isa; config : t_opa_config; x, y : std_logic_vector) return t_opa_op;
   
 end package;
 
@@ -68,5 +69,15 @@ package body opa_isa_pkg is
       when T_OPA_LM32 => return f_opa_decode_lm32(config, y);
     end case;
   end f_opa_isa_decode;
+  
+  function f_opa_isa_fuse(isa : t_opa_isa; config : t_opa_config; x, y : std_logic_vector) return t_opa_op is
+    alias xa : std_logic_vector(x'length-1 downto 0) is x;
+    alias ya : std_logic_vector(y'length-1 downto 0) is y;
+  begin
+    case isa is
+      when T_OPA_RV32 => return f_opa_fuse_rv32(config, xa, ya);
+      when T_OPA_LM32 => return f_opa_fuse_lm32(config, xa, ya);
+    end case;
+  end f_opa_isa_fuse;
 
 end opa_isa_pkg;
@@ -47,9 +47,12 @@ entity opa_issue is
     -- Values the renamer provides us
     rename_stb_i   : in  std_logic;
     rename_stall_o : out std_logic;
+    rename_drain_o : out std_logic;
     rename_fast_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_slow_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_order_i : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    rename_safe_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    rename_long_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_geta_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_getb_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_aux_i   : in  std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
@@ -64,12 +67,15 @@ entity opa_issue is
     eu_oldest_o    : out std_logic_vector(f_opa_executers(g_config)-1 downto 0);
     eu_retry_i     : in  std_logic_vector(f_opa_executers(g_config)-1 downto 0);
     eu_fault_i     : in  std_logic_vector(f_opa_executers(g_config)-1 downto 0);
+    eu_redir_i     : in  std_logic_vector(f_opa_executers(g_config)-1 downto 0);
     eu_pc_i        : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     eu_pcf_i       : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_fet_wide(g_config)-1 downto 0);
     eu_pcn_i       : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     
     -- Selected fault fed back up pipeline
     rename_fault_o : out std_logic;
+    rename_resume_o: out std_logic;
+    rename_redir_o : out std_logic;
     rename_mask_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     rename_pc_o    : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     rename_pcf_o   : out std_logic_vector(f_opa_fet_wide(g_config)-1 downto 0);
@@ -83,6 +89,8 @@ entity opa_issue is
     regfile_dec_o  : out t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_ren_wide (g_config)-1 downto 0);
     regfile_baka_o : out t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide(g_isa,g_config)-1 downto 0);
     regfile_bakb_o : out t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide(g_isa,g_config)-1 downto 0);
+    regfile_long_o : out std_logic_vector(f_opa_executers(g_config)-1 downto 0);
+    regfile_stat_o : out t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_stat_wide(g_config)-1 downto 0);
     
     -- Regfile should capture result from EU
     regfile_wstb_o : out std_logic_vector(f_opa_executers(g_config)-1 downto 0);
@@ -91,14 +99,15 @@ entity opa_issue is
     -- Gather information from L1d about aliased loads
     l1d_store_i    : in  std_logic;
     l1d_load_i     : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
-    l1d_addr_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_alias_high(g_isa) downto f_opa_alias_low(g_config));
-    l1d_mask_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)/8-1 downto 0));
+    l1d_addr_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_alias_high(g_isa,g_config) downto f_opa_alias_low(g_config));
+    l1d_mask_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)/8-1 downto 0);
+    l1d_alias_o    : out std_logic); -- the store made a younger load reissue
 end opa_issue;
 
 architecture rtl of opa_issue is
 
   constant c_op_align  : natural := f_opa_op_align (g_isa);
-  constant c_num_arch  : natural := f_opa_num_arch (g_isa);
+  constant c_num_arch  : natural := f_opa_num_arch (g_isa,g_config);
   constant c_num_stat  : natural := f_opa_num_stat (g_config);
   constant c_num_fast  : natural := f_opa_num_fast (g_config);
   constant c_num_slow  : natural := f_opa_num_slow (g_config);
@@ -108,22 +117,51 @@ architecture rtl of opa_issue is
   constant c_stat_wide : natural := f_opa_stat_wide(g_config);
   constant c_adr_wide  : natural := f_opa_adr_wide (g_config);
   constant c_alias_low : natural := f_opa_alias_low(g_config);
-  constant c_alias_high: natural := f_opa_alias_high(g_isa);
+  constant c_alias_high: natural := f_opa_alias_high(g_isa,g_config);
   constant c_reg_bytes : natural := f_opa_reg_wide (g_config)/8;
   constant c_fet_wide  : natural := f_opa_fet_wide (g_config);
   constant c_renamers  : natural := f_opa_renamers (g_config);
   constant c_executers : natural := f_opa_executers(g_config);
   constant c_fast0     : natural := f_opa_fast_index(g_config, 0);
   constant c_slow0     : natural := f_opa_slow_index(g_config, 0);
+  constant c_br_early  : std_logic := f_opa_bit(g_config.br_early);
   constant c_mux_share : natural := 2;
+  constant c_num_clust : natural := f_opa_num_clust(g_config);
+  constant c_clust_fast: natural := c_num_fast / c_num_clust;
   
   constant c_stat_ones     : std_logic_vector(c_num_stat -1 downto 0) := (others => '1');
   constant c_fast_zeros    : std_logic_vector(c_num_fast -1 downto 0) := (others => '0');
   constant c_slow_ones     : std_logic_vector(c_num_slow -1 downto 0) := (others => '1');
   constant c_slow_only     : std_logic_vector(c_executers-1 downto 0) := c_slow_ones & c_fast_zeros;
   constant c_executer_ones : std_logic_vector(c_executers-1 downto 0) := (others => '1');
+  constant c_clust_ones    : std_logic_vector(c_num_clust-1 downto 0) := (others => '1');
   
   constant c_init_bak : t_opa_matrix := f_opa_labels(c_num_stat, c_back_wide, c_num_arch);
+  constant c_stat_labels : t_opa_matrix := f_opa_labels(c_num_stat, c_stat_wide);
+  
+  -- Stations steered to cluster c (by rename lane), one row per cluster
+  function f_clust_stats return t_opa_matrix is
+    variable result : t_opa_matrix(c_num_clust-1 downto 0, c_num_stat-1 downto 0);
+  begin
+    for c in result'range(1) loop
+      for s in result'range(2) loop
+        result(c,s) := f_opa_bit(f_opa_stat_clust(g_config, s) = c);
+      end loop;
+    end loop;
+    return result;
+  end f_clust_stats;
+  constant c_clust_stats : t_opa_matrix := f_clust_stats;
+  
+  -- The first fast EU of each cluster receives that cluster's oldest op
+  function f_fast_leads return std_logic_vector is
+    variable result : std_logic_vector(c_executers-1 downto 0) := (others => '0');
+  begin
+    for c in 0 to c_num_clust-1 loop
+      result(f_opa_fast_index(g_config, c*c_clust_fast)) := '1';
+    end loop;
+    return result;
+  end f_fast_leads;
+  constant c_fast_leads : std_logic_vector(c_executers-1 downto 0) := f_fast_leads;
 
   -- OPA makes heavy use of speculative execution; instructions run opportunistically.
   -- It can make these kinds of mistakes, detected during execution:
@@ -144,6 +182,14 @@ architecture rtl of opa_issue is
   -- be possible to support multiple concurrent stores to L1 cache if the stores are
   -- all the oldest remaining instructions, but this requires more write ports on L1
   -- and I chose not to implement this in order to keep L1 reasonably cost effective.
+  -- Instead, L1d puts a store buffer (sb_size) in front of its write port. The oldest
+  -- store completes once buffered, without waiting for the write port or a miss,
+  -- and younger loads pick up the buffered bytes. Stores still only execute when
+  -- they are the oldest op, so buffered entries are never speculative and this
+  -- module never needs to kill them. Loads that ran ahead of an aliasing store
+  -- are still reissued by the alias check below; speculative stores would need
+  -- per-entry commit/kill between here and L1d, which is not implemented.
+  -- The buffer shortens each store, but still only one store executes at a time.
   --
   -- Instructions in the window (c_num_stat) have these flags:
   --   issued:   already sent to the execution units
@@ -155,6 +201,8 @@ architecture rtl of opa_issue is
   -- Slow instructions transition ready to high 2 cycles after issued goes high.
   -- Fast instructions transition issued and ready to high at the same time.
   -- Both types transition final to high 4 cycles after issued goes high.
+  -- With fin_ready, ops which can neither fault nor retry (safe) go final with ready,
+  -- so they may commit while still in flight; their writeback is already scheduled.
   --
   -- The oldest instruction is at index 0. Newer instructions have larger indexes.
   -- Only complete instructions are shifted out of the window, updating the commit map.
@@ -195,11 +243,15 @@ architecture rtl of opa_issue is
   --      not go final, causing its own reissue later (dbus has 5 cycles to refill L1)
   --   C. A page fault is handled like a mispredicted branch/jump; reissue until oldest, then fault
   --   D. When a store executes, any loads with a matching address are reissued
-  --      For now, I consider addresses to alias if they have the same word offset in a page
+  --      Addresses alias if they have the same word offset in a page and the same
+  --      alias_tag bits of physical page number (folded by L1d after translation).
+  --      With alias_tag=0, any two pages alias.
   --
-  -- To avoid wasteful reissue, we only issue stores once all priors are issued, making
-  -- it very likely that they execute only when all priors are final. Unfortunately, 
-  -- without a dedicated 'ioload' instruction, we cannot likewise delay load issue.
+  -- To avoid wasteful reissue, we only issue ordered ops once all priors are final,
+  -- so that they execute as the oldest instruction. Stores are always ordered.
+  -- Loads are ordered when decode's load-wait table (lwt_size) remembers that the
+  -- load at that PC once ran ahead of a store it aliased, or that it read from pbus
+  -- (I/O) before it was oldest; L1d trains the table. Other loads stay speculative.
   -- 
   -- To keep r_schedule0 as easy to compute as possible, half of the reservation station
   -- is shifted early, and half is shifted late. r_schedule0 is late, as is anything fed
@@ -209,6 +261,7 @@ architecture rtl of opa_issue is
   signal s_schedule_fast : t_opa_matrix(c_num_fast-1  downto 0, c_num_stat-1 downto 0);
   signal s_schedule_slow : t_opa_matrix(c_num_slow-1  downto 0, c_num_stat-1 downto 0);
   signal r_schedule0     : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0) := (others => (others => '0'));
+  signal r_schedule0l    : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0) := (others => (others => '0'));
   signal r_schedule1s    : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0) := (others => (others => '0'));
   signal r_schedule2     : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0) := (others => (others => '0'));
   signal r_schedule3s    : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0) := (others => (others => '0'));
@@ -218,6 +271,10 @@ architecture rtl of opa_issue is
   -- These have 0 latency indexes (fed directly)
   signal r_fast       : std_logic_vector(c_num_stat-1 downto 0) := (others => '0');
   signal r_slow       : std_logic_vector(c_num_stat-1 downto 0) := (others => '0');
+  signal r_order      : std_logic_vector(c_num_stat-1 downto 0) := (others => '0');
+  signal r_safe       : std_logic_vector(c_num_stat-1 downto 0) := (others => '0');
+  signal r_long       : std_logic_vector(c_num_stat-1 downto 0) := (others => '0');
+  signal s_prior_final: std_logic_vector(c_num_stat-1 downto 0);
   signal s_issued     : std_logic_vector(c_num_stat-1 downto 0);
   signal s_new_issued : std_logic_vector(c_num_stat-1 downto 0);
   signal r_issued     : std_logic_vector(c_num_stat-1 downto 0) := (others => '1');
@@ -234,6 +291,10 @@ architecture rtl of opa_issue is
   signal s_ready_slow : std_logic_vector(c_num_stat-1 downto 0);
   signal s_new_ready  : std_logic_vector(c_num_stat-1 downto 0);
   signal r_ready      : std_logic_vector(c_num_stat-1 downto 0) := (others => '1');
+  signal r_ready_prev : std_logic_vector(c_num_stat-1 downto 0) := (others => '1');
+  signal r_fast1      : std_logic_vector(c_num_stat-1 downto 0) := (others => '0');
+  signal r_long1      : std_logic_vector(c_num_stat-1 downto 0) := (others => '0');
+  signal s_long1      : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0);
   signal r_geta       : std_logic_vector(c_num_stat-1 downto 0);
   signal r_getb       : std_logic_vector(c_num_stat-1 downto 0);
   signal r_aux        : t_opa_matrix(c_num_stat-1 downto 0, c_aux_wide -1 downto 0);
@@ -243,17 +304,19 @@ architecture rtl of opa_issue is
   
   -- Calculation of what to issue
   type t_ready_pad is array(natural range <>) of std_logic_vector(2**c_stat_wide-1 downto 0);
-  signal s_ready_pads      : t_ready_pad((c_num_stat+c_mux_share-1)/c_mux_share-1 downto 0);
-  signal s_ready_pad       : std_logic_vector(2**c_stat_wide-1 downto 0) := (others => '0');
+  signal s_ready_pads      : t_ready_pad(((c_num_stat+c_mux_share-1)/c_mux_share)*c_num_clust-1 downto 0);
+  signal s_ready_pad       : t_ready_pad(c_num_clust-1 downto 0) := (others => (others => '0'));
   signal s_readya          : std_logic_vector(c_num_stat-1 downto 0);
   signal s_readyb          : std_logic_vector(c_num_stat-1 downto 0);
   signal s_readyab         : std_logic_vector(c_num_stat-1 downto 0);
   signal s_pending_fast    : std_logic_vector(c_num_stat-1 downto 0);
   signal s_pending_slow    : std_logic_vector(c_num_stat-1 downto 0);
+  signal s_fast_total      : t_opa_matrix(c_num_clust-1 downto 0, c_num_stat-1 downto 0);
   signal s_fast_issue      : std_logic_vector(c_num_stat-1 downto 0);
   signal r_fast_issue      : std_logic_vector(c_num_stat-1 downto 0);
   signal s_slow_issue      : std_logic_vector(c_num_stat-1 downto 0);
   signal r_slow_issue      : std_logic_vector(c_num_stat-1 downto 0);
+  signal r_long_block      : std_logic_vector(c_num_stat-1 downto 0) := (others => '0');
   
   -- The three sources of reissue
   signal s_nodep           : std_logic_vector(c_num_stat-1 downto 0);
@@ -261,6 +324,7 @@ architecture rtl of opa_issue is
   signal s_retry           : std_logic_vector(c_num_stat-1 downto 0);
   
   signal r_retry           : std_logic_vector(c_executers-1 downto 0) := (others => '0');
+  signal s_eu_retry        : std_logic_vector(c_executers-1 downto 0);
   signal s_finalize        : std_logic_vector(c_executers-1 downto 0);
   signal r_wipe            : std_logic_vector(c_num_stat-1  downto 0) := (others => '0');
   signal s_wipe            : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0);
@@ -310,7 +374,7 @@ architecture rtl of opa_issue is
   signal r_fault_pending : std_logic := '0';
   signal s_fault_out     : std_logic;
   signal r_fault_out     : std_logic := '0'; -- lasts one cycle
-  signal r_fault_out1    : std_logic := '0'; -- one cycle delayed
+  signal r_bubble1       : std_logic := '0'; -- empty group shifted in one cycle ago
   signal r_fault_pipe    : std_logic := '0'; -- lasts two cycles
   signal r_fault_mask    : std_logic_vector(c_renamers-1 downto 0);
   signal r_fault_pc      : std_logic_vector(c_adr_wide-1 downto c_op_align);
@@ -322,6 +386,24 @@ architecture rtl of opa_issue is
   signal r_fault_fast_pc : std_logic_vector(c_adr_wide-1 downto c_op_align);
   signal r_fault_fast_pcf: std_logic_vector(c_fet_wide-1 downto 0);
   signal r_fault_fast_pcn: std_logic_vector(c_adr_wide-1 downto c_op_align);
+  signal r_fault_resume  : std_logic := '0';
+  
+  -- A branch that mispredicts before it is oldest redirects fetch at once (br_early)
+  signal r_redir_in      : std_logic_vector(c_executers-1 downto 0) := (others => '0');
+  signal r_redir_sel     : std_logic_vector(c_executers-1 downto 0) := (others => '0');
+  signal r_am_oldest     : std_logic_vector(c_executers-1 downto 0) := (others => '0');
+  signal s_early_run     : std_logic_vector(c_executers-1 downto 0);
+  signal s_redir_hit     : std_logic_vector(c_executers-1 downto 0);
+  signal s_redir_stat    : std_logic_vector(c_num_stat-1 downto 0);
+  signal s_redir_take    : std_logic;
+  signal s_redir_fault   : std_logic;
+  signal s_early         : std_logic_vector(c_num_stat-1 downto 0);
+  signal r_early         : std_logic_vector(c_num_stat-1 downto 0) := (others => '0');
+  signal r_redir         : std_logic := '0'; -- lasts until the fault which ends it
+  signal r_redir_out     : std_logic := '0'; -- lasts one cycle
+  signal r_redir_pcn     : std_logic_vector(c_adr_wide-1 downto c_op_align);
+  signal s_drain         : std_logic;
+  signal s_bubble        : std_logic;
   
   function f_decoder_labels(renamers : natural) return t_opa_matrix is
     variable result : t_opa_matrix(c_num_stat-1 downto 0, c_ren_wide-1 downto 0);
@@ -348,6 +430,12 @@ architecture rtl of opa_issue is
     return result;
   end f_shift;
   
+  -- The unbroken run of ones starting at the oldest station
+  function f_run(x : std_logic_vector) return std_logic_vector is
+  begin
+    return x and not std_logic_vector(unsigned(x) + 1);
+  end f_run;
+  
   function f_shift(x : t_opa_matrix; s : std_logic) return t_opa_matrix is
     variable result : t_opa_matrix(x'range(1), x'range(2)) := x;
   begin
@@ -378,6 +466,8 @@ begin
       assert (f_opa_safe(r_fault_out)  = '1') report "issue: r_fault_out has metavalue" severity failure;
       assert (f_opa_safe(s_fault_out)  = '1') report "issue: s_fault_out has metavalue" severity failure;
       assert (f_opa_safe(r_fault_in)   = '1') report "issue: r_fault_in has metavalue" severity failure;
+      assert (f_opa_safe(r_redir)      = '1') report "issue: r_redir has metavalue" severity failure;
+      assert (f_opa_safe(s_drain)      = '1') report "issue: s_drain has metavalue" severity failure;
       
       for i in 0 to c_num_stat-1 loop
         assert (f_opa_safe(f_opa_select_row(r_stata,i)) = '1') report "issue: stata bad" severity warning;
@@ -388,6 +478,7 @@ begin
 
   invariants : process(clk_i) is
     variable v_schedule0s : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0);
+    variable v_schedule0l : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0);
     variable v_schedule1s : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0);
     variable v_schedule2s : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0);
     variable v_schedule3s : t_opa_matrix(c_executers-1 downto 0, c_num_stat-1 downto 0);
@@ -425,6 +516,7 @@ begin
       
       -- Start checking the schedule
       v_schedule0s := not f_opa_dup_row(c_executers, r_wipe) and f_shift(r_schedule0, r_shift);
+      v_schedule0l := not f_opa_dup_row(c_executers, r_wipe) and r_schedule0l;
       v_schedule1s := not f_opa_dup_row(c_executers, r_wipe) and r_schedule1s;
       v_schedule2s := not f_opa_dup_row(c_executers, r_wipe) and f_shift(r_schedule2, r_shift);
       v_schedule3s := not f_opa_dup_row(c_executers, r_wipe) and r_schedule3s; 
@@ -442,6 +534,8 @@ begin
         for s in 0 to c_num_stat-1 loop
           assert (v_seen(s) = '0' or v_schedule0s(u,s) = '0') report "issue: double-scheduled operation" severity failure;
           v_seen(s) := v_seen(s) or v_schedule0s(u,s);
+          assert (v_seen(s) = '0' or v_schedule0l(u,s) = '0') report "issue: double-scheduled operation" severity failure;
+          v_seen(s) := v_seen(s) or v_schedule0l(u,s);
           assert (v_seen(s) = '0' or v_schedule1s(u,s) = '0') report "issue: double-scheduled operation" severity failure;
           v_seen(s) := v_seen(s) or v_schedule1s(u,s);
           assert (v_seen(s) = '0' or v_schedule2s(u,s) = '0') report "issue: double-scheduled operation" severity failure;
@@ -463,8 +557,8 @@ begin
       report "issue: issued operation is not scheduled!"
       severity failure;
       
-      -- If it's scheduled, it better not be final!
-      assert (f_opa_or(v_seen and r_final) = '0')
+      -- If it's scheduled, it better not be final (unless it went final with ready)!
+      assert (f_opa_or(v_seen and r_final and not r_safe) = '0')
       report "issue: scheduled operation is final!"
       severity failure;
 
@@ -478,7 +572,7 @@ begin
       -- Find the instructions we claim are old
       v_old := f_opa_product(f_opa_transpose(v_schedule4s), r_old);
       
-      assert (f_opa_or(v_old and r_final) = '0')
+      assert (f_opa_or(v_old and r_final and not r_safe) = '0')
       report "issue: an old instruction cannot be final!"
       severity failure;
       
@@ -490,16 +584,21 @@ begin
       severity failure;
       
       -- The current 'oldest' instruction had better be correct
-      assert (s_am_oldest(c_fast0) = '0' or s_old(c_fast0) = '1')
-      report "issue: fast0 s_am_oldest, but not old?!"
+      assert (f_opa_or(s_am_oldest and not s_old) = '0')
+      report "issue: s_am_oldest, but not old?!"
       severity failure;
       
-      assert (s_am_oldest(c_slow0) = '0' or s_old(c_slow0) = '1')
-      report "issue: fast0 s_am_oldest, but not old?!"
+      assert (f_opa_or(s_am_oldest and std_logic_vector(unsigned(s_am_oldest) - 1)) = '0')
+      report "issue: there can not be two oldest"
       severity failure;
       
-      assert (s_am_oldest(c_fast0) = '0' or s_am_oldest(c_slow0) = '0')
-      report "issue: there can not be two oldest"
+      -- An outstanding redirect belongs to exactly one station until the fault ends it
+      assert (f_opa_or(r_early and std_logic_vector(unsigned(r_early) - 1)) = '0')
+      report "issue: two stations own the early redirect"
+      severity failure;
+      
+      assert (r_fault_pipe = '1' or r_redir = f_opa_or(r_early))
+      report "issue: early redirect lost its station"
       severity failure;
       
     end if;
@@ -521,34 +620,65 @@ begin
   -- so this seeming small optimization does matter.
   -- 
   -- For this calculation, insert '-'s for backward references (impossible) to save area.
-  s_ready_pad(r_ready'range) <= r_ready; -- pad with 0s
+  --
+  -- With clusters, each cluster sees its own view: a fast result from another cluster
+  -- only arrives through the registered bypass, so it must have been ready last cycle too.
+  clust_pad : for c in 0 to c_num_clust-1 generate
+    s_ready_pad(c)(r_ready'range) <= r_ready and -- pad with 0s
+      (r_ready_prev or not r_fast1 or f_opa_select_row(c_clust_stats, c));
+  end generate;
   pads : for i in 0 to ((c_num_stat+c_mux_share-1)/c_mux_share)-1 generate
-    s_ready_pads(i)(2**c_stat_wide-1) <= '1'; -- no-stat-dep means always ready
-    s_ready_pads(i)((i+1)*c_mux_share+c_renamers-2 downto 0) <= s_ready_pad((i+1)*c_mux_share+c_renamers-2 downto 0);
-    gap : if 2**c_stat_wide-2 >= (i+1)*c_mux_share+c_renamers-1 generate
-      s_ready_pads(i)(2**c_stat_wide-2 downto (i+1)*c_mux_share+c_renamers-1) <= (others => '-');
+    clust : for c in 0 to c_num_clust-1 generate
+      s_ready_pads(i*c_num_clust+c)(2**c_stat_wide-1) <= '1'; -- no-stat-dep means always ready
+      s_ready_pads(i*c_num_clust+c)((i+1)*c_mux_share+c_renamers-2 downto 0) <= s_ready_pad(c)((i+1)*c_mux_share+c_renamers-2 downto 0);
+      gap : if 2**c_stat_wide-2 >= (i+1)*c_mux_share+c_renamers-1 generate
+        s_ready_pads(i*c_num_clust+c)(2**c_stat_wide-2 downto (i+1)*c_mux_share+c_renamers-1) <= (others => '-');
+      end generate;
     end generate;
   end generate;
   compose : for i in 0 to c_num_stat-1 generate
-    s_readya(i) <= s_ready_pads(i / c_mux_share)(to_integer(unsigned(f_opa_select_row(r_stata, i))));
-    s_readyb(i) <= s_ready_pads(i / c_mux_share)(to_integer(unsigned(f_opa_select_row(r_statb, i))));
+    s_readya(i) <= s_ready_pads((i / c_mux_share)*c_num_clust+f_opa_stat_clust(g_config, i))(to_integer(unsigned(f_opa_select_row(r_stata, i))));
+    s_readyb(i) <= s_ready_pads((i / c_mux_share)*c_num_clust+f_opa_stat_clust(g_config, i))(to_integer(unsigned(f_opa_select_row(r_statb, i))));
   end generate;
   
   -- Which stations are pending issue?
   s_readyab <= s_readya and s_readyb; -- 3 levels (for stat_wide <= 5)
   s_pending_fast <= s_readyab and not s_issued and r_fast;
-  s_pending_slow <= s_readyab and not s_issued and r_slow;
+  s_pending_slow <= s_readyab and not s_issued and r_slow and (s_prior_final or not r_order) and not r_long_block;
+  
+  -- Ordered ops wait until everything before them is final
+  -- r_final is a cycle stale, which only delays them further
+  s_prior_final <= f_run(r_final)(c_num_stat-2 downto 0) & '1';
   
   -- Derive the schedule from the pending instructions
-  fast : opa_prefixsum
-    generic map(
-      g_target => g_target,
-      g_width  => c_num_stat,
-      g_count  => c_num_fast)
-    port map(
-      bits_i   => s_pending_fast,
-      count_o  => s_schedule_fast,
-      total_o  => s_fast_issue);
+  -- Each cluster schedules its own stations onto its own fast EUs
+  fast : for c in 0 to c_num_clust-1 generate
+    clust : block is
+      signal s_bits  : std_logic_vector(c_num_stat-1 downto 0);
+      signal s_count : t_opa_matrix(c_clust_fast-1 downto 0, c_num_stat-1 downto 0);
+      signal s_total : std_logic_vector(c_num_stat-1 downto 0);
+    begin
+      s_bits <= s_pending_fast and f_opa_select_row(c_clust_stats, c);
+      prefixsum : opa_prefixsum
+        generic map(
+          g_target => g_target,
+          g_width  => c_num_stat,
+          g_count  => c_clust_fast)
+        port map(
+          bits_i   => s_bits,
+          count_o  => s_count,
+          total_o  => s_total);
+      rows : for u in 0 to c_clust_fast-1 generate
+        stats : for j in 0 to c_num_stat-1 generate
+          s_schedule_fast(c*c_clust_fast+u,j) <= s_count(u,j);
+        end generate;
+      end generate;
+      stats : for j in 0 to c_num_stat-1 generate
+        s_fast_total(c,j) <= s_total(j) and c_clust_stats(c,j);
+      end generate;
+    end block;
+  end generate;
+  s_fast_issue <= f_opa_product(f_opa_transpose(s_fast_total), c_clust_ones);
   slow : opa_prefixsum
     generic map(
       g_target => g_target,
@@ -568,6 +698,8 @@ begin
   regfile_bakb_o <= f_opa_product(r_schedule0, r_bakb);
   regfile_aux_o  <= f_opa_product(r_schedule0, r_aux);
   regfile_dec_o  <= f_opa_product(r_schedule0, c_decoder_labels);
+  regfile_long_o <= f_opa_product(r_schedule0, r_long1);
+  regfile_stat_o <= f_opa_product(r_schedule0, c_stat_labels); -- lower is older
     -- 2 levels with stations <= 18
   
   -- Report our writeback schedule to the regfile
@@ -585,7 +717,7 @@ begin
   -- All the reasons we might have to reissue instructions
   s_nodep <= not s_readyab;
   -- r_alias
-  s_retry <= f_opa_product(f_opa_transpose(r_schedule4s), r_retry) and not r_wipe; -- EU wants to re-run
+  s_retry <= f_opa_product(f_opa_transpose(r_schedule4s), s_eu_retry) and not r_wipe; -- EU wants to re-run
   
   -- issued must go low in all three cases
   s_new_issued <= s_issued and not (s_nodep or r_alias or s_retry);
@@ -601,7 +733,7 @@ begin
   --    => s_nodep is already considered via s_pending_fast
   --    => s_alias does not apply to fast instructions, only slow ones (loads)
   --    => s_retry is impossible => it implies simultaneous execution
-  s_ready <= f_shift(r_ready, r_shift, r_fault_out1);
+  s_ready <= f_shift(r_ready, r_shift, r_bubble1);
   s_ready_slow <= 
     not (s_nodep or r_alias or s_retry) and
     (s_ready or (f_opa_product(f_opa_transpose(r_schedule1s), c_slow_only) and not r_wipe));
@@ -612,14 +744,21 @@ begin
   --   => s_retry is actually the opposite here; we only go final if its false
   --   => r_alias must be considered, in order for store final=1 to be atomic with load final=0
   --      however, r_alias cannot affect anything scheduled, as they are not final
-  s_finalize <= not r_retry;
+  s_finalize <= not s_eu_retry;
   s_final <= (r_final and not r_alias) or (f_opa_product(f_opa_transpose(r_schedule4s), s_finalize) and not r_wipe);
-  s_new_final <= s_final and not s_nodep;
+  s_new_final <= (s_final and not s_nodep) or (s_new_ready and r_safe);
   
   -- Determine if the execution window should be shifted
   s_stall  <= not f_opa_and(s_final(c_renamers-1 downto 0));
-  s_shift  <= (rename_stb_i and not s_stall) or r_fault_out;
-  rename_stall_o <= s_stall;
+  s_shift  <= (rename_stb_i and not (s_stall or r_redir)) or s_drain or r_fault_out;
+  rename_stall_o <= s_stall or r_redir;
+  
+  -- While fetch runs ahead of an early redirect, rename holds the new path back.
+  -- The window keeps committing by shifting in empty groups, so the redirecting
+  -- branch still reaches the bottom group where its fault can be taken.
+  s_drain  <= r_redir and not s_stall and not r_fault_pipe;
+  s_bubble <= s_drain or r_fault_out;
+  rename_drain_o <= s_drain;
   
   -- Plan oldest calculation one cycle ahead:
   -- Recall that complete = this and all later instructions are final.
@@ -664,12 +803,17 @@ begin
   --             No other instructions are earlier, if we are an oldest candidate.
   
   s_oldest_possible <= f_opa_and(not r_old or s_finalize);
-  s_am_oldest(c_fast0) <= s_oldest_possible and r_oldest_candidate(c_fast0);
-  s_am_oldest(c_slow0) <= s_oldest_possible and r_oldest_candidate(c_slow0);
+  oldest : for u in 0 to c_executers-1 generate
+    lead : if c_fast_leads(u) = '1' or u = c_slow0 generate
+      s_am_oldest(u) <= s_oldest_possible and r_oldest_candidate(u);
+    end generate;
+  end generate;
   eu_oldest_o <= s_am_oldest;
   
   -- Forward the fault up the pipeline
   rename_fault_o <= r_fault_out;
+  rename_resume_o<= r_fault_resume;
+  rename_redir_o <= r_redir_out;
   rename_mask_o  <= r_fault_mask;
   rename_pc_o    <= r_fault_pc;
   rename_pcf_o   <= r_fault_pcf;
@@ -677,7 +821,7 @@ begin
   -- faults always come with an s_shift
   
   -- We can use r_final instead of s_final/s_stall because a fault only happens if it was last
-  s_fault_pending <= r_fault_in(c_fast0) or r_fault_in(c_slow0);
+  s_fault_pending <= f_opa_or(r_fault_in and c_fast_leads) or r_fault_in(c_slow0) or s_redir_fault;
   s_fault_out     <= (s_fault_pending or r_fault_pending) and 
                      not f_opa_and(r_final(c_renamers-1 downto 0));
   
@@ -687,24 +831,39 @@ begin
       r_fault_in      <= (others => '0');
       r_fault_pending <= '0';
       r_fault_out     <= '0';
-      r_fault_out1    <= '0';
+      r_bubble1       <= '0';
       r_fault_pipe    <= '0';
+      r_redir_in      <= (others => '0');
+      r_am_oldest     <= (others => '0');
+      r_redir         <= '0';
+      r_redir_out     <= '0';
     elsif rising_edge(clk_i) then
-      r_fault_out1 <= r_fault_out;
+      r_bubble1    <= s_bubble;
       r_fault_pipe <= s_fault_out or r_fault_out;
+      r_am_oldest  <= s_am_oldest;
+      r_redir_out  <= s_redir_take;
       if r_fault_out = '1' then
         r_fault_in      <= (others => '0');
         r_fault_pending <= '0';
         r_fault_out     <= '0';
+        r_redir_in      <= (others => '0');
       else
         r_fault_in      <= eu_fault_i;
         r_fault_pending <= r_fault_pending or s_fault_pending;
         r_fault_out     <= s_fault_out;
+        r_redir_in      <= eu_redir_i;
+      end if;
+      -- Rename stays held until the flush is over, so a resumed fetch loses nothing
+      if r_fault_pipe = '1' and r_fault_out = '0' then
+        r_redir <= '0';
+      elsif s_redir_take = '1' then
+        r_redir <= '1';
       end if;
     end if;
   end process;
   
   fault_adr : process(clk_i) is
+    variable v_sel : std_logic_vector(c_executers-1 downto 0);
   begin
     if rising_edge(clk_i) then
       if s_fault_out = '1' then
@@ -716,6 +875,35 @@ begin
       r_fault_fast_pc  <= f_opa_select_row(eu_pc_i,  c_fast0);
       r_fault_fast_pcf <= f_opa_select_row(eu_pcf_i, c_fast0);
       r_fault_fast_pcn <= f_opa_select_row(eu_pcn_i, c_fast0);
+      v_sel := (others => '0');
+      v_sel(c_fast0) := '1';
+      -- Any fast EU may redirect early or run the redirecting branch; faults win
+      for u in 0 to c_executers-1 loop
+        if u /= c_fast0 and u < c_num_fast and (eu_redir_i(u) or s_early_run(u)) = '1' then
+          r_fault_fast_pc  <= f_opa_select_row(eu_pc_i,  u);
+          r_fault_fast_pcf <= f_opa_select_row(eu_pcf_i, u);
+          r_fault_fast_pcn <= f_opa_select_row(eu_pcn_i, u);
+          v_sel := (others => '0');
+          v_sel(u) := '1';
+        end if;
+      end loop;
+      if eu_fault_i(c_fast0) = '1' then
+        r_fault_fast_pc  <= f_opa_select_row(eu_pc_i,  c_fast0);
+        r_fault_fast_pcf <= f_opa_select_row(eu_pcf_i, c_fast0);
+        r_fault_fast_pcn <= f_opa_select_row(eu_pcn_i, c_fast0);
+        v_sel := (others => '0');
+        v_sel(c_fast0) := '1';
+      end if;
+      for u in 0 to c_executers-1 loop
+        if u /= c_fast0 and c_fast_leads(u) = '1' and eu_fault_i(u) = '1' then
+          r_fault_fast_pc  <= f_opa_select_row(eu_pc_i,  u);
+          r_fault_fast_pcf <= f_opa_select_row(eu_pcf_i, u);
+          r_fault_fast_pcn <= f_opa_select_row(eu_pcn_i, u);
+          v_sel := (others => '0');
+          v_sel(u) := '1';
+        end if;
+      end loop;
+      r_redir_sel <= v_sel;
       r_fault_slow_pc  <= f_opa_select_row(eu_pc_i,  c_slow0);
       r_fault_slow_pcf <= f_opa_select_row(eu_pcf_i, c_slow0);
       r_fault_slow_pcn <= f_opa_select_row(eu_pcn_i, c_slow0);
@@ -724,20 +912,59 @@ begin
       r_fault_pcf <= r_fault_pcf;
       r_fault_pcn <= r_fault_pcn;
       
-      -- These two cases are actually mutually exclusive, but whatever.
-      if r_fault_in(c_fast0) = '1' then
+      -- An early redirect borrows the fault address; it is never taken with a fault
+      if s_redir_take = '1' then
         r_fault_pc   <= r_fault_fast_pc;
         r_fault_pcf  <= r_fault_fast_pcf;
         r_fault_pcn  <= r_fault_fast_pcn;
+        r_redir_pcn  <= r_fault_fast_pcn;
+      end if;
+      
+      -- These two cases are actually mutually exclusive, but whatever.
+      -- If fetch was already sent to the same target, it can simply resume.
+      if (f_opa_or(r_fault_in and c_fast_leads) or s_redir_fault) = '1' then
+        r_fault_pc     <= r_fault_fast_pc;
+        r_fault_pcf    <= r_fault_fast_pcf;
+        r_fault_pcn    <= r_fault_fast_pcn;
+        r_fault_resume <= r_redir and f_opa_eq(r_fault_fast_pcn, r_redir_pcn);
       end if;
       if r_fault_in(c_slow0) = '1' then
-        r_fault_pc   <= r_fault_slow_pc;
-        r_fault_pcf  <= r_fault_slow_pcf;
-        r_fault_pcn  <= r_fault_slow_pcn;
+        r_fault_pc     <= r_fault_slow_pc;
+        r_fault_pcf    <= r_fault_slow_pcf;
+        r_fault_pcn    <= r_fault_slow_pcn;
+        r_fault_resume <= '0';
       end if;
     end if;
   end process;
   
+  -- Early redirect. A fast EU whose branch mispredicts before it is oldest asks
+  -- to retry as usual, but also reports the redirect. The first such branch sends
+  -- fetch to its target right away, and becomes the early station. Rename holds
+  -- the new path back (the window has no checkpoint of the map at the branch),
+  -- so the early station must still fault once it is oldest, which flushes the
+  -- younger ops and reloads the committed map. If it lands where fetch already
+  -- went, the front-end keeps its buffered ops and simply resumes.
+  --
+  -- This is only a partial measure. It overlaps the front-end refill with the
+  -- wait for the branch to become oldest, but the recovery itself is unchanged:
+  -- wrong-path ops already in the window keep executing until the fault, and
+  -- the new path cannot enter rename before it. Letting it in at once would need
+  -- a checkpoint of the rename maps (and free list position) per branch.
+  -- Until those exist, the presets leave br_early off.
+  --
+  -- The early station never goes final. Run as oldest, it always faults, even if
+  -- it no longer mispredicts (its operands changed), because fetch left its path.
+  -- A mispredict reports its own fault; otherwise we raise one on its behalf.
+  -- Run otherwise, it is retried until it runs as oldest.
+  s_redir_stat  <= f_opa_product(f_opa_transpose(r_schedule4s), r_redir_in and r_redir_sel) and not r_wipe;
+  s_redir_take  <= c_br_early and f_opa_or(s_redir_stat) and not
+                   (r_redir or s_fault_pending or r_fault_pending or r_fault_out or r_fault_pipe);
+  s_early       <= s_redir_stat when s_redir_take = '1' else r_early;
+  s_early_run   <= f_opa_product(r_schedule3s, r_early) and s_am_oldest;
+  s_redir_hit   <= f_opa_product(r_schedule4s, r_early and not r_wipe);
+  s_redir_fault <= f_opa_or(s_redir_hit and r_am_oldest and not r_retry);
+  s_eu_retry    <= r_retry or s_redir_hit;
+  
   -- Extract the slow unit schedule
   slow_sched3 : for j in 0 to c_num_stat-1 generate
     ldst : for i in 0 to c_num_slow-1 generate
@@ -766,6 +993,7 @@ begin
                   and f_opa_eq(f_opa_select_row(r_alias_addr, s), f_opa_select_row(l1d_addr_i, 0))
                   and f_opa_or(f_opa_select_row(r_alias_mask, s) and f_opa_select_row(l1d_mask_i, 0));
   end generate;
+  l1d_alias_o <= f_opa_or(s_alias);
   
   -- Prepare decremented versions of the station references
   s_stata <= f_opa_decrement(r_stata, c_renamers) when r_shift='1' else r_stata;
@@ -783,7 +1011,7 @@ begin
   begin
     if rising_edge(clk_i) then
       if s_shift = '1' then
-        if r_fault_out = '1' then
+        if s_bubble = '1' then
           r_sp_geta <= (others => '0');
           r_sp_getb <= (others => '0');
         else
@@ -808,6 +1036,7 @@ begin
       r_alias       <= (others => '0');
       r_old              <= (others => '0');
       r_oldest_candidate <= (others => '0');
+      r_early       <= (others => '0');
     elsif rising_edge(clk_i) then
       if r_fault_pipe = '1' then -- synchronous clear
         r_issued      <= (others => '1');
@@ -816,11 +1045,14 @@ begin
         r_alias       <= (others => '0');
         r_old              <= (others => '0');
         r_oldest_candidate <= (others => '0');
+        r_early       <= (others => '0');
       else
-        r_issued      <= f_shift(s_new_issued, s_shift);
-        r_final       <= f_shift(s_new_final,  s_shift);
+        -- An empty group shifted in by a drain is born issued and final
+        r_issued      <= f_shift(s_new_issued, s_shift, s_bubble);
+        r_final       <= f_shift(s_new_final,  s_shift, s_bubble);
         r_alias_valid <= f_shift(s_alias_valid, s_shift);
         r_alias       <= f_shift(s_alias and s_new_final, s_shift);
+        r_early       <= f_shift(s_early, s_shift);
         r_old              <= s_old;
         r_oldest_candidate <= s_oldest_candidate;
       end if;
@@ -849,7 +1081,7 @@ begin
             r_statb(i,b) <= s_statb(i+c_renamers,b);
           end loop;
         end loop;
-        if r_fault_out = '1' then
+        if s_bubble = '1' then
           for i in c_num_stat-c_renamers to c_num_stat-1 loop
             for b in 0 to c_stat_wide-1 loop
               r_stata(i,b) <= '1';
@@ -875,52 +1107,79 @@ begin
   stations_0rc : process(rst_n_i, clk_i) is
   begin
     if rst_n_i = '0' then
-      r_fast <= (others => '0');
-      r_slow <= (others => '0');
+      r_fast  <= (others => '0');
+      r_slow  <= (others => '0');
+      r_order <= (others => '0');
+      r_safe  <= (others => '0');
+      r_long  <= (others => '0');
     elsif rising_edge(clk_i) then
       if s_shift = '1' then
-        if r_fault_out = '1' then
-          r_fast(c_num_stat-1 downto c_num_stat-c_renamers) <= (others => '0');
-          r_slow(c_num_stat-1 downto c_num_stat-c_renamers) <= (others => '0');
+        if s_bubble = '1' then
+          r_fast (c_num_stat-1 downto c_num_stat-c_renamers) <= (others => '0');
+          r_slow (c_num_stat-1 downto c_num_stat-c_renamers) <= (others => '0');
+          r_order(c_num_stat-1 downto c_num_stat-c_renamers) <= (others => '0');
+          r_safe (c_num_stat-1 downto c_num_stat-c_renamers) <= (others => '0');
+          r_long (c_num_stat-1 downto c_num_stat-c_renamers) <= (others => '0');
         else
-          r_fast(c_num_stat-1 downto c_num_stat-c_renamers) <= rename_fast_i;
-          r_slow(c_num_stat-1 downto c_num_stat-c_renamers) <= rename_slow_i;
+          r_fast (c_num_stat-1 downto c_num_stat-c_renamers) <= rename_fast_i;
+          r_slow (c_num_stat-1 downto c_num_stat-c_renamers) <= rename_slow_i;
+          r_order(c_num_stat-1 downto c_num_stat-c_renamers) <= rename_order_i;
+          r_safe (c_num_stat-1 downto c_num_stat-c_renamers) <= rename_safe_i;
+          r_long (c_num_stat-1 downto c_num_stat-c_renamers) <= rename_long_i;
         end if;
-        r_fast(c_num_stat-c_renamers-1 downto 0) <= r_fast(c_num_stat-1 downto c_renamers);
-        r_slow(c_num_stat-c_renamers-1 downto 0) <= r_slow(c_num_stat-1 downto c_renamers);
+        r_fast (c_num_stat-c_renamers-1 downto 0) <= r_fast (c_num_stat-1 downto c_renamers);
+        r_slow (c_num_stat-c_renamers-1 downto 0) <= r_slow (c_num_stat-1 downto c_renamers);
+        r_order(c_num_stat-c_renamers-1 downto 0) <= r_order(c_num_stat-1 downto c_renamers);
+        r_safe (c_num_stat-c_renamers-1 downto 0) <= r_safe (c_num_stat-1 downto c_renamers);
+        r_long (c_num_stat-c_renamers-1 downto 0) <= r_long (c_num_stat-1 downto c_renamers);
       end if;
     end if;
   end process;
   
   -- Register the stations, 1-latency with reset
   s_wipe <= f_opa_dup_row(c_executers, r_wipe);
+  s_long1 <= f_opa_dup_row(c_executers, r_long1);
   stations_1rs : process(clk_i, rst_n_i) is
   begin
     if rst_n_i = '0' then
       r_ready      <= (others => '1');
+      r_ready_prev <= (others => '1');
+      r_fast1      <= (others => '0');
+      r_long1      <= (others => '0');
+      r_long_block <= (others => '0');
       r_wipe       <= (others => '0');
       r_schedule0  <= (others => (others => '0'));
+      r_schedule0l <= (others => (others => '0'));
       r_schedule1s <= (others => (others => '0'));
       r_schedule2  <= (others => (others => '0'));
       r_schedule3s <= (others => (others => '0'));
       r_schedule4s <= (others => (others => '0'));
     elsif rising_edge(clk_i) then
+      r_fast1 <= r_fast;
+      r_long1 <= r_long;
+      -- Nothing follows a long op into the slow EUs; its result takes that slot
+      r_long_block <= (others => f_opa_or(s_slow_issue and s_pending_slow and r_long));
       if r_fault_pipe = '1' then
         r_ready      <= (others => '1');
+        r_ready_prev <= (others => '1');
         r_wipe       <= (others => '0');
         r_schedule0  <= (others => (others => '0'));
+        r_schedule0l <= (others => (others => '0'));
         r_schedule1s <= (others => (others => '0'));
         r_schedule2  <= (others => (others => '0'));
         r_schedule3s <= (others => (others => '0'));
         r_schedule4s <= (others => (others => '0'));
       else
         r_ready      <= s_new_ready;
+        r_ready_prev <= s_ready;
         -- wipe does not need to consider r_alias; r_alias => r_final => not in schedule
         r_wipe       <= f_shift(s_nodep or s_retry, s_shift);
         r_schedule0  <= f_opa_transpose(f_opa_concat(
           f_opa_transpose(s_schedule_slow and f_opa_dup_row(c_num_slow, s_pending_slow)), 
           f_opa_transpose(s_schedule_fast and f_opa_dup_row(c_num_fast, s_pending_fast))));
-        r_schedule1s <= f_shift(f_shift(r_schedule0, r_shift) and not s_wipe, s_shift);
+        -- Long ops wait one cycle in r_schedule0l, so their results are tracked one cycle late
+        r_schedule0l <= f_shift(f_shift(r_schedule0 and s_long1, r_shift) and not s_wipe, s_shift);
+        r_schedule1s <= f_shift((f_shift(r_schedule0 and not s_long1, r_shift) or r_schedule0l) and not s_wipe, s_shift);
         r_schedule2  <= r_schedule1s and not s_wipe;
         r_schedule3s <= f_shift(f_shift(r_schedule2, r_shift) and not s_wipe, s_shift);
         r_schedule4s <= f_shift(r_schedule3s and not s_wipe, s_shift);
@@ -49,17 +49,28 @@ entity opa_l1d is
     slow_we_i     : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
     slow_sext_i   : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
     slow_size_i   : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, 1 downto 0);
+    slow_pref_i   : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
+    slow_pc_i     : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     slow_addr_i   : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0);
     slow_data_i   : in  t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0);
     slow_oldest_i : in  std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
     slow_retry_o  : out std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
+    slow_fault_o  : out std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
+    slow_trap_o   : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     slow_data_o   : out t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0);
     
     -- Share information about the addresses we are loading/storing
     issue_store_o : out std_logic;
     issue_load_o  : out std_logic_vector(f_opa_num_slow(g_config)-1 downto 0);
-    issue_addr_o  : out t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_alias_high(g_isa) downto f_opa_alias_low(g_config));
+    issue_addr_o  : out t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_alias_high(g_isa,g_config) downto f_opa_alias_low(g_config));
     issue_mask_o  : out t_opa_matrix(f_opa_num_slow(g_config)-1 downto 0, f_opa_reg_wide(g_config)/8-1 downto 0);
+    issue_alias_i : in  std_logic; -- the store made a younger load reissue
+    
+    -- Train decode with loads that ran ahead of an aliased store or read I/O early
+    decode_wait_o : out std_logic;
+    decode_pc_o   : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+    decode_io_o   : out std_logic;
+    decode_iopc_o : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     
     -- L1d requests action
     dbus_req_o    : out t_opa_dbus_request;
@@ -70,6 +81,7 @@ entity opa_l1d is
     dbus_data_o   : out std_logic_vector(f_opa_dline_size(g_config)*8-1 downto 0);
     
     dbus_busy_i   : in  std_logic; -- can accept a req_i
+    dbus_fill_i   : in  std_logic; -- busy only with the line at dbus_adr_i
     dbus_we_i     : in  std_logic_vector(f_opa_num_dway  (g_config)  -1 downto 0);
     dbus_adr_i    : in  std_logic_vector(f_opa_adr_wide  (g_config)  -1 downto 0);
     dbus_valid_i  : in  std_logic_vector(f_opa_dline_size(g_config)  -1 downto 0);
@@ -85,7 +97,18 @@ entity opa_l1d is
     pbus_pop_o    : out std_logic;
     pbus_full_i   : in  std_logic;
     pbus_err_i    : in  std_logic;
-    pbus_dat_i    : in  std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0));
+    pbus_dat_i    : in  std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0);
+    
+    -- Translation settings from the pbus control register
+    pbus_vm_i     : in  std_logic;
+    pbus_root_i   : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+    pbus_flush_i  : in  std_logic;
+    pbus_trap_i   : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+    
+    -- The oldest op took a page fault
+    pbus_fault_o  : out std_logic;
+    pbus_fpage_o  : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+    pbus_fpc_o    : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa)));
 end opa_l1d;
 
 architecture rtl of opa_l1d is
@@ -119,6 +142,7 @@ architecture rtl of opa_l1d is
   
   -- Each cache entry is laid out as follows:
   --  [(dirty bit) (high-physical-bits) (valid mask) (line data)] * ways
+  -- The tag half (dirty, tag, valid) and line data live in separate memories.
   
   constant c_big_endian    : boolean := f_opa_big_endian(g_isa);
   constant c_num_slow      : natural := f_opa_num_slow(g_config);
@@ -129,7 +153,16 @@ architecture rtl of opa_l1d is
   constant c_page_size     : natural := f_opa_page_size(g_isa);
   constant c_dline_size    : natural := f_opa_dline_size(g_config);
   constant c_alias_low     : natural := f_opa_alias_low(g_config);
-  constant c_alias_high    : natural := f_opa_alias_high(g_isa);
+  constant c_alias_high    : natural := f_opa_alias_high(g_isa,g_config);
+  constant c_alias_tag     : natural := g_config.alias_tag;
+  constant c_lwt_size      : natural := g_config.lwt_size;
+  constant c_dc_wpred      : boolean := g_config.dc_wpred and g_config.dc_ways > 1;
+  constant c_op_align      : natural := f_opa_op_align(g_isa);
+  constant c_dpf_size      : natural := g_config.dpf_size;
+  constant c_sb_size       : natural := g_config.sb_size;
+  constant c_dtlb_ways     : natural := g_config.dtlb_ways;
+  constant c_dc_repl       : t_opa_repl := g_config.dc_repl;
+  constant c_vc_size       : natural := g_config.vc_size;
   constant c_reg_bytes     : natural := c_reg_wide/8;
   constant c_log_reg_wide  : natural := f_opa_log2(c_reg_wide);
   constant c_log_reg_bytes : natural := c_log_reg_wide - 3;
@@ -149,6 +182,8 @@ architecture rtl of opa_l1d is
   constant c_off_high1     : natural := f_opa_choose(c_off_wide=0, c_off_low, c_off_high);
   constant c_sub_high1     : natural := f_opa_choose(c_sub_wide=0, c_sub_low, c_sub_high);
   constant c_ent_wide      : natural := 1 + c_tag_wide + c_line_bytes*9;
+  constant c_tent_wide     : natural := 1 + c_tag_wide + c_line_bytes;
+  constant c_lanes         : natural := f_opa_choose(c_dc_wpred, 1, c_num_ways);
 
   constant c_way_ones  : std_logic_vector(c_num_ways-1 downto 0) := (others => '1');
   constant c_not_valid : std_logic_vector(c_line_bytes-1 downto 0) := (others => '0');
@@ -165,37 +200,75 @@ architecture rtl of opa_l1d is
   type t_line  is array(natural range <>) of std_logic_vector(c_line_bytes*8-1 downto 0);
   type t_mux   is array(natural range <>) of std_logic_vector(c_log_reg_bytes  downto 0);
   type t_size  is array(natural range <>) of std_logic_vector(1 downto 0);
+  type t_atag  is array(natural range <>) of std_logic_vector(c_alias_high downto c_tag_low);
   
   signal s_random : std_logic_vector(c_num_ways-1 downto 0);
+  signal s_repl   : t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
+  signal s_inject : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_pf_adr : std_logic_vector(c_adr_wide-1 downto 0);
+  signal s_drain  : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_walk   : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_wk_adr : std_logic_vector(c_adr_wide-1 downto 0);
+  signal s_sb_adr : std_logic_vector(c_adr_wide-1 downto 0);
+  signal s_sb_mask: std_logic_vector(c_reg_bytes-1 downto 0);
+  signal s_sb_dat : std_logic_vector(c_reg_wide-1 downto 0);
+  signal s_sb_empty : std_logic;
+  signal s_sb_reject: std_logic;
+  signal s_sb_multi : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_fmask  : t_valid(c_num_slow-1 downto 0);
+  signal s_fdat   : t_line (c_num_slow-1 downto 0);
+  signal s_rfwd   : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_rmask  : t_valid(c_num_slow-1 downto 0);
+  signal s_addr   : t_opa_matrix(c_num_slow-1 downto 0, c_reg_wide-1 downto 0);
+  signal s_stb    : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_wen    : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_pref   : std_logic_vector(c_num_slow-1 downto 0);
   signal s_size   : t_size(c_num_slow-1 downto 0);
   signal s_vtag   : t_tag (c_num_slow-1 downto 0);
+  signal s_ptag   : t_tag (c_num_slow-1 downto 0);
+  signal s_tnc    : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_tmiss  : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_tbad   : std_logic_vector(c_num_slow-1 downto 0);
   signal s_vidx   : t_idx (c_num_slow-1 downto 0);
   signal s_voff   : t_off (c_num_slow-1 downto 0);
+  signal s_smask  : t_sel (c_num_slow-1 downto 0);
   signal s_wmask  : t_sel (c_num_slow-1 downto 0);
   signal s_bmask  : t_valid(c_num_slow-1 downto 0);
   signal s_shoff  : t_off (c_num_slow-1 downto 0);
   signal s_shsub  : t_sub (c_num_slow-1 downto 0);
   signal s_pbus   : std_logic_vector(c_num_slow-1 downto 0);
   signal s_adr    : t_opa_matrix(c_num_slow-1 downto 0, c_adr_wide-1 downto 0);
+  signal s_atag   : t_atag(c_num_slow-1 downto 0);
+  signal s_asame  : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_iadr   : t_opa_matrix(c_num_slow-1 downto 0, c_alias_high downto c_alias_low);
   signal s_rent   : t_ent (c_num_slow*c_num_ways-1 downto 0);
   signal s_rdirty : std_logic_vector(c_num_slow*c_num_ways-1 downto 0);
   signal s_rvalid : t_valid(c_num_slow*c_num_ways-1 downto 0);
   signal s_rtag   : t_tag (c_num_slow*c_num_ways-1 downto 0);
   signal s_rdat   : t_line(c_num_slow*c_num_ways-1 downto 0);
+  signal s_lway   : t_way (c_num_slow*c_line_bytes*8-1 downto 0);
+  signal s_lane   : t_line(c_num_slow*c_lanes-1 downto 0);
+  signal s_ldat   : t_line(c_num_slow*c_lanes-1 downto 0);
+  signal s_wmiss  : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_wpred  : t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
   signal s_dirtyw : t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
   signal s_validw : t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
   signal s_matchw : t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
+  signal s_rfill  : t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
   signal s_donew  : t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
   signal s_victimw: t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
-  signal s_sel    : t_line(c_num_slow*c_num_ways-1 downto 0);
-  signal s_rot    : t_reg (c_num_slow*c_num_ways-1 downto 0);
-  signal s_mux    : t_mux (c_num_slow*c_num_ways*c_reg_wide-1 downto 0);
-  signal s_sext   : t_reg (c_num_slow*c_num_ways-1 downto 0);
-  signal s_zext   : t_reg (c_num_slow*c_num_ways-1 downto 0);
+  signal s_sel    : t_line(c_num_slow*c_lanes-1 downto 0);
+  signal s_rot    : t_reg (c_num_slow*c_lanes-1 downto 0);
+  signal s_mux    : t_mux (c_num_slow*c_lanes*c_reg_wide-1 downto 0);
+  signal s_sext   : t_reg (c_num_slow*c_lanes-1 downto 0);
+  signal s_zext   : t_reg (c_num_slow*c_lanes-1 downto 0);
   signal s_clear  : t_opa_matrix(c_num_slow-1 downto 0, c_log_reg_bytes downto 0);
   signal s_ways   : t_way (c_num_slow*c_reg_wide-1 downto 0);
   signal s_0dat   : std_logic_vector(c_reg_wide-1 downto 0);
+  signal s_wb_rot : std_logic_vector(c_reg_wide-1 downto 0);
   signal s_wb_dat : std_logic_vector(c_reg_wide-1 downto 0);
+  signal s_stw    : std_logic;
+  signal s_wbusy  : std_logic;
   signal s_0we    : std_logic_vector(c_num_ways-1 downto 0);
   signal s_wb_we  : std_logic_vector(c_num_ways-1 downto 0);
   signal s_wb_line : t_line (c_num_ways-1 downto 0);
@@ -212,11 +285,28 @@ architecture rtl of opa_l1d is
   signal s_dirty  : std_logic_vector(c_num_slow-1 downto 0);
   signal s_streq  : std_logic;
   signal s_ldreq  : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_dmreq  : std_logic_vector(c_num_slow-1 downto 0);
   signal s_grant  : std_logic_vector(c_num_slow-1 downto 0);
   signal s_st_req : t_opa_dbus_request;
   signal s_cl_req : t_opa_dbus_request;
   signal s_di_req : t_opa_dbus_request;
   signal s_ld_req : t_opa_dbus_request;
+  signal s_gadr   : std_logic_vector(c_adr_wide-1 downto 0);
+  signal s_gway   : std_logic_vector(c_num_ways-1 downto 0);
+  signal s_eadr   : std_logic_vector(c_adr_wide-1 downto 0);
+  signal s_emask  : std_logic_vector(c_line_bytes-1 downto 0);
+  signal s_eline  : std_logic_vector(c_line_bytes*8-1 downto 0);
+  signal s_dwrite : std_logic;
+  signal s_wport  : std_logic;
+  signal s_wblock : std_logic;
+  signal s_wfill  : std_logic;
+  signal s_vc_hit : std_logic;
+  signal r_vcfill : std_logic := '0';
+  signal s_vc_idx : std_logic_vector(c_idx_high downto c_idx_low);
+  signal s_vc_tag : std_logic_vector(c_tag_high downto c_tag_low);
+  signal s_vc_way : std_logic_vector(c_num_ways-1 downto 0);
+  signal s_vc_valid : std_logic_vector(c_line_bytes-1 downto 0);
+  signal s_vc_line  : std_logic_vector(c_line_bytes*8-1 downto 0);
   signal s_grant_way : std_logic_vector(c_num_slow*c_num_ways-1 downto 0);
   signal s_rtag_m    : t_opa_matrix(c_tag_high downto c_tag_low, c_num_slow*c_num_ways-1 downto 0);
   signal s_rvalid_m  : t_opa_matrix(c_line_bytes  -1 downto 0, c_num_slow*c_num_ways-1 downto 0);
@@ -224,11 +314,22 @@ architecture rtl of opa_l1d is
   signal s_alias  : std_logic_vector(c_num_slow-1 downto 0);
   signal s_dretry : std_logic_vector(c_num_slow-1 downto 0);
   signal s_pretry : std_logic_vector(c_num_slow-1 downto 0) := (others => '1');
+  signal s_retry  : std_logic_vector(c_num_slow-1 downto 0);
+  signal s_data   : t_opa_matrix(c_num_slow-1 downto 0, c_reg_wide-1 downto 0);
   
   signal r_stb    : std_logic_vector(c_num_slow-1 downto 0) := (others => '0');
   signal r_we     : std_logic_vector(c_num_slow-1 downto 0) := (others => '0');
   signal r_re     : std_logic_vector(c_num_slow-1 downto 0) := (others => '0');
+  signal r_drain  : std_logic_vector(c_num_slow-1 downto 0) := (others => '0');
+  signal r_steal  : std_logic_vector(c_num_slow-1 downto 0) := (others => '0');
+  signal r_walk   : std_logic_vector(c_num_slow-1 downto 0) := (others => '0');
   signal r_vtag   : t_tag(c_num_slow-1 downto 0);
+  signal r_ptag   : t_tag(c_num_slow-1 downto 0);
+  signal r_tnc    : std_logic_vector(c_num_slow-1 downto 0);
+  signal r_tmiss  : std_logic_vector(c_num_slow-1 downto 0) := (others => '0');
+  signal r_tbad   : std_logic_vector(c_num_slow-1 downto 0) := (others => '0');
+  signal s_pfault : std_logic_vector(c_num_slow-1 downto 0);
+  signal r_pc     : t_opa_matrix(c_num_slow-1 downto 0, c_adr_wide-1 downto c_op_align);
   signal r_vidx   : t_idx(c_num_slow-1 downto 0);
   signal r_voff   : t_off(c_num_slow-1 downto 0);
   signal r_wmask  : t_sel (c_num_slow-1 downto 0);
@@ -238,14 +339,14 @@ architecture rtl of opa_l1d is
   signal r_shsub  : t_sub (c_num_slow-1 downto 0);
   signal r_clear  : t_opa_matrix(c_num_slow-1 downto 0, c_log_reg_bytes downto 0);
   signal r_wb_dat : std_logic_vector(c_reg_wide-1 downto 0);
-  signal r_vidx0  : std_logic_vector(c_idx_high downto c_idx_low);
+  signal r_gidx   : std_logic_vector(c_idx_high downto c_idx_low);
   signal r_random : std_logic_vector(c_num_ways-1 downto 0);
   signal r_rtag   : t_tag (c_num_slow*c_num_ways-1 downto 0);
   signal r_rvalid : t_valid(c_num_slow*c_num_ways-1 downto 0);
   signal r_rdat   : t_line(c_num_slow*c_num_ways-1 downto 0);
   signal r_matchw : t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
   signal r_victimw: t_opa_matrix(c_num_slow-1 downto 0, c_num_ways-1 downto 0);
-  signal r_zext   : t_reg (c_num_slow*c_num_ways-1 downto 0);
+  signal r_zext   : t_reg (c_num_slow*c_lanes-1 downto 0);
   signal r_pbus   : std_logic_vector(c_num_slow-1 downto 0);
   signal r_pdata  : std_logic_vector(c_reg_wide-1 downto 0);
   signal r_grant  : std_logic_vector(c_num_slow-1 downto 0);
@@ -255,6 +356,17 @@ architecture rtl of opa_l1d is
   function f_pow(m : natural) return natural is begin return 8*2**m; end f_pow;
   function f_pow1(m : natural) return natural is begin return 8*(2**m/2); end f_pow1;
   
+  -- XOR the physical page number down to the alias_tag bits shared with issue
+  function f_fold(x : std_logic_vector) return std_logic_vector is
+    variable result : std_logic_vector(c_alias_high downto c_tag_low) := (others => '0');
+  begin
+    for b in x'range loop
+      result(c_tag_low + (b-c_tag_low) mod c_alias_tag) := 
+        result(c_tag_low + (b-c_tag_low) mod c_alias_tag) xor x(b);
+    end loop;
+    return result;
+  end f_fold;
+  
 begin
 
   check : process(clk_i) is
@@ -263,7 +375,9 @@ begin
       -- Validate input control
       assert (f_opa_safe(slow_stb_i)   = '1') report "opa_l1d: slow_stb_i has metavalue" severity failure;
       assert (f_opa_safe(slow_oldest_i)= '1') report "opa_l1d: slow_oldest_i has metavalue" severity failure;
+      assert (f_opa_safe(slow_stb_i and slow_pref_i) = '1') report "opa_l1d: slow_pref_i has metavalue" severity failure;
       assert (f_opa_safe(dbus_busy_i)  = '1') report "opa_l1d: dbus_busy_i has metavalue" severity failure;
+      assert (f_opa_safe(dbus_fill_i)  = '1') report "opa_l1d: dbus_fill_i has metavalue" severity failure;
       -- pbus_stall_i depends on pbus_addr_o, so only valid if we are strobing
       assert (f_opa_safe(r_stb(0) and pbus_stall_i) = '1') report "opa_l1d: pbus_stall_i has metavalue" severity failure;
       assert (f_opa_safe(pbus_full_i)  = '1') report "opa_l1d: pbus_full_i has metavalue" severity failure;
@@ -282,8 +396,7 @@ begin
     random : block is
       signal s_random_idx : std_logic_vector(f_opa_log2(c_num_ways)-1 downto 0);
     begin
-      -- We use random way cache replacement policy
-      -- LRU is not possible b/c it requires modification on every access
+      -- Entropy for the random way replacement policy
       lfsr : opa_lfsr
         generic map(
           g_bits   => f_opa_log2(c_num_ways))
@@ -302,12 +415,210 @@ begin
   one_way : if c_num_ways = 1 generate
     s_random(0) <= '1';
   end generate;
+  
+  -- Choose the way a refill replaces. Random needs no state. Tree-PLRU and
+  -- 2-bit SRRIP keep state per line in registers (not memory), as they must
+  -- be modified by every hit and every fill. The state is read with the index.
+  random_repl : if c_num_ways = 1 or c_dc_repl = T_OPA_RANDOM generate
+    ports : for p in 0 to c_num_slow-1 generate
+      ways : for w in 0 to c_num_ways-1 generate
+        s_repl(p,w) <= s_random(w);
+      end generate;
+    end generate;
+  end generate;
+  
+  plru_repl : if c_num_ways > 1 and c_dc_repl = T_OPA_PLRU generate
+    b : block is
+      constant c_levels : natural := f_opa_log2(c_num_ways);
+      
+      -- Node n has children 2n and 2n+1; leaf c_num_ways+w is way w
+      type t_tree is array(natural range <>) of std_logic_vector(c_num_ways-1 downto 1);
+      
+      signal r_tree : t_tree(2**c_idx_wide-1 downto 0) := (others => (others => '0'));
+      signal r_node : t_tree(c_num_slow-1 downto 0);
+      
+      -- Point every node on the path to way w away from it
+      function f_touch(x : std_logic_vector; w : natural) return std_logic_vector is
+        variable result : std_logic_vector(x'range) := x;
+        variable n      : natural := c_num_ways + w;
+      begin
+        for l in 0 to c_levels-1 loop
+          result(n/2) := f_opa_bit(n mod 2 = 0);
+          n := n/2;
+        end loop;
+        return result;
+      end f_touch;
+      
+      -- Follow the nodes to the pseudo least recently used way
+      function f_victim(x : std_logic_vector) return std_logic_vector is
+        variable result : std_logic_vector(c_num_ways-1 downto 0) := (others => '0');
+        variable n      : natural := 1;
+      begin
+        for l in 0 to c_levels-1 loop
+          if x(n) = '1' then
+            n := 2*n+1;
+          else
+            n := 2*n;
+          end if;
+        end loop;
+        result(n - c_num_ways) := '1';
+        return result;
+      end f_victim;
+    begin
+      ports : for p in 0 to c_num_slow-1 generate
+        ways : for w in 0 to c_num_ways-1 generate
+          s_repl(p,w) <= f_victim(r_node(p))(w);
+        end generate;
+      end generate;
+      
+      main : process(clk_i) is
+      begin
+        if rising_edge(clk_i) then
+          for p in 0 to c_num_slow-1 loop
+            if f_opa_safe(s_vidx(p)) = '1' then
+              r_node(p) <= r_tree(to_integer(unsigned(s_vidx(p))));
+            else
+              r_node(p) <= (others => 'X');
+            end if;
+          end loop;
+          for w in 0 to c_num_ways-1 loop
+            if s_we(w) = '1' then
+              r_tree(to_integer(unsigned(s_widx))) <= f_touch(r_tree(to_integer(unsigned(s_widx))), w);
+            end if;
+          end loop;
+          for p in 0 to c_num_slow-1 loop
+            for w in 0 to c_num_ways-1 loop
+              if ((r_re(p) or r_we(p)) and s_matchw(p,w)) = '1' then
+                r_tree(to_integer(unsigned(r_vidx(p)))) <= f_touch(r_tree(to_integer(unsigned(r_vidx(p)))), w);
+              end if;
+            end loop;
+          end loop;
+        end if;
+      end process;
+    end block;
+  end generate;
+  
+  rrip_repl : if c_num_ways > 1 and c_dc_repl = T_OPA_RRIP generate
+    b : block is
+      -- Two bits of re-reference prediction per way: 0 = near ... 3 = distant
+      type t_rrpv is array(natural range <>) of std_logic_vector(2*c_num_ways-1 downto 0);
+      
+      signal r_rrpv : t_rrpv(2**c_idx_wide-1 downto 0) := (others => (others => '1'));
+      signal r_set  : t_rrpv(c_num_slow-1 downto 0);
+      signal r_iidx : std_logic_vector(c_idx_high downto c_idx_low);
+      signal r_iway : std_logic_vector(c_num_ways-1 downto 0) := (others => '0');
+      
+      function f_rrpv(x : std_logic_vector; w : natural) return unsigned is
+      begin
+        return unsigned(x(2*w+1 downto 2*w));
+      end f_rrpv;
+      
+      -- The first way predicted most distant; ageing the set preserves this order
+      function f_victim(x : std_logic_vector) return std_logic_vector is
+        variable result : std_logic_vector(c_num_ways-1 downto 0) := (others => '0');
+        variable best   : natural := c_num_ways-1;
+      begin
+        for w in c_num_ways-2 downto 0 loop
+          if f_rrpv(x, w) >= f_rrpv(x, best) then
+            best := w;
+          end if;
+        end loop;
+        result(best) := '1';
+        return result;
+      end f_victim;
+      
+      -- Age the set until some way is distant, then insert way w as long (2)
+      function f_insert(x : std_logic_vector; w : natural) return std_logic_vector is
+        variable result : std_logic_vector(x'range);
+        variable top    : unsigned(1 downto 0) := "00";
+      begin
+        for v in 0 to c_num_ways-1 loop
+          if f_rrpv(x, v) > top then
+            top := f_rrpv(x, v);
+          end if;
+        end loop;
+        for v in 0 to c_num_ways-1 loop
+          result(2*v+1 downto 2*v) := std_logic_vector(f_rrpv(x, v) + (3 - top));
+        end loop;
+        result(2*w+1 downto 2*w) := "10";
+        return result;
+      end f_insert;
+      
+      function f_hit(x : std_logic_vector; w : natural) return std_logic_vector is
+        variable result : std_logic_vector(x'range) := x;
+      begin
+        result(2*w+1 downto 2*w) := "00";
+        return result;
+      end f_hit;
+    begin
+      ports : for p in 0 to c_num_slow-1 generate
+        ways : for w in 0 to c_num_ways-1 generate
+          s_repl(p,w) <= f_victim(r_set(p))(w);
+        end generate;
+      end generate;
+      
+      -- A refill writes its line once per arriving word; only the first inserts
+      -- (the fill is remembered until dbus goes idle)
+      main : process(clk_i) is
+      begin
+        if rising_edge(clk_i) then
+          for p in 0 to c_num_slow-1 loop
+            if f_opa_safe(s_vidx(p)) = '1' then
+              r_set(p) <= r_rrpv(to_integer(unsigned(s_vidx(p))));
+            else
+              r_set(p) <= (others => 'X');
+            end if;
+          end loop;
+          if s_wfill = '1' then
+            r_iidx <= s_widx;
+            r_iway <= s_we;
+          elsif dbus_busy_i = '0' then
+            r_iway <= (others => '0');
+          end if;
+          for w in 0 to c_num_ways-1 loop
+            if (s_we(w) and s_wfill and not (r_iway(w) and f_opa_eq(r_iidx, s_widx))) = '1' then
+              r_rrpv(to_integer(unsigned(s_widx))) <= f_insert(r_rrpv(to_integer(unsigned(s_widx))), w);
+            end if;
+          end loop;
+          for p in 0 to c_num_slow-1 loop
+            for w in 0 to c_num_ways-1 loop
+              if ((r_re(p) or r_we(p)) and s_matchw(p,w)) = '1' then
+                r_rrpv(to_integer(unsigned(r_vidx(p)))) <= f_hit(r_rrpv(to_integer(unsigned(r_vidx(p)))), w);
+              end if;
+            end loop;
+          end loop;
+        end if;
+      end process;
+    end block;
+  end generate;
+
+  -- Prefetches are loads with re=we=0; they never retry and skip pbus.
+  -- Hardware prefetches borrow a port the slow EUs left idle this cycle.
+  -- The store buffer drains through port 0 the same way (taking priority).
+  -- Page table walks load their PTEs through port 0 as prefetches.
+  s_stb  <=  slow_stb_i or s_inject or s_drain or s_walk;
+  s_wen  <= (slow_we_i and not s_inject and not s_walk) or s_drain;
+  s_pref <= (slow_pref_i or s_inject or s_walk) and not s_drain;
+  inject : for p in 0 to c_num_slow-1 generate
+    bits : for b in 0 to c_reg_wide-1 generate
+      low : if b < c_adr_wide generate
+        s_addr(p,b) <= 
+          s_sb_adr(b) when s_drain (p) = '1' else
+          s_wk_adr(b) when s_walk  (p) = '1' else
+          s_pf_adr(b) when s_inject(p) = '1' else
+          slow_addr_i(p,b);
+      end generate;
+      high : if b >= c_adr_wide generate
+        s_addr(p,b) <= slow_addr_i(p,b) and not (s_inject(p) or s_drain(p) or s_walk(p));
+      end generate;
+    end generate;
+  end generate;
 
   rdports : for p in 0 to c_num_slow-1 generate
     -- Select the address lines
-    s_size(p) <= f_opa_select_row(slow_size_i, p);
-    s_vtag(p) <= f_opa_select_row(slow_addr_i, p)(c_tag_high downto c_tag_low);
-    s_vidx(p) <= f_opa_select_row(slow_addr_i, p)(c_idx_high downto c_idx_low);
+    s_size(p) <= c_opa_ldst_word when (s_inject(p) or s_drain(p) or s_walk(p)) = '1' else f_opa_select_row(slow_size_i, p);
+    s_vtag(p) <= f_opa_select_row(s_addr, p)(c_tag_high downto c_tag_low);
+    s_vidx(p) <= f_opa_select_row(s_addr, p)(c_idx_high downto c_idx_low);
     
     -- Calculate the sub-word byte-mask and rotation
     sub : if c_sub_wide > 0 generate
@@ -315,7 +626,7 @@ begin
         signal s_vsub  : t_sub (c_num_slow-1 downto 0);
         signal s_sizes : t_sub (c_num_slow-1 downto 0);
       begin
-        s_vsub(p) <= f_opa_select_row(slow_addr_i, p)(c_sub_high downto c_sub_low);
+        s_vsub(p) <= f_opa_select_row(s_addr, p)(c_sub_high downto c_sub_low);
         
         -- 1-hot decode the size (note: 0 = full size)
         size : for s in c_sub_low to c_sub_high generate
@@ -325,7 +636,7 @@ begin
         little : if not c_big_endian generate
           -- Derive the word byte-select mask for the operation
           wmask : for b in 0 to c_reg_bytes-1 generate
-            s_wmask(p)(b) <= not f_opa_lt(unsigned(s_sizes(p))-1, b - unsigned(s_vsub(p)));
+            s_smask(p)(b) <= not f_opa_lt(unsigned(s_sizes(p))-1, b - unsigned(s_vsub(p)));
           end generate;
           -- Derive the sub-word rotation
           s_shsub(p) <= s_vsub(p);
@@ -333,7 +644,7 @@ begin
         
         big : if c_big_endian generate
           wmask : for b in 0 to c_reg_bytes-1 generate
-            s_wmask(p)(c_reg_bytes-1-b) <= not f_opa_lt(unsigned(s_sizes(p))-1, b - unsigned(s_vsub(p)));
+            s_smask(p)(c_reg_bytes-1-b) <= not f_opa_lt(unsigned(s_sizes(p))-1, b - unsigned(s_vsub(p)));
           end generate;
           s_shsub(p) <= std_logic_vector(unsigned(s_vsub(p)) + unsigned(s_sizes(p)));
         end generate;
@@ -341,11 +652,13 @@ begin
     end generate;
     nosub : if c_sub_wide = 0 generate
       s_shsub(p) <= (others => '0');
-      s_wmask(p) <= (others => '1');
+      s_smask(p) <= (others => '1');
     end generate;
+    -- A drained store keeps the byte lanes it merged
+    s_wmask(p) <= s_sb_mask when s_drain(p) = '1' else s_smask(p);
     
     off : if c_off_wide > 0 generate
-      s_voff(p) <= f_opa_select_row(slow_addr_i, p)(c_off_high downto c_off_low);
+      s_voff(p) <= f_opa_select_row(s_addr, p)(c_off_high downto c_off_low);
       
       -- Which bytes of the line get accessed?
       little : if not c_big_endian generate
@@ -367,8 +680,8 @@ begin
     end generate;
     
     -- If we miss, which word to load first? (we wrap around within the line)
-    tag_bits : for b in s_wtag'range generate -- !!! use physical address
-      s_adr(p,b) <= r_vtag(p)(b);
+    tag_bits : for b in s_wtag'range generate
+      s_adr(p,b) <= r_ptag(p)(b);
     end generate;
     idx_bits : for b in s_widx'range generate
       s_adr(p,b) <= r_vidx(p)(b);
@@ -384,17 +697,42 @@ begin
       end generate;
     end generate;
     
-    -- Highest physical bit indicates if this is for dbus or pbus
-    s_pbus(p) <= s_adr(p,c_adr_wide-1);
+    -- Highest physical bit or a nocache page indicates if this is for dbus or pbus
+    s_pbus(p) <= s_adr(p,c_adr_wide-1) or r_tnc(p);
+    
+    -- A load of the line dbus is refilling sees the words which have arrived
+    -- in the array already; forward the word arriving this cycle as well.
+    -- dbus writes the tag with the first (critical) word, which the array read
+    -- one cycle earlier could not see, so the way being written counts as a
+    -- tag match and its valid bits come from dbus alone (s_rfill).
+    s_rfwd(p) <= s_dwrite and f_opa_eq(dbus_adr_i(c_tag_high downto c_idx_low), r_ptag(p) & r_vidx(p));
+    rmask : for b in 0 to c_line_bytes-1 generate
+      s_rmask(p)(b) <= s_rfwd(p) and dbus_valid_i(b);
+    end generate;
     
     -- The L1d ways
     -- Note: the OPA_NEW bypass is indeed necessary.
     -- If you have back-to-back writes to cache, you will lose data
     -- if the second write does not see the result of the first.
     ways : for w in 0 to c_num_ways-1 generate
-      l1d : opa_dpram
+      tags : opa_dpram
+        generic map(
+          g_width  => c_tent_wide,
+          g_size   => 2**c_idx_wide,
+          g_equal  => OPA_NEW,
+          g_regin  => true,
+          g_regout => false)
+        port map(
+          clk_i    => clk_i,
+          rst_n_i  => rst_n_i,
+          r_addr_i => s_vidx(p),
+          r_data_o => s_rent(f_idx(p,w))(c_ent_wide-1 downto 8*c_line_bytes),
+          w_en_i   => s_we(w),
+          w_addr_i => s_widx,
+          w_data_i => s_went(w)(c_ent_wide-1 downto 8*c_line_bytes));
+      data : opa_dpram
         generic map(
-          g_width  => c_ent_wide,
+          g_width  => 8*c_line_bytes,
           g_size   => 2**c_idx_wide,
           g_equal  => OPA_NEW,
           g_regin  => true,
@@ -403,10 +741,10 @@ begin
           clk_i    => clk_i,
           rst_n_i  => rst_n_i,
           r_addr_i => s_vidx(p),
-          r_data_o => s_rent(f_idx(p,w)),
+          r_data_o => s_rent(f_idx(p,w))(8*c_line_bytes-1 downto 0),
           w_en_i   => s_we(w),
           w_addr_i => s_widx,
-          w_data_i => s_went(w));
+          w_data_i => s_went(w)(8*c_line_bytes-1 downto 0));
       
       -- Split out the line contents (dirty, tag, valid, data)
       s_rdirty(f_idx(p,w)) <= s_rent(f_idx(p,w))(c_ent_wide-1);
@@ -416,15 +754,40 @@ begin
       
       -- A load is done if the tag matches and the valid bits cover the request
       s_dirtyw(p,w) <= s_rdirty(f_idx(p,w));
-      s_validw(p,w) <= f_opa_and(not r_bmask(p) or s_rvalid(f_idx(p,w)));
-      s_matchw(p,w) <= f_opa_eq(r_vtag(p), s_rtag(f_idx(p,w)));
+      s_rfill (p,w) <= s_rfwd(p) and dbus_we_i(w) and not r_we(p);
+      s_validw(p,w) <= f_opa_and(not r_bmask(p) or f_opa_mux(s_rfill(p,w), c_not_valid, s_rvalid(f_idx(p,w))) or s_fmask(p) or s_rmask(p));
+      s_matchw(p,w) <= f_opa_eq(r_ptag(p), s_rtag(f_idx(p,w))) or s_rfill(p,w);
       s_donew (p,w) <= s_matchw(p,w) and (r_we(p) or s_validw(p,w));
       
       -- Would this way be the victim on a refill?
-      s_victimw(p,w) <= f_opa_mux(s_match(p), s_matchw(p,w), s_random(w));
+      s_victimw(p,w) <= f_opa_mux(s_match(p), s_matchw(p,w), s_repl(p,w));
+      
+      -- Gather the line data of each way for the predicted way mux
+      lway : for b in 0 to c_line_bytes*8-1 generate
+        s_lway(p*c_line_bytes*8+b)(w) <= s_rdat(f_idx(p,w))(b);
+      end generate;
+    end generate;
+    
+    -- Without way prediction, every way is aligned and extended; the tag picks one later
+    -- With it, only the predicted way is, and a hit in another way retries the load
+    lanes : for w in 0 to c_lanes-1 generate
+      direct : if not c_dc_wpred generate
+        s_lane(f_idx(p,w)) <= s_rdat(f_idx(p,w));
+      end generate;
+      predict : if c_dc_wpred generate
+        bits : for b in 0 to c_line_bytes*8-1 generate
+          s_lane(f_idx(p,w))(b) <= f_opa_or(s_lway(p*c_line_bytes*8+b) and f_opa_select_row(s_wpred, p));
+        end generate;
+      end generate;
       
       -- If there is more than one word in the line, pick the one we want
-      s_sel(f_idx(p,w)) <= f_opa_rotate_right(s_rdat(f_idx(p,w)), unsigned(r_shoff(p)), c_reg_wide);
+      -- Overlay bytes forwarded from the store buffer, then those dbus is refilling
+      fbytes : for b in 0 to c_line_bytes-1 generate
+        s_ldat(f_idx(p,w))((b+1)*8-1 downto b*8) <= 
+          f_opa_mux(s_fmask(p)(b), s_fdat(p)((b+1)*8-1 downto b*8), 
+          f_opa_mux(s_rmask(p)(b), dbus_data_i((b+1)*8-1 downto b*8), s_lane(f_idx(p,w))((b+1)*8-1 downto b*8)));
+      end generate;
+      s_sel(f_idx(p,w)) <= f_opa_rotate_right(s_ldat(f_idx(p,w)), unsigned(r_shoff(p)), c_reg_wide);
       
       -- Rotate read line data to align with requested load
       big_rotate : if c_big_endian generate
@@ -465,45 +828,889 @@ begin
   -- Pick the matching way for load result
   out_ports : for p in 0 to c_num_slow-1 generate
     bits : for b in 0 to c_reg_wide-1 generate
+      direct : if not c_dc_wpred generate
+        ways : for w in 0 to c_num_ways-1 generate
+          s_ways(f_idx(p,b))(w) <= r_zext(f_idx(p,w))(b);
+        end generate;
+        s_data(p,b) <= f_opa_or(s_ways(f_idx(p,b)) and f_opa_select_row(r_matchw, p)) or
+                       (r_pdata(b) and r_pbus(p));
+      end generate;
+      predict : if c_dc_wpred generate
+        s_data(p,b) <= (r_zext(f_idx(p,0))(b) and not r_pbus(p)) or (r_pdata(b) and r_pbus(p));
+      end generate;
+    end generate;
+  end generate;
+  slow_data_o <= s_data;
+  
+  -- Predict each line's most recently used way (refilled or hit)
+  -- Each port reads its own small copy, but all copies share one write port:
+  -- a refill claims it, otherwise the lowest port whose hit was mispredicted.
+  -- A correctly predicted hit already matches the stored way, so needs no write.
+  wpred : if c_dc_wpred generate
+    type t_wnum is array(natural range <>) of std_logic_vector(f_opa_log2(c_num_ways)-1 downto 0);
+    
+    signal s_mru  : t_wnum(c_num_slow-1 downto 0);
+    signal s_mwe  : std_logic;
+    signal s_midx : std_logic_vector(c_idx_high downto c_idx_low);
+    signal s_mway : std_logic_vector(f_opa_log2(c_num_ways)-1 downto 0);
+  begin
+    ports : for p in 0 to c_num_slow-1 generate
+      s_wmiss(p) <= (r_re(p) or r_walk(p)) and f_opa_or(f_opa_select_row(s_donew, p))
+                    and not f_opa_or(f_opa_select_row(s_donew, p) and f_opa_select_row(s_wpred, p));
+      
+      mru : opa_dpram
+        generic map(
+          g_width  => f_opa_log2(c_num_ways),
+          g_size   => 2**c_idx_wide,
+          g_equal  => OPA_OLD,
+          g_regin  => true,
+          g_regout => false)
+        port map(
+          clk_i    => clk_i,
+          rst_n_i  => rst_n_i,
+          r_addr_i => s_vidx(p),
+          r_data_o => s_mru(p),
+          w_en_i   => s_mwe,
+          w_addr_i => s_midx,
+          w_data_i => s_mway);
+      
       ways : for w in 0 to c_num_ways-1 generate
-        s_ways(f_idx(p,b))(w) <= r_zext(f_idx(p,w))(b);
+        s_wpred(p,w) <= f_opa_mux(s_rfwd(p), dbus_we_i(w), f_opa_eq(unsigned(s_mru(p)), w));
       end generate;
-      slow_data_o(p,b) <= f_opa_or(s_ways(f_idx(p,b)) and f_opa_select_row(r_matchw, p)) or
-                          (r_pdata(b) and r_pbus(p));
     end generate;
+    
+    write : process(s_we, s_widx, s_wmiss, s_donew, r_vidx) is
+    begin
+      s_mwe  <= '0';
+      s_midx <= s_widx;
+      s_mway <= (others => '0');
+      for p in c_num_slow-1 downto 0 loop
+        if s_wmiss(p) = '1' then
+          s_mwe  <= '1';
+          s_midx <= r_vidx(p);
+          for w in 0 to c_num_ways-1 loop
+            if s_donew(p,w) = '1' then
+              s_mway <= std_logic_vector(to_unsigned(w, s_mway'length));
+            end if;
+          end loop;
+        end if;
+      end loop;
+      for w in 0 to c_num_ways-1 loop
+        if s_we(w) = '1' then
+          s_mwe  <= '1';
+          s_midx <= s_widx;
+          s_mway <= std_logic_vector(to_unsigned(w, s_mway'length));
+        end if;
+      end loop;
+    end process;
+  end generate;
+  nowpred : if not c_dc_wpred generate
+    s_wmiss <= (others => '0');
+  end generate;
+  
+  -- Stride prefetcher, trained by completed loads and indexed by their PC.
+  -- Falls back to the next line on a demand miss. Each candidate is recorded
+  -- in a short history; a later load to a recorded line counts as useful, an
+  -- entry evicted unused counts against. Candidates are only issued while the
+  -- usefulness counter is in its upper half; otherwise they just keep score.
+  -- Loads train with their physical address and prefetches skip the TLB, so
+  -- a candidate outside the page of the load which triggered it is dropped;
+  -- the next virtual page need not follow it in physical memory.
+  dpf : if c_dpf_size > 0 generate
+    b : block is
+      constant c_dpf_wide : natural := f_opa_log2(c_dpf_size);
+      constant c_dpf_hist : natural := 4;
+      constant c_dpf_dist : natural := 2; -- prefetch 2**dist strides ahead
+      
+      type t_uadr is array(natural range <>) of unsigned(c_adr_wide-1 downto 0);
+      type t_conf is array(natural range <>) of unsigned(1 downto 0);
+      type t_line is array(natural range <>) of std_logic_vector(c_adr_wide-1 downto c_idx_low);
+      
+      signal r_last   : t_uadr(c_dpf_size-1 downto 0) := (others => (others => '0'));
+      signal r_stride : t_uadr(c_dpf_size-1 downto 0) := (others => (others => '0'));
+      signal r_conf   : t_conf(c_dpf_size-1 downto 0) := (others => (others => '0'));
+      signal r_hist   : t_line(c_dpf_hist-1 downto 0) := (others => (others => '0'));
+      signal r_hvalid : std_logic_vector(c_dpf_hist-1 downto 0) := (others => '0');
+      signal r_hidx   : unsigned(f_opa_log2(c_dpf_hist)-1 downto 0) := (others => '0');
+      signal r_useful : unsigned(2 downto 0) := "100";
+      signal r_cand   : std_logic_vector(c_adr_wide-1 downto 0);
+      signal r_cand_v : std_logic := '0';
+      
+      signal s_done   : std_logic_vector(c_num_slow-1 downto 0);
+      signal s_train  : std_logic_vector(c_num_slow-1 downto 0);
+      signal s_miss   : std_logic_vector(c_num_slow-1 downto 0);
+      signal s_tadr   : std_logic_vector(c_adr_wide-1 downto 0);
+      signal s_madr   : std_logic_vector(c_adr_wide-1 downto 0);
+      signal s_tpc    : std_logic_vector(c_adr_wide-1 downto c_op_align);
+      signal s_entry  : natural range 0 to c_dpf_size-1;
+      signal s_delta  : unsigned(c_adr_wide-1 downto 0);
+      signal s_same   : std_logic;
+      signal s_stride : std_logic;
+      signal s_cand   : std_logic_vector(c_adr_wide-1 downto 0);
+      signal s_cand_v : std_logic;
+      signal s_src    : std_logic_vector(c_adr_wide-1 downto 0);
+      signal s_cross  : std_logic;
+      signal s_self   : std_logic;
+      signal s_seen   : std_logic_vector(c_dpf_hist-1 downto 0);
+      signal s_used   : std_logic_vector(c_dpf_hist-1 downto 0);
+      signal s_new    : std_logic;
+      signal s_evict  : std_logic;
+    begin
+      -- Train on one completed load per cycle
+      s_done  <= r_re and not s_pbus and not s_retry;
+      s_train <= f_opa_pick_small(s_done);
+      s_miss  <= f_opa_pick_small(r_re and s_ldreq);
+      s_tadr  <= f_opa_product(f_opa_transpose(s_adr), s_train);
+      s_madr  <= f_opa_product(f_opa_transpose(s_adr), s_miss);
+      s_tpc   <= f_opa_product(f_opa_transpose(r_pc),  s_train);
+      s_entry <= to_integer(unsigned(s_tpc(c_op_align+c_dpf_wide-1 downto c_op_align)));
+      
+      s_delta  <= unsigned(s_tadr) - r_last(s_entry);
+      s_same   <= f_opa_eq(s_delta, r_stride(s_entry));
+      s_stride <= f_opa_or(s_done) and s_same and r_conf(s_entry)(1) and f_opa_or(std_logic_vector(s_delta));
+      
+      s_cand <= 
+        std_logic_vector(unsigned(s_tadr) + shift_left(s_delta, c_dpf_dist)) when s_stride = '1' else
+        std_logic_vector(unsigned(s_madr) + c_line_bytes);
+      s_src    <= s_tadr when s_stride = '1' else s_madr;
+      s_cross  <= not f_opa_eq(s_cand(c_tag_high downto c_tag_low), s_src(c_tag_high downto c_tag_low));
+      s_cand_v <= (s_stride or f_opa_or(s_miss)) and not s_cross;
+      s_self   <= s_stride and f_opa_eq(s_cand(c_adr_wide-1 downto c_idx_low), s_tadr(c_adr_wide-1 downto c_idx_low));
+      
+      history : for i in 0 to c_dpf_hist-1 generate
+        s_seen(i) <= f_opa_eq(r_hist(i), s_cand(c_adr_wide-1 downto c_idx_low));
+        s_used(i) <= r_hvalid(i) and f_opa_or(s_done) and f_opa_eq(r_hist(i), s_tadr(c_adr_wide-1 downto c_idx_low));
+      end generate;
+      
+      s_new   <= s_cand_v and not s_self and not f_opa_or(s_seen);
+      s_evict <= s_new and f_opa_index(r_hvalid and not s_used, r_hidx);
+      
+      -- Issue into the highest idle port (port 0 does the stores)
+      s_inject <= f_opa_pick_big(not (slow_stb_i or s_drain or s_walk)) when r_cand_v = '1' else (others => '0');
+      s_pf_adr <= r_cand;
+      
+      control : process(clk_i, rst_n_i) is
+      begin
+        if rst_n_i = '0' then
+          r_conf   <= (others => (others => '0'));
+          r_hvalid <= (others => '0');
+          r_hidx   <= (others => '0');
+          r_useful <= "100";
+          r_cand_v <= '0';
+        elsif rising_edge(clk_i) then
+          if f_opa_or(s_done) = '1' then
+            if s_same = '1' then
+              if r_conf(s_entry) /= "11" then
+                r_conf(s_entry) <= r_conf(s_entry) + 1;
+              end if;
+            elsif r_conf(s_entry) /= "00" then
+              r_conf(s_entry) <= r_conf(s_entry) - 1;
+            end if;
+          end if;
+          
+          r_hvalid <= r_hvalid and not s_used;
+          if s_new = '1' then
+            r_hvalid(to_integer(r_hidx)) <= '1';
+            r_hidx <= r_hidx + 1;
+          end if;
+          
+          if f_opa_or(s_used) = '1' and s_evict = '0' and r_useful /= "111" then
+            r_useful <= r_useful + 1;
+          end if;
+          if f_opa_or(s_used) = '0' and s_evict = '1' and r_useful /= "000" then
+            r_useful <= r_useful - 1;
+          end if;
+          
+          if (s_new and r_useful(2)) = '1' then
+            r_cand_v <= '1';
+          elsif f_opa_or(s_inject) = '1' then
+            r_cand_v <= '0';
+          end if;
+        end if;
+      end process;
+      
+      main : process(clk_i) is
+      begin
+        if rising_edge(clk_i) then
+          if f_opa_or(s_done) = '1' then
+            r_last(s_entry) <= unsigned(s_tadr);
+            if s_same = '0' and r_conf(s_entry) = "00" then
+              r_stride(s_entry) <= s_delta;
+            end if;
+          end if;
+          if s_new = '1' then
+            r_hist(to_integer(r_hidx)) <= s_cand(c_adr_wide-1 downto c_idx_low);
+          end if;
+          if (s_new and r_useful(2)) = '1' then
+            r_cand <= s_cand;
+          end if;
+        end if;
+      end process;
+    end block;
+  end generate;
+  nodpf : if c_dpf_size = 0 generate
+    s_inject <= (others => '0');
+    s_pf_adr <= (others => '-');
+  end generate;
+  
+  -- Store buffer between the slow EUs and L1d. The oldest store completes as
+  -- soon as it is buffered; it no longer waits for the write port or a miss.
+  -- Stores to an already buffered word merge their byte lanes into it.
+  -- Entries drain in order through port 0, when idle or when the buffer is full.
+  -- Loads overlay the buffered lanes of their word onto the line they read.
+  -- Only the oldest store is accepted (slow_oldest_i), so every entry is already
+  -- committed; there is no speculative state and nothing to drop on a flush.
+  sb : if c_sb_size > 0 generate
+    b : block is
+      type t_sadr is array(natural range <>) of std_logic_vector(c_adr_wide-1 downto c_off_low);
+      
+      signal r_valid : std_logic_vector(c_sb_size-1 downto 0) := (others => '0');
+      signal r_sadr  : t_sadr(c_sb_size-1 downto 0);
+      signal r_smask : t_sel (c_sb_size-1 downto 0);
+      signal r_sdat  : t_reg (c_sb_size-1 downto 0);
+      signal s_wadr  : std_logic_vector(c_adr_wide-1 downto c_off_low);
+      signal s_lock  : std_logic;
+      signal s_merge : std_logic_vector(c_sb_size-1 downto 0);
+      signal s_store : std_logic;
+      signal s_push  : std_logic;
+      signal s_pop   : std_logic;
+      signal s_fhit  : t_opa_matrix(c_num_slow-1 downto 0, c_sb_size-1 downto 0);
+    begin
+      s_wadr <= f_opa_select_row(s_adr, 0)(c_adr_wide-1 downto c_off_low);
+      
+      -- The head may not be modified while it is being written to L1d
+      s_lock <= s_drain(0) or r_drain(0);
+      merge : for e in 0 to c_sb_size-1 generate
+        s_merge(e) <= r_valid(e) and f_opa_eq(r_sadr(e), s_wadr) and (f_opa_bit(e > 0) or not s_lock);
+      end generate;
+      
+      s_store     <= r_we(0) and not r_drain(0) and not r_tmiss(0) and slow_oldest_i(0) and not s_pbus(0);
+      s_sb_reject <= not f_opa_or(s_merge) and r_valid(c_sb_size-1);
+      s_push      <= s_store and not s_sb_reject;
+      s_pop       <= r_drain(0) and not s_wblock;
+      s_sb_empty  <= not r_valid(0);
+      
+      s_drain(0) <= r_valid(0) and not r_drain(0) and not (dbus_busy_i and not dbus_fill_i) and 
+                    (not slow_stb_i(0) or r_valid(c_sb_size-1));
+      others_drain : if c_num_slow > 1 generate
+        s_drain(c_num_slow-1 downto 1) <= (others => '0');
+      end generate;
+      
+      s_sb_adr(c_adr_wide-1 downto c_off_low) <= r_sadr(0);
+      low_adr : if c_off_low > 0 generate
+        s_sb_adr(c_off_low-1 downto 0) <= (others => '0');
+      end generate;
+      s_sb_mask <= r_smask(0);
+      s_sb_dat  <= r_sdat(0);
+      
+      -- A load matching two entries (a store to the head while it drains) retries
+      forward : for p in 0 to c_num_slow-1 generate
+        ents : for e in 0 to c_sb_size-1 generate
+          s_fhit(p,e) <= r_re(p) and r_valid(e) and 
+            f_opa_eq(r_sadr(e), f_opa_select_row(s_adr, p)(c_adr_wide-1 downto c_off_low));
+        end generate;
+        s_sb_multi(p) <= f_opa_or(f_opa_select_row(s_fhit, p) and not f_opa_pick_small(f_opa_select_row(s_fhit, p)));
+      end generate;
+      
+      lanes : process(s_fhit, r_smask, r_sdat, r_shoff) is
+        variable v_mask : std_logic_vector(c_reg_bytes-1 downto 0);
+        variable v_dat  : std_logic_vector(c_reg_wide-1 downto 0);
+      begin
+        for p in 0 to c_num_slow-1 loop
+          v_mask := (others => '0');
+          v_dat  := (others => '0');
+          for e in 0 to c_sb_size-1 loop
+            if s_fhit(p,e) = '1' then
+              v_mask := v_mask or r_smask(e);
+              v_dat  := v_dat  or r_sdat (e);
+            end if;
+          end loop;
+          for b in 0 to c_line_bytes-1 loop
+            s_fmask(p)(b) <= v_mask(b mod c_reg_bytes) and f_opa_eq(unsigned(r_shoff(p)), b/c_reg_bytes);
+            s_fdat (p)((b+1)*8-1 downto b*8) <= v_dat(((b mod c_reg_bytes)+1)*8-1 downto (b mod c_reg_bytes)*8);
+          end loop;
+        end loop;
+      end process;
+      
+      control : process(clk_i, rst_n_i) is
+        variable v_valid : std_logic_vector(c_sb_size downto 0);
+        variable v_done  : boolean;
+      begin
+        if rst_n_i = '0' then
+          r_valid <= (others => '0');
+        elsif rising_edge(clk_i) then
+          v_valid := '0' & r_valid;
+          if s_pop = '1' then
+            v_valid := '0' & v_valid(c_sb_size downto 1);
+          end if;
+          v_done := false;
+          for e in 0 to c_sb_size-1 loop
+            if not v_done and v_valid(e) = '0' then
+              v_valid(e) := s_push and not f_opa_or(s_merge);
+              v_done := true;
+            end if;
+          end loop;
+          r_valid <= v_valid(r_valid'range);
+        end if;
+      end process;
+      
+      main : process(clk_i) is
+        variable v_sadr  : t_sadr(c_sb_size downto 0);
+        variable v_smask : t_sel (c_sb_size downto 0);
+        variable v_sdat  : t_reg (c_sb_size downto 0);
+        variable v_free  : std_logic_vector(c_sb_size downto 0);
+        variable v_done  : boolean;
+      begin
+        if rising_edge(clk_i) then
+          v_sadr  := (others => (others => '-'));
+          v_smask := (others => (others => '-'));
+          v_sdat  := (others => (others => '-'));
+          v_sadr (r_sadr'range)  := r_sadr;
+          v_smask(r_smask'range) := r_smask;
+          v_sdat (r_sdat'range)  := r_sdat;
+          v_free := '1' & not r_valid;
+          for e in 0 to c_sb_size-1 loop
+            if (s_push and s_merge(e)) = '1' then
+              v_smask(e) := r_smask(e) or r_wmask(0);
+              for b in 0 to c_reg_bytes-1 loop
+                if r_wmask(0)(b) = '1' then
+                  v_sdat(e)((b+1)*8-1 downto b*8) := r_wb_dat((b+1)*8-1 downto b*8);
+                end if;
+              end loop;
+            end if;
+          end loop;
+          if s_pop = '1' then
+            v_sadr (r_sadr'range)  := v_sadr (c_sb_size downto 1);
+            v_smask(r_smask'range) := v_smask(c_sb_size downto 1);
+            v_sdat (r_sdat'range)  := v_sdat (c_sb_size downto 1);
+            v_free := '1' & v_free(c_sb_size downto 1);
+          end if;
+          v_done := false;
+          for e in 0 to c_sb_size-1 loop
+            if not v_done and v_free(e) = '1' then
+              if f_opa_or(s_merge) = '0' then
+                v_sadr (e) := s_wadr;
+                v_smask(e) := r_wmask(0);
+                v_sdat (e) := r_wb_dat;
+              end if;
+              v_done := true;
+            end if;
+          end loop;
+          r_sadr  <= v_sadr (r_sadr'range);
+          r_smask <= v_smask(r_smask'range);
+          r_sdat  <= v_sdat (r_sdat'range);
+        end if;
+      end process;
+    end block;
+  end generate;
+  nosb : if c_sb_size = 0 generate
+    s_drain     <= (others => '0');
+    s_sb_adr    <= (others => '-');
+    s_sb_mask   <= (others => '-');
+    s_sb_dat    <= (others => '-');
+    s_sb_empty  <= '1';
+    s_sb_reject <= '0';
+    s_sb_multi  <= (others => '0');
+    s_fmask     <= (others => (others => '0'));
+    s_fdat      <= (others => (others => '0'));
+  end generate;
+  
+  -- Data TLB, looked up from the virtual page number while the L1d index is registered.
+  -- Entries are filled by a hardware walk of an Sv32-style page table whose root
+  -- and enable bit live in the pbus control register. A PTE has valid in bit 0,
+  -- RWX in bits 3:1 (leaf if any is set), nocache in bit 8 and the ppn from bit 10.
+  -- The walker loads each PTE through port 0 like a prefetch, so PTEs are cached
+  -- and a missing PTE is refilled by dbus. Ops which miss the TLB just retry.
+  -- A walk only starts once the store buffer is empty, so it sees every older
+  -- PTE store; a later one must be followed by a control write, which flushes.
+  -- An invalid mapping is not installed. The walker remembers the last few such
+  -- pages instead (round-robin), and an op on one keeps retrying until it is
+  -- oldest, when it faults (s_pfault). Past c_bad_ways bad pages in flight, the
+  -- oldest is forgotten and re-walked, which costs time but not correctness.
+  tlb : if c_dtlb_ways > 0 generate
+    b : block is
+      constant c_lvl_wide : natural := c_tag_low - c_log_reg_bytes;
+      constant c_levels   : natural := (c_tag_wide + c_lvl_wide - 1) / c_lvl_wide;
+      constant c_pte_nc   : natural := 8;
+      constant c_pte_ppn  : natural := 10;
+      constant c_bad_ways : natural := 4;
+      
+      type t_walk is (WALK_IDLE, WALK_LOAD, WALK_CHECK, WALK_PTE);
+      
+      signal r_tvalid : std_logic_vector(c_dtlb_ways-1 downto 0) := (others => '0');
+      signal r_tvpn   : t_tag(c_dtlb_ways-1 downto 0);
+      signal r_tmask  : t_tag(c_dtlb_ways-1 downto 0); -- which page bits translate
+      signal r_tppn   : t_tag(c_dtlb_ways-1 downto 0);
+      signal r_tnoc   : std_logic_vector(c_dtlb_ways-1 downto 0);
+      signal r_tnext  : natural range 0 to c_dtlb_ways-1 := 0;
+      
+      signal r_state  : t_walk := WALK_IDLE;
+      signal r_level  : natural range 0 to c_levels-1;
+      signal r_wvpn   : std_logic_vector(c_tag_high downto c_tag_low);
+      signal r_table  : std_logic_vector(c_tag_high downto c_tag_low);
+      signal r_bad    : std_logic_vector(c_bad_ways-1 downto 0) := (others => '0');
+      signal r_bvpn   : t_tag(c_bad_ways-1 downto 0);
+      signal r_bnext  : natural range 0 to c_bad_ways-1 := 0;
+      
+      signal s_thit   : t_opa_matrix(c_num_slow-1 downto 0, c_dtlb_ways-1 downto 0);
+      signal s_bhit   : t_opa_matrix(c_num_slow-1 downto 0, c_bad_ways-1 downto 0);
+      signal s_phys   : std_logic_vector(c_num_slow-1 downto 0);
+      signal s_need   : std_logic_vector(c_num_slow-1 downto 0);
+      signal s_nvpn   : std_logic_vector(c_tag_high downto c_tag_low);
+      signal s_known  : std_logic_vector(c_dtlb_ways-1 downto 0);
+      signal s_pidx   : std_logic_vector(c_lvl_wide-1 downto 0);
+      signal s_wway   : std_logic_vector(c_num_ways-1 downto 0);
+      signal s_whit   : std_logic;
+      signal s_pte    : std_logic_vector(c_reg_wide-1 downto 0);
+      signal s_pppn   : std_logic_vector(c_tag_high downto c_tag_low);
+      signal s_leaf   : std_logic;
+      signal s_fault  : std_logic;
+      signal s_fill   : std_logic;
+      signal s_mask   : std_logic_vector(c_tag_high downto c_tag_low);
+    begin
+      -- Drains, hardware prefetches and walks already carry physical addresses
+      ports : for p in 0 to c_num_slow-1 generate
+        ents : for e in 0 to c_dtlb_ways-1 generate
+          s_thit(p,e) <= r_tvalid(e) and not f_opa_or((s_vtag(p) xor r_tvpn(e)) and r_tmask(e));
+        end generate;
+        bads : for e in 0 to c_bad_ways-1 generate
+          s_bhit(p,e) <= r_bad(e) and f_opa_eq(s_vtag(p), r_bvpn(e));
+        end generate;
+        s_phys(p) <= not pbus_vm_i or s_inject(p) or s_drain(p) or s_walk(p);
+        s_tbad(p) <= f_opa_or(f_opa_select_row(s_bhit, p)) and not s_phys(p);
+      end generate;
+      
+      translate : process(s_vtag, s_thit, s_phys, r_tmask, r_tppn, r_tnoc) is
+        variable v_tag : std_logic_vector(c_tag_high downto c_tag_low);
+        variable v_noc : std_logic;
+      begin
+        for p in 0 to c_num_slow-1 loop
+          v_tag := (others => '0');
+          v_noc := '0';
+          for e in 0 to c_dtlb_ways-1 loop
+            if s_thit(p,e) = '1' then
+              v_tag := v_tag or (r_tppn(e) and r_tmask(e)) or (s_vtag(p) and not r_tmask(e));
+              v_noc := v_noc or r_tnoc(e);
+            end if;
+          end loop;
+          if s_phys(p) = '1' then
+            s_ptag (p) <= s_vtag(p);
+            s_tnc  (p) <= '0';
+            s_tmiss(p) <= '0';
+          else
+            s_ptag (p) <= v_tag;
+            s_tnc  (p) <= v_noc;
+            s_tmiss(p) <= not f_opa_or(f_opa_select_row(s_thit, p));
+          end if;
+        end loop;
+      end process;
+      
+      -- Walk for the lowest port which missed, unless an earlier walk covered it
+      -- or found its page unmapped
+      s_need <= r_stb and (r_re or r_we) and r_tmiss and not r_tbad;
+      need : process(s_need, r_vtag) is
+      begin
+        s_nvpn <= (others => '-');
+        for p in c_num_slow-1 downto 0 loop
+          if s_need(p) = '1' then
+            s_nvpn <= r_vtag(p);
+          end if;
+        end loop;
+      end process;
+      known : for e in 0 to c_dtlb_ways-1 generate
+        s_known(e) <= r_tvalid(e) and not f_opa_or((s_nvpn xor r_tvpn(e)) and r_tmask(e));
+      end generate;
+      
+      -- The PTE for this level of the walk
+      pidx : process(r_wvpn, r_level) is
+        variable v_vpn : unsigned(c_levels*c_lvl_wide-1 downto 0);
+      begin
+        v_vpn  := shift_right(resize(unsigned(r_wvpn), v_vpn'length), r_level*c_lvl_wide);
+        s_pidx <= std_logic_vector(v_vpn(c_lvl_wide-1 downto 0));
+      end process;
+      s_wk_adr(c_tag_high downto c_tag_low) <= r_table;
+      s_wk_adr(c_tag_low-1 downto c_log_reg_bytes) <= s_pidx;
+      low_adr : if c_log_reg_bytes > 0 generate
+        s_wk_adr(c_log_reg_bytes-1 downto 0) <= (others => '0');
+      end generate;
+      
+      s_walk(0) <= f_opa_bit(r_state = WALK_LOAD) and not s_drain(0);
+      others_walk : if c_num_slow > 1 generate
+        s_walk(c_num_slow-1 downto 1) <= (others => '0');
+      end generate;
+      
+      -- Did the PTE load hit (in the way whose data it will return)?
+      direct : if not c_dc_wpred generate
+        s_wway <= (others => '1');
+      end generate;
+      predict : if c_dc_wpred generate
+        s_wway <= f_opa_select_row(s_wpred, 0);
+      end generate;
+      s_whit <= f_opa_or(f_opa_select_row(s_donew, 0) and s_wway);
+      
+      s_pte   <= f_opa_select_row(s_data, 0);
+      s_pppn  <= s_pte(c_pte_ppn+c_tag_wide-1 downto c_pte_ppn);
+      s_leaf  <= s_pte(1) or s_pte(2) or s_pte(3);
+      s_fault <= (f_opa_bit(r_state = WALK_CHECK) and s_pbus(0)) or
+                 (f_opa_bit(r_state = WALK_PTE) and (not s_pte(0) or (not s_leaf and f_opa_bit(r_level = 0))));
+      s_fill  <= f_opa_bit(r_state = WALK_PTE) and s_pte(0) and s_leaf;
+      
+      -- A leaf above the last level maps a superpage; its low page bits pass through
+      mask : for b in c_tag_low to c_tag_high generate
+        s_mask(b) <= f_opa_bit(b - c_tag_low >= r_level*c_lvl_wide);
+      end generate;
+      
+      control : process(clk_i, rst_n_i) is
+      begin
+        if rst_n_i = '0' then
+          r_state  <= WALK_IDLE;
+          r_tvalid <= (others => '0');
+          r_tnext  <= 0;
+          r_bad    <= (others => '0');
+          r_bnext  <= 0;
+        elsif rising_edge(clk_i) then
+          case r_state is
+            when WALK_IDLE =>
+              if (f_opa_or(s_need) and not f_opa_or(s_known) and s_sb_empty) = '1' then
+                r_state <= WALK_LOAD;
+              end if;
+            when WALK_LOAD =>
+              if s_walk(0) = '1' then
+                r_state <= WALK_CHECK;
+              end if;
+            when WALK_CHECK =>
+              -- a miss has requested the refill of the PTE line; just retry
+              if s_fault = '1' then
+                r_state <= WALK_IDLE;
+              elsif s_whit = '1' then
+                r_state <= WALK_PTE;
+              else
+                r_state <= WALK_LOAD;
+              end if;
+            when WALK_PTE =>
+              if (s_fill or s_fault) = '1' then
+                r_state <= WALK_IDLE;
+              else
+                r_state <= WALK_LOAD;
+              end if;
+          end case;
+          if s_fill = '1' then
+            r_tvalid(r_tnext) <= '1';
+            r_tnext <= (r_tnext + 1) mod c_dtlb_ways;
+          end if;
+          if s_fault = '1' then
+            r_bad(r_bnext) <= '1';
+            r_bnext <= (r_bnext + 1) mod c_bad_ways;
+          end if;
+          -- The control register was written; the mappings may have changed
+          if pbus_flush_i = '1' then
+            r_state  <= WALK_IDLE;
+            r_tvalid <= (others => '0');
+            r_bad    <= (others => '0');
+          end if;
+        end if;
+      end process;
+      
+      main : process(clk_i) is
+      begin
+        if rising_edge(clk_i) then
+          if r_state = WALK_IDLE then
+            r_wvpn  <= s_nvpn;
+            r_table <= pbus_root_i;
+            r_level <= c_levels-1;
+          end if;
+          if (f_opa_bit(r_state = WALK_PTE) and not s_fill) = '1' then
+            r_table <= s_pppn;
+            r_level <= r_level - 1;
+          end if;
+          if s_fill = '1' then
+            r_tvpn (r_tnext) <= r_wvpn;
+            r_tmask(r_tnext) <= s_mask;
+            r_tppn (r_tnext) <= s_pppn;
+            r_tnoc (r_tnext) <= s_pte(c_pte_nc);
+          end if;
+          if s_fault = '1' then
+            r_bvpn(r_bnext) <= r_wvpn;
+          end if;
+        end if;
+      end process;
+    end block;
+  end generate;
+  notlb : if c_dtlb_ways = 0 generate
+    s_ptag   <= s_vtag;
+    s_tnc    <= (others => '0');
+    s_tmiss  <= (others => '0');
+    s_tbad   <= (others => '0');
+    s_walk   <= (others => '0');
+    s_wk_adr <= (others => '-');
+  end generate;
+  
+  -- Victim cache: a few fully-associative lines holding what refills evicted.
+  -- A miss which hits here (while dbus is idle and the victim need not be
+  -- written back) swaps the line into the L1d write port instead of asking
+  -- dbus; the op retries and then hits. Every victim a refill or swap evicts
+  -- is captured a cycle later (dirty victims are written back by then).
+  -- Entries only hold copies of memory, so any L1d write of the same line
+  -- (a store or a dbus refill) drops the entry rather than update it.
+  vc : if c_vc_size > 0 generate
+    b : block is
+      type t_vadr is array(natural range <>) of std_logic_vector(c_tag_high downto c_idx_low);
+      
+      signal r_vvalid : std_logic_vector(c_vc_size-1 downto 0) := (others => '0');
+      signal r_vadr   : t_vadr (c_vc_size-1 downto 0);
+      signal r_vmask  : t_valid(c_vc_size-1 downto 0);
+      signal r_vline  : t_line (c_vc_size-1 downto 0);
+      signal r_vnext  : natural range 0 to c_vc_size-1 := 0;
+      signal r_take   : std_logic := '0';
+      signal r_vc_idx : std_logic_vector(c_idx_high downto c_idx_low);
+      signal r_vc_tag : std_logic_vector(c_tag_high downto c_tag_low);
+      signal r_vc_way : std_logic_vector(c_num_ways-1 downto 0);
+      signal r_vc_valid : std_logic_vector(c_line_bytes-1 downto 0);
+      signal r_vc_line  : std_logic_vector(c_line_bytes*8-1 downto 0);
+      signal s_hit    : std_logic_vector(c_vc_size-1 downto 0);
+      signal s_pick   : std_logic_vector(c_vc_size-1 downto 0);
+      signal s_same   : std_logic_vector(c_vc_size-1 downto 0);
+      signal s_kill   : std_logic_vector(c_vc_size-1 downto 0);
+      signal s_slot   : std_logic_vector(c_vc_size-1 downto 0);
+      signal s_wline  : std_logic_vector(c_tag_high downto c_idx_low);
+      signal s_write  : std_logic;
+      signal s_evict  : std_logic;
+      signal s_take   : std_logic;
+    begin
+      ents : for e in 0 to c_vc_size-1 generate
+        s_hit (e) <= r_vvalid(e) and f_opa_eq(r_vadr(e), s_gadr(c_tag_high downto c_idx_low));
+        s_same(e) <= r_vvalid(e) and f_opa_eq(r_vadr(e), s_eadr(c_tag_high downto c_idx_low));
+        s_kill(e) <= r_vvalid(e) and f_opa_eq(r_vadr(e), s_wline) and s_write;
+        -- Reuse the entry already holding this line, otherwise round-robin
+        s_slot(e) <= s_same(e) when f_opa_or(s_same) = '1' else f_opa_bit(r_vnext = e);
+      end generate;
+      s_pick <= f_opa_pick_small(s_hit);
+      
+      -- The granted miss will replace its victim way (by dbus or by a swap)
+      s_evict  <= f_opa_or(s_grant) and not s_streq and not dbus_busy_i and not r_vcfill
+                  and not f_opa_or(s_grant and s_match);
+      s_vc_hit <= s_evict and f_opa_or(s_hit) and not f_opa_or(s_grant and s_dirty);
+      s_wline  <= s_wtag & s_widx;
+      s_write  <= f_opa_or(s_we) and not r_vcfill;
+      s_take   <= r_take and f_opa_or(s_emask) and not (s_write and f_opa_eq(s_wline, s_eadr(c_tag_high downto c_idx_low)));
+      
+      control : process(clk_i, rst_n_i) is
+      begin
+        if rst_n_i = '0' then
+          r_vvalid <= (others => '0');
+          r_vcfill <= '0';
+          r_take   <= '0';
+        elsif rising_edge(clk_i) then
+          r_vcfill <= s_vc_hit;
+          r_take   <= s_evict;
+          for e in 0 to c_vc_size-1 loop
+            r_vvalid(e) <= (r_vvalid(e) and not s_kill(e) and not (s_pick(e) and s_vc_hit))
+                           or (s_slot(e) and s_take);
+          end loop;
+        end if;
+      end process;
+      
+      main : process(clk_i) is
+      begin
+        if rising_edge(clk_i) then
+          r_vc_idx <= s_gadr(c_idx_high downto c_idx_low);
+          r_vc_tag <= s_gadr(c_tag_high downto c_tag_low);
+          r_vc_way <= s_gway;
+          r_vc_valid <= (others => '0');
+          r_vc_line  <= (others => '0');
+          for e in 0 to c_vc_size-1 loop
+            if s_pick(e) = '1' then
+              r_vc_valid <= r_vmask(e);
+              r_vc_line  <= r_vline(e);
+            end if;
+          end loop;
+          
+          for e in 0 to c_vc_size-1 loop
+            if (s_slot(e) and s_take) = '1' then
+              r_vadr (e) <= s_eadr(c_tag_high downto c_idx_low);
+              r_vmask(e) <= s_emask;
+              r_vline(e) <= s_eline;
+            end if;
+          end loop;
+          if (s_take and not f_opa_or(s_same)) = '1' then
+            r_vnext <= (r_vnext + 1) mod c_vc_size;
+          end if;
+        end if;
+      end process;
+      
+      s_vc_idx   <= r_vc_idx;
+      s_vc_tag   <= r_vc_tag;
+      s_vc_way   <= r_vc_way;
+      s_vc_valid <= r_vc_valid;
+      s_vc_line  <= r_vc_line;
+    end block;
+  end generate;
+  novc : if c_vc_size = 0 generate
+    s_vc_hit   <= '0';
+    r_vcfill   <= '0';
+    s_vc_idx   <= (others => '-');
+    s_vc_tag   <= (others => '-');
+    s_vc_way   <= (others => '0');
+    s_vc_valid <= (others => '-');
+    s_vc_line  <= (others => '-');
   end generate;
   
   -- Share information about potential aliasing with the issue stage
   -- It does not matter if the write succeeds => restart aliased loads anyways
-  issue_store_o <= r_we(0);
+  issue_store_o <= r_we(0) and not r_drain(0);
   issue_load_o  <= r_re;
+  issue_addr_o  <= s_iadr;
   issue_aliases : for u in 0 to c_num_slow-1 generate
     -- Extract the bits which tell us if a store and load alias
-    -- I would love to use a hash over the whole address, but then I would be screwed
-    -- if someone maps two virtual pages to the same physical address. If I had the 
-    -- physical address, I could certainly hash that, but it's too slow. Hrm.
+    -- The physical page number is folded into alias_tag bits. r_ptag is registered
+    -- alongside r_vtag, so this costs no more than folding the virtual page, and
+    -- two virtual pages which share a frame still compare equal.
+    tag : if c_alias_tag > 0 generate
+      s_atag(u)  <= f_fold(r_ptag(u));
+      s_asame(u) <= f_opa_eq(s_atag(u), s_atag(0));
+    end generate;
+    notag : if c_alias_tag = 0 generate
+      s_asame(u) <= '1';
+    end generate;
+    page : for b in c_tag_low to c_alias_high generate
+      s_iadr(u,b) <= s_atag(u)(b);
+    end generate;
     addr : for b in c_idx_high downto c_off_low generate
-      issue_addr_o(u,b) <= s_adr(u,b);
+      s_iadr(u,b) <= s_adr(u,b);
     end generate;
     mask : for b in 0 to c_reg_bytes-1 generate
       issue_mask_o(u,b) <= r_wmask(u)(b);
     end generate;
   end generate;
   
+  -- Remember recent loads; a store which aliases one of them trains the load-wait table.
+  -- Stores only execute when oldest, so a remembered load may well be older and have
+  -- completed long ago (x=a[i]; a[i]=x+1). Only train when issue confirms the store
+  -- made a younger load reissue, and then blame the newest matching load.
+  lwt : if c_lwt_size > 0 generate
+    constant c_hist_size : natural := 8;
+    
+    type t_iadr is array(natural range <>) of std_logic_vector(c_alias_high downto c_alias_low);
+    type t_pc   is array(natural range <>) of std_logic_vector(c_adr_wide-1 downto c_op_align);
+    
+    signal r_hvalid : std_logic_vector(c_hist_size-1 downto 0) := (others => '0');
+    signal r_hidx   : unsigned(f_opa_log2(c_hist_size)-1 downto 0) := (others => '0');
+    signal r_hadr   : t_iadr(c_hist_size-1 downto 0);
+    signal r_hmask  : t_sel (c_hist_size-1 downto 0);
+    signal r_hpc    : t_pc  (c_hist_size-1 downto 0);
+    signal r_wait   : std_logic := '0';
+    signal r_wpc    : std_logic_vector(c_adr_wide-1 downto c_op_align);
+    
+    signal s_push   : std_logic_vector(c_num_slow-1 downto 0);
+    signal s_store  : std_logic;
+    signal s_hit    : std_logic_vector(c_hist_size-1 downto 0);
+    signal s_age    : std_logic_vector(c_hist_size-1 downto 0);
+    signal s_pick   : std_logic_vector(c_hist_size-1 downto 0);
+  begin
+    -- Record one completed load per cycle
+    s_push  <= f_opa_pick_small(r_re and not s_pbus and not s_retry);
+    s_store <= r_we(0) and not r_drain(0) and not s_retry(0);
+    
+    hits : for i in 0 to c_hist_size-1 generate
+      s_hit(i) <= s_store and issue_alias_i and r_hvalid(i)
+                  and f_opa_eq(r_hadr(i), f_opa_select_row(s_iadr, 0))
+                  and f_opa_or(r_hmask(i) and r_wmask(0));
+    end generate;
+    -- Entry r_hidx is the oldest; rotate it to the bottom to find the newest hit
+    s_age  <= f_opa_pick_big(f_opa_rotate_right(s_hit, r_hidx));
+    s_pick <= f_opa_rotate_left(s_age, r_hidx);
+    
+    control : process(clk_i, rst_n_i) is
+    begin
+      if rst_n_i = '0' then
+        r_hvalid <= (others => '0');
+        r_hidx   <= (others => '0');
+        r_wait   <= '0';
+      elsif rising_edge(clk_i) then
+        r_hvalid <= r_hvalid and not s_pick;
+        if f_opa_or(s_push) = '1' then
+          r_hvalid(to_integer(r_hidx)) <= '1';
+          r_hidx <= r_hidx + 1;
+        end if;
+        r_wait <= f_opa_or(s_hit);
+      end if;
+    end process;
+    
+    main : process(clk_i) is
+    begin
+      if rising_edge(clk_i) then
+        for p in 0 to c_num_slow-1 loop
+          if s_push(p) = '1' then
+            r_hadr (to_integer(r_hidx)) <= f_opa_select_row(s_iadr, p);
+            r_hmask(to_integer(r_hidx)) <= r_wmask(p);
+            r_hpc  (to_integer(r_hidx)) <= f_opa_select_row(r_pc, p);
+          end if;
+        end loop;
+        for i in 0 to c_hist_size-1 loop
+          if s_pick(i) = '1' then
+            r_wpc <= r_hpc(i);
+          end if;
+        end loop;
+      end if;
+    end process;
+    
+    decode_wait_o <= r_wait;
+    decode_pc_o   <= r_wpc;
+  end generate;
+  nolwt : if c_lwt_size = 0 generate
+    decode_wait_o <= '0';
+    decode_pc_o   <= (others => '0');
+  end generate;
+  
+  -- A pbus load which arrives before it is oldest is I/O. It can only retry, so
+  -- decode orders its PC from now on; then it is issued only when it can run.
+  io : block is
+    signal s_io   : std_logic_vector(c_num_slow-1 downto 0);
+    signal r_io   : std_logic := '0';
+    signal r_iopc : std_logic_vector(c_adr_wide-1 downto c_op_align);
+  begin
+    s_io <= f_opa_pick_small(r_re and s_pbus and not slow_oldest_i);
+    
+    control : process(clk_i, rst_n_i) is
+    begin
+      if rst_n_i = '0' then
+        r_io <= '0';
+      elsif rising_edge(clk_i) then
+        r_io <= f_opa_or(s_io);
+      end if;
+    end process;
+    
+    main : process(clk_i) is
+    begin
+      if rising_edge(clk_i) then
+        for p in 0 to c_num_slow-1 loop
+          if s_io(p) = '1' then
+            r_iopc <= f_opa_select_row(r_pc, p);
+          end if;
+        end loop;
+      end if;
+    end process;
+    
+    decode_io_o   <= r_io;
+    decode_iopc_o <= r_iopc;
+  end block;
+  
   -- We will execute stores from port 0
   
   -- Rotate write data to put target byte at write mask location
   s_0dat <= f_opa_select_row(slow_data_i, 0);
   wb_big : if c_big_endian generate
-    s_wb_dat <= f_opa_rotate_right(s_0dat, unsigned(s_shsub(0)), 8);
+    s_wb_rot <= f_opa_rotate_right(s_0dat, unsigned(s_shsub(0)), 8);
   end generate;
   wb_little : if not c_big_endian generate
-    s_wb_dat <= f_opa_rotate_left (s_0dat, unsigned(s_shsub(0)), 8);
+    s_wb_rot <= f_opa_rotate_left (s_0dat, unsigned(s_shsub(0)), 8);
   end generate;
+  s_wb_dat <= s_sb_dat when s_drain(0) = '1' else s_wb_rot;
   
-  -- Which way gets written by port 0?
-  -- Note: s_wb_we is ignored if dbus_busy_i=1
-  s_0we   <= (others => r_we(0) and slow_oldest_i(0) and not s_pbus(0)); -- only the oldest write is allowed
+  -- Which way gets written by port 0? With a store buffer, only drains write L1d.
+  -- Note: s_wb_we is ignored if s_wport=1
+  s_stw   <= r_we(0) and not r_tmiss(0) and (r_drain(0) or f_opa_bit(c_sb_size = 0));
+  s_0we   <= (others => s_stw and (slow_oldest_i(0) or r_drain(0)) and not s_pbus(0) and not s_wblock); -- only the oldest write is allowed
   s_wb_we <= s_0we and f_opa_select_row(s_victimw, 0);
   
   -- Construct the per-way data we would like to write
@@ -519,35 +1726,52 @@ begin
     s_wb_valid(w)  <= r_bmask(0) or s_was_valid(w);
   end generate;
   
-  -- Decide what to write to L1; dbus has priority
-  s_widx      <= dbus_adr_i(s_widx'range) when dbus_busy_i='1' else r_vidx(0);
-  s_wdirty(0) <= '0'                      when dbus_busy_i='1' else '1';
-  s_wtag      <= dbus_adr_i(s_wtag'range) when dbus_busy_i='1' else r_vtag(0);
+  -- Decide what to write to L1; dbus has priority, then a victim cache swap
+  -- dbus only takes the port on cycles it writes a refilled word (or wipes).
+  -- Between those, port 0 may write, except to the set being refilled (its
+  -- victim is already in flight) or while dbus has misses queued behind it.
+  s_dwrite    <= f_opa_or(dbus_we_i);
+  s_wport     <= s_dwrite or r_vcfill;
+  s_wfill     <= s_wport;
+  s_wblock    <= s_wport or (dbus_busy_i and not dbus_fill_i) or
+                 (dbus_fill_i and f_opa_eq(r_vidx(0), dbus_adr_i(c_idx_high downto c_idx_low)));
+  s_widx      <= dbus_adr_i(s_widx'range) when s_dwrite='1' else s_vc_idx when r_vcfill='1' else r_vidx(0);
+  s_wdirty(0) <= '0'                      when s_wport ='1' else '1';
+  s_wtag      <= dbus_adr_i(s_wtag'range) when s_dwrite='1' else s_vc_tag when r_vcfill='1' else r_ptag(0);
   write_ways : for w in 0 to c_num_ways-1 generate
-    s_we(w)    <= dbus_we_i(w)           when dbus_busy_i='1' else s_wb_we(w);
-    s_wvalid(w)<= dbus_valid_i           when dbus_busy_i='1' else s_wb_valid(w);
-    s_wdat(w)  <= dbus_data_i            when dbus_busy_i='1' else s_wb_line(w);
+    s_we(w)    <= dbus_we_i(w)           when s_dwrite='1' else s_vc_way(w) when r_vcfill='1' else s_wb_we(w);
+    s_wvalid(w)<= dbus_valid_i           when s_dwrite='1' else s_vc_valid  when r_vcfill='1' else s_wb_valid(w);
+    s_wdat(w)  <= dbus_data_i            when s_dwrite='1' else s_vc_line   when r_vcfill='1' else s_wb_line(w);
     s_went(w)  <= s_wdirty & s_wtag & s_wvalid(w) & s_wdat(w);
   end generate;
   
   -- Pick which port wins access to the dbus b/c no way satisfied its ldst
+  -- While dbus is busy, it queues clean fills (OPA_DBUS_LOAD) in its MSHRs
+  -- and drops requests for lines it is already filling, or whose victim way
+  -- another queued fill already reserved => loads just retry
   -- Note: streq=1 => ldreq(0)=1 ... b/c load s_donew => s_matchw
   s_match <= f_opa_product(s_matchw, c_way_ones); -- a way tag matched?
   s_dirty <= f_opa_product(s_dirtyw and s_victimw, c_way_ones); -- dirty line?
-  s_streq <= not s_pbus(0) and not s_match(0) and r_we(0); -- store0 has priority over all loads
-  s_ldreq <= not s_pbus and r_stb and not f_opa_product(s_donew, c_way_ones); -- which port?
-  s_grant <= f_opa_pick_small(s_ldreq); -- if streq=1 then grant(0)=1
+  s_streq <= not s_pbus(0) and not s_match(0) and s_stw; -- store0 has priority over all loads
+  s_ldreq <= not s_pbus and r_stb and not r_tmiss and not f_opa_product(s_donew, c_way_ones); -- which port?
+  s_dmreq <= s_ldreq and (r_re or r_we); -- prefetches only get leftover dbus requests
+  s_grant <= -- if streq=1 then grant(0)=1
+    f_opa_pick_small(s_dmreq) when f_opa_or(s_dmreq) = '1' else
+    f_opa_pick_small(s_ldreq);
   
   -- To prevent later stores starving the oldest store, only do it for oldest
-  s_st_req   <= OPA_DBUS_WAIT_STORE      when (s_dirty(0) and slow_oldest_i(0))='1' else OPA_DBUS_IDLE;
+  s_st_req   <= OPA_DBUS_WAIT_STORE      when (s_dirty(0) and (slow_oldest_i(0) or r_drain(0)))='1' else OPA_DBUS_IDLE;
   s_cl_req   <= OPA_DBUS_LOAD            when f_opa_or(s_grant)                ='1' else OPA_DBUS_IDLE;
   s_di_req   <= OPA_DBUS_WAIT_STORE_LOAD when f_opa_or(s_grant and s_match)    ='1' else OPA_DBUS_LOAD_STORE;
   s_ld_req   <= s_di_req                 when f_opa_or(s_grant and s_dirty)    ='1' else s_cl_req;
-  dbus_req_o <= s_st_req                 when s_streq                          ='1' else s_ld_req; 
+  dbus_req_o <= s_st_req                 when s_streq                          ='1' else 
+                OPA_DBUS_IDLE            when (s_vc_hit or r_vcfill)           ='1' else s_ld_req; 
 
   -- Which line should the dbus refill and to which way
-  dbus_radr_o <= f_opa_product(f_opa_transpose(s_adr),     s_grant);
-  dbus_way_o  <= f_opa_product(f_opa_transpose(s_victimw), s_grant);
+  s_gadr      <= f_opa_product(f_opa_transpose(s_adr),     s_grant);
+  s_gway      <= f_opa_product(f_opa_transpose(s_victimw), s_grant);
+  dbus_radr_o <= s_gadr;
+  dbus_way_o  <= s_gway;
   
   -- Select line contents for writeback by the dbus
   wbports : for p in 0 to c_num_slow-1 generate
@@ -565,39 +1789,57 @@ begin
     end generate;
   end generate;
   
-  dbus_wadr_o(c_tag_high downto c_idx_low) <= f_opa_product(s_rtag_m, s_grant_way) & r_vidx0;
+  s_eadr(c_tag_high downto c_idx_low) <= f_opa_product(s_rtag_m, s_grant_way) & r_gidx;
   low_wadr : if c_idx_low > 0 generate
-    dbus_wadr_o(c_idx_low-1 downto 0) <= (others => '0');
+    s_eadr(c_idx_low-1 downto 0) <= (others => '0');
   end generate;
+  s_emask <= f_opa_product(s_rvalid_m, s_grant_way);
+  s_eline <= f_opa_product(s_rdat_m,   s_grant_way);
   
-  dbus_dirty_o <= f_opa_product(s_rvalid_m, s_grant_way);
-  dbus_data_o  <= f_opa_product(s_rdat_m,   s_grant_way);
+  dbus_wadr_o  <= s_eadr;
+  dbus_dirty_o <= s_emask;
+  dbus_data_o  <= s_eline;
   
   -- If this load aliased a store at port 0, retry it
   cross_aliases : for p in 0 to c_num_slow-1 generate
-    s_alias(p) <= r_re(p) and r_we(0)
+    s_alias(p) <= r_re(p) and r_we(0) and not r_drain(0) and s_asame(p)
                   and f_opa_eq(r_vidx(p), r_vidx(0))
                   and f_opa_eq(r_voff(p), r_voff(0))
                   and f_opa_or(r_wmask(p) and r_wmask(0));
   end generate;
   
-  -- Restart load if it aliases a concurrent store or misses cache
-  -- Restart a store if it is not oldest or dbus had control of L1d write port
+  -- Restart load if it aliases a concurrent store, misses cache (hits proceed under misses),
+  -- or hit a way other than the predicted one
+  -- Restart a store if it is not oldest or it could not write the L1d (s_wblock)
+  -- With a store buffer, a store instead restarts only if the buffer cannot take it
+  s_wbusy <= s_sb_reject when c_sb_size > 0 else s_wblock;
   retry : for p in 0 to c_num_slow-1 generate
-    s_dretry(p) <= f_opa_mux(r_re(p), (s_alias(p) or s_ldreq(p)), (not slow_oldest_i(p) or dbus_busy_i));
+    s_dretry(p) <= f_opa_mux(r_re(p), (s_alias(p) or s_ldreq(p) or s_sb_multi(p) or s_wmiss(p)), (not slow_oldest_i(p) or s_wbusy));
   end generate;
-  -- Both loads and stores to pbus must be oldest
+  -- Both loads and stores to pbus must be oldest and wait for buffered stores
   -- Loads must have result ready, while stores must have a non-busy pbus
-  s_pretry(0) <= not slow_oldest_i(0) or f_opa_mux(r_re(0), not pbus_full_i, pbus_stall_i);
-  slow_retry_o <= r_stb and f_opa_mux(s_pbus, s_pretry, s_dretry);
+  s_pretry(0) <= not slow_oldest_i(0) or not s_sb_empty or f_opa_mux(r_re(0), not pbus_full_i, pbus_stall_i);
+  -- Drains and prefetches never retry; an op whose port was taken by a drain or walk always does
+  -- An op which missed the TLB retries until the walker has filled its entry
+  s_retry <= (r_stb and (r_re or r_we) and not r_drain and (r_tmiss or f_opa_mux(s_pbus, s_pretry, s_dretry))) or r_steal;
+  slow_retry_o <= s_retry;
+  
+  -- An op on a page the walker found unmapped also retries (r_tmiss); the slow EU
+  -- turns that into a fault once the op is oldest. Only port 0 can be oldest.
+  s_pfault <= r_stb and (r_re or r_we) and not r_drain and r_tmiss and r_tbad;
+  slow_fault_o <= s_pfault;
+  slow_trap_o  <= pbus_trap_i;
+  pbus_fault_o <= s_pfault(0) and slow_oldest_i(0);
+  pbus_fpage_o <= r_vtag(0);
+  pbus_fpc_o   <= f_opa_select_row(r_pc, 0);
   
   -- Peripheral bus accesses are comparatievly easy. They come from port 0.
-  pbus_req_o  <= slow_oldest_i(0) and r_stb(0) and s_pbus(0) and not (r_re(0) and pbus_full_i);
+  pbus_req_o  <= slow_oldest_i(0) and (r_re(0) or r_we(0)) and s_pbus(0) and not r_tmiss(0) and s_sb_empty and not (r_re(0) and pbus_full_i);
   pbus_we_o   <= r_we(0);
   pbus_addr_o <= f_opa_select_row(s_adr, 0);
   pbus_sel_o  <= r_wmask(0);
   pbus_dat_o  <= r_wb_dat;
-  pbus_pop_o  <= slow_oldest_i(0) and r_re(0) and s_pbus(0);
+  pbus_pop_o  <= slow_oldest_i(0) and r_re(0) and s_pbus(0) and not r_tmiss(0);
   
   control : process(clk_i, rst_n_i) is
   begin
@@ -605,17 +1847,30 @@ begin
       r_stb <= (others => '0');
       r_we  <= (others => '0');
       r_re  <= (others => '0');
+      r_drain <= (others => '0');
+      r_steal <= (others => '0');
+      r_walk  <= (others => '0');
+      r_tmiss <= (others => '0');
+      r_tbad  <= (others => '0');
     elsif rising_edge(clk_i) then
-      r_stb <= slow_stb_i;
-      r_we  <= slow_stb_i and     slow_we_i;
-      r_re  <= slow_stb_i and not slow_we_i; -- future: re=0 & we=0 for prefetch
+      r_drain <= s_drain;
+      r_steal <= (s_drain or s_walk) and slow_stb_i;
+      r_walk  <= s_walk;
+      r_tmiss <= s_tmiss;
+      r_tbad  <= s_tbad;
+      r_stb <= s_stb;
+      r_we  <= s_stb and     s_wen;
+      r_re  <= s_stb and not s_wen and not s_pref; -- re=0 & we=0 for prefetch
     end if;
   end process;
   
   main : process(clk_i) is
   begin
     if rising_edge(clk_i) then
+      r_pc    <= slow_pc_i;
       r_vtag  <= s_vtag;
+      r_ptag  <= s_ptag;
+      r_tnc   <= s_tnc;
       r_vidx  <= s_vidx;
       r_voff  <= s_voff;
       r_wmask <= s_wmask;
@@ -626,7 +1881,7 @@ begin
       r_clear <= s_clear;
       r_wb_dat<= s_wb_dat;
       --
-      r_vidx0 <= r_vidx(0);
+      r_gidx  <= s_gadr(c_idx_high downto c_idx_low);
       r_rtag  <= s_rtag;
       r_rvalid<= s_rvalid;
       r_rdat  <= s_rdat;
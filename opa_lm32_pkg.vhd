@@ -39,12 +39,14 @@ package opa_lm32_pkg is
   constant c_opa_lm32 : t_opa_isa_info := (
     big_endian => true,
     num_arch   => 32,
+    num_fp     => 0,
     imm_wide   => 32,
     op_wide    => 32,
     page_size  => 4096);
   
   function f_opa_accept_lm32(config : t_opa_config) return std_logic;
   function f_opa_decode_lm32(config : t_opa_config; x : std_logic_vector) return t_opa_op;
+  function f_opa_fuse_lm32  (config : t_opa_config; x, y : std_logic_vector) return t_opa_op;
 
 end package;
 
@@ -241,7 +243,7 @@ package body opa_lm32_pkg is
     op.arg.adder.nota  := '0';
     op.arg.adder.notb  := '0';
     op.arg.adder.cin   := '0';
-    op.arg.adder.sign  := '-';
+    op.arg.adder.sign  := '0'; -- plain link
     op.arg.adder.fault := '-';
     op.arg.fmode       := c_opa_fast_jump;
     op.fast            := '1';
@@ -259,7 +261,7 @@ package body opa_lm32_pkg is
     op.arg.adder.nota  := '0';
     op.arg.adder.notb  := '0';
     op.arg.adder.cin   := '0';
-    op.arg.adder.sign  := '-';
+    op.arg.adder.sign  := '0'; -- plain link
     op.arg.adder.fault := '-';
     op.arg.fmode       := c_opa_fast_jump;
     op.fast            := '1';
@@ -278,7 +280,7 @@ package body opa_lm32_pkg is
     op.arg.adder.nota  := '0';
     op.arg.adder.notb  := '0';
     op.arg.adder.cin   := '0';
-    op.arg.adder.sign  := '-';
+    op.arg.adder.sign  := '0'; -- plain link
     op.arg.adder.fault := '-';
     op.arg.fmode       := c_opa_fast_jump;
     op.fast            := '1';
@@ -297,7 +299,7 @@ package body opa_lm32_pkg is
     op.arg.adder.nota  := '0';
     op.arg.adder.notb  := '0';
     op.arg.adder.cin   := '0';
-    op.arg.adder.sign  := '-';
+    op.arg.adder.sign  := '0'; -- plain link
     op.arg.adder.fault := '-';
     op.arg.fmode       := c_opa_fast_jump;
     op.fast            := '1';
@@ -860,6 +862,8 @@ package body opa_lm32_pkg is
     op.arg.ldst.store  := '0';
     op.arg.ldst.sext   := '1';
     op.arg.ldst.size   := c_opa_ldst_byte;
+    op.arg.ldst.pref   := f_arch_eq(op.archx, "00000"); -- load to r0
+    op.setx            := not op.arg.ldst.pref;
     op.arg.smode       := c_opa_slow_ldst;
     op.fast            := '0';
     return op;
@@ -872,6 +876,8 @@ package body opa_lm32_pkg is
     op.arg.ldst.store  := '0';
     op.arg.ldst.sext   := '0';
     op.arg.ldst.size   := c_opa_ldst_byte;
+    op.arg.ldst.pref   := f_arch_eq(op.archx, "00000"); -- load to r0
+    op.setx            := not op.arg.ldst.pref;
     op.arg.smode       := c_opa_slow_ldst;
     op.fast            := '0';
     return op;
@@ -884,6 +890,8 @@ package body opa_lm32_pkg is
     op.arg.ldst.store  := '0';
     op.arg.ldst.sext   := '1';
     op.arg.ldst.size   := c_opa_ldst_half;
+    op.arg.ldst.pref   := f_arch_eq(op.archx, "00000"); -- load to r0
+    op.setx            := not op.arg.ldst.pref;
     op.arg.smode       := c_opa_slow_ldst;
     op.fast            := '0';
     return op;
@@ -896,6 +904,8 @@ package body opa_lm32_pkg is
     op.arg.ldst.store  := '0';
     op.arg.ldst.sext   := '0';
     op.arg.ldst.size   := c_opa_ldst_half;
+    op.arg.ldst.pref   := f_arch_eq(op.archx, "00000"); -- load to r0
+    op.setx            := not op.arg.ldst.pref;
     op.arg.smode       := c_opa_slow_ldst;
     op.fast            := '0';
     return op;
@@ -908,6 +918,8 @@ package body opa_lm32_pkg is
     op.arg.ldst.store  := '0';
     op.arg.ldst.sext   := '1';
     op.arg.ldst.size   := c_opa_ldst_word;
+    op.arg.ldst.pref   := f_arch_eq(op.archx, "00000"); -- load to r0
+    op.setx            := not op.arg.ldst.pref;
     op.arg.smode       := c_opa_slow_ldst;
     op.fast            := '0';
     return op;
@@ -920,6 +932,7 @@ package body opa_lm32_pkg is
     op.arg.ldst.store  := '1';
     op.arg.ldst.sext   := '-';
     op.arg.ldst.size   := c_opa_ldst_byte;
+    op.arg.ldst.pref   := '0';
     op.arg.smode       := c_opa_slow_ldst;
     op.fast            := '0';
     return op;
@@ -932,6 +945,7 @@ package body opa_lm32_pkg is
     op.arg.ldst.store  := '1';
     op.arg.ldst.sext   := '-';
     op.arg.ldst.size   := c_opa_ldst_half;
+    op.arg.ldst.pref   := '0';
     op.arg.smode       := c_opa_slow_ldst;
     op.fast            := '0';
     return op;
@@ -944,6 +958,7 @@ package body opa_lm32_pkg is
     op.arg.ldst.store  := '1';
     op.arg.ldst.sext   := '-';
     op.arg.ldst.size   := c_opa_ldst_word;
+    op.arg.ldst.pref   := '0';
     op.arg.smode       := c_opa_slow_ldst;
     op.fast            := '0';
     return op;
@@ -1119,4 +1134,30 @@ package body opa_lm32_pkg is
       when others   => return c_opa_op_bad;
     end case;
   end f_opa_decode_lm32;
+  
+  -- Pairs that decode fuses into a single op; x is the first op, y the second.
+  -- The fused op takes the place (and PC) of x. Result has fuse='0' otherwise.
+  --   mvhi rd, hi ; ori rd, rd, lo => rd = hi<<16 | lo
+  function f_opa_fuse_lm32(config : t_opa_config; x, y : std_logic_vector) return t_opa_op is
+    constant c_opx : std_logic_vector(5 downto 0) := x(31 downto 26);
+    constant c_opy : std_logic_vector(5 downto 0) := y(31 downto 26);
+    variable op    : t_opa_op := c_opa_op_undef;
+  begin
+    op.fuse := '0';
+    -- mvhi is orhi from r0; ori must read and overwrite the register mvhi wrote
+    if c_opx = "011110" and c_opy = "001110" and
+       f_opa_or(x(25 downto 21)) = '0' and
+       x(20 downto 16) = y(20 downto 16) and
+       x(20 downto 16) = y(25 downto 21) then
+      op := f_parse_hitype(x);
+      op.imm(15 downto 0) := y(15 downto 0);
+      op.geta      := '0';
+      op.arg.lut   := "1010"; -- X = B
+      op.arg.fmode := c_opa_fast_lut;
+      op.fast      := '1';
+      op.fuse      := '1';
+    end if;
+    return op;
+  end f_opa_fuse_lm32;
+  
 end opa_lm32_pkg;
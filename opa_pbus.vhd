@@ -66,7 +66,18 @@ entity opa_pbus is
     l1d_pop_i   : in  std_logic;
     l1d_full_o  : out std_logic;
     l1d_err_o   : out std_logic;
-    l1d_dat_o   : out std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0));
+    l1d_dat_o   : out std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0);
+    
+    -- Address translation settings held in our control register
+    l1d_vm_o    : out std_logic;
+    l1d_root_o  : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+    l1d_flush_o : out std_logic;
+    l1d_trap_o  : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
+    
+    -- Page faults are recorded for the handler
+    l1d_fault_i : in  std_logic;
+    l1d_fpage_i : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_log2(f_opa_page_size(g_isa)));
+    l1d_fpc_i   : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa)));
 end opa_pbus;
 
 architecture rtl of opa_pbus is
@@ -76,10 +87,34 @@ architecture rtl of opa_pbus is
   constant c_reg_wide  : natural := f_opa_reg_wide(g_config);
   constant c_sel_wide  : natural := c_reg_wide/8;
   constant c_fifo_wide : natural := c_adr_wide + c_sel_wide + c_reg_wide;
-  constant c_fifo_deep : natural := 4;
+  constant c_fifo_deep : natural := f_opa_log2(g_config.pbus_fifo);
+  constant c_op_align  : natural := f_opa_op_align(g_isa);
   constant c_device_align : natural := f_opa_log2(c_page_size);
+  constant c_sel_align : natural := f_opa_log2(c_sel_wide);
+  
+  -- The last word of the address space is our own control register:
+  --   bit 0: lock   => keep the wishbone cycle up, even across devices
+  --   bit 1: merge  => combine writes to disjoint bytes of the same word
+  --   bit 2: vm     => translate L1d addresses through the page table
+  --   page number   => physical address of the root page table
+  -- Merging is off by default, as it is wrong for devices with byte FIFOs.
+  -- The root is only replaced by a full-word write. Any write flushes the TLB.
+  --
+  -- The three words below it handle page faults:
+  --   last-1: trap  => where fetch continues after a page fault (full-word write)
+  --   last-2: page  => virtual page number of the last fault (read-only)
+  --   last-3: epc   => address of the load/store which faulted (read-only)
+  -- The faulting op did not run, so the handler can map the page, write the
+  -- control register to flush the TLB, and jump back to epc.
   
   signal s_stall   : std_logic; -- We can accept the op on l1d_addr_i
+  signal s_ctl     : std_logic; -- L1d addresses one of our registers
+  signal s_ctl_rd  : std_logic; -- ... and reads it
+  signal s_ctl_wr  : std_logic; -- ... and writes it
+  signal s_ctl_reg : std_logic_vector(1 downto 0); -- ... which one
+  signal s_merge   : std_logic; -- L1d write can be folded into the FIFO tail
+  signal s_tail    : std_logic; -- FIFO tail is queued and not about to be popped
+  signal s_combine : std_logic; -- L1d write is folded into the FIFO tail
   signal s_push    : std_logic; -- L1d delivers req into FIFO (and possibly reg)
   signal s_exist   : std_logic; -- There exists data to be sent
   signal s_full    : std_logic; -- full regs were not drained by pbus
@@ -90,6 +125,9 @@ architecture rtl of opa_pbus is
   signal s_ridx    : unsigned(c_fifo_deep-1 downto 0);
   signal s_fidx    : unsigned(c_fifo_deep-1 downto 0);
   signal s_fifo_in : std_logic_vector(c_fifo_wide-1 downto 0);
+  signal s_fifo_adr: std_logic_vector(c_fifo_deep-1 downto 0);
+  signal s_msel    : std_logic_vector(c_sel_wide-1 downto 0);
+  signal s_mdat    : std_logic_vector(c_reg_wide-1 downto 0);
   signal s_fifo_out: std_logic_vector(c_fifo_wide-1 downto 0);
   
   signal r_widx    : unsigned(c_fifo_deep-1 downto 0) := (others => '0');
@@ -107,7 +145,24 @@ architecture rtl of opa_pbus is
   signal r_sel     : std_logic_vector(c_reg_wide/8-1 downto 0);
   signal r_dat     : std_logic_vector(c_reg_wide  -1 downto 0);
   
-  signal r_lock    : std_logic := '0'; -- !!! set somewhere in a CSR or so
+  signal r_lock    : std_logic := '0';
+  signal r_comb    : std_logic := '0';
+  signal r_vm      : std_logic := '0';
+  signal r_root    : std_logic_vector(c_adr_wide-1 downto c_device_align) := (others => '0');
+  signal r_flush   : std_logic := '0';
+  signal r_trap    : std_logic_vector(c_adr_wide-1 downto c_op_align) := (others => '0');
+  signal r_fpage   : std_logic_vector(c_adr_wide-1 downto c_device_align);
+  signal r_fpc     : std_logic_vector(c_adr_wide-1 downto c_op_align);
+  
+  -- Copy of the last request pushed into the FIFO
+  signal r_twe     : std_logic := '0';
+  signal r_tadr    : std_logic_vector(c_adr_wide-1 downto 0);
+  signal r_tsel    : std_logic_vector(c_sel_wide-1 downto 0);
+  signal r_tdat    : std_logic_vector(c_reg_wide-1 downto 0);
+  
+  -- L1d only issues a load when it is oldest, but retries it until the data arrives.
+  -- Refuse further reads while one is outstanding, so a device never sees it twice.
+  signal r_rpend   : std_logic := '0';
   
   signal r_full    : std_logic := '0';
   signal r_err     : std_logic;
@@ -131,16 +186,28 @@ begin
   -- We accept requests into the same wishbone cycle if they are within the same device
   -- OR the user has explicitly requested the cycle line stay up (r_lock).
   s_stall <= 
+    (r_rpend and not l1d_we_i) or
     r_stall or not
     (r_lock or not r_cyc or f_opa_eq(r_adr(r_adr'high downto c_device_align), l1d_addr_i(r_adr'high downto c_device_align)));
   
-  s_push  <= l1d_req_i and not s_stall;
+  -- A write to disjoint bytes of the same word as the queued tail joins it
+  -- (a non-empty FIFO pops unless full; s_pop itself would loop through s_push)
+  s_tail  <= not f_opa_eq(r_widx, r_ridx) and not (not s_full and f_opa_eq(r_ridx+1, r_widx));
+  s_merge <= r_comb and l1d_we_i and r_twe and s_tail
+             and f_opa_eq(r_tadr, l1d_addr_i) and not f_opa_or(r_tsel and l1d_sel_i);
+  
+  s_ctl     <= f_opa_and(l1d_addr_i(c_adr_wide-1 downto c_sel_align+2));
+  s_ctl_reg <= l1d_addr_i(c_sel_align+1 downto c_sel_align);
+  s_ctl_rd  <= l1d_req_i and not s_stall and s_ctl and not l1d_we_i;
+  s_ctl_wr  <= l1d_req_i and not s_stall and s_ctl and     l1d_we_i;
+  s_combine <= l1d_req_i and s_merge and not s_ctl;
+  s_push    <= l1d_req_i and not s_stall and not s_merge and not s_ctl;
   s_full  <= r_stb and p_stall_i;
   s_exist <= not f_opa_eq(r_widx, r_ridx) or s_push;
   s_pop   <= not s_full and s_exist;
   s_fin   <= r_cyc and (p_ack_i or p_err_i);
   
-  l1d_stall_o <= s_stall;
+  l1d_stall_o <= s_stall and not s_merge;
   p_cyc_o  <= r_cyc;
   p_stb_o  <= r_stb;
   p_we_o   <= r_we;
@@ -164,13 +231,22 @@ begin
       r_addr_i => std_logic_vector(s_ridx),
       r_data_o => s_fifo_out,
       w_en_i   => '1',
-      w_addr_i => std_logic_vector(r_widx),
+      w_addr_i => s_fifo_adr,
       w_data_i => s_fifo_in);
 
   s_widx <= r_widx + ("" & s_push);
   s_ridx <= r_ridx + ("" & s_pop);
   s_fidx <= r_fidx + ("" & s_fin);
-  s_fifo_in <= l1d_addr_i & l1d_sel_i & l1d_dat_i;
+  
+  -- Merged writes overwrite the tail entry
+  s_msel <= r_tsel or l1d_sel_i;
+  lanes : for b in 0 to c_sel_wide-1 generate
+    s_mdat((b+1)*8-1 downto b*8) <= 
+      l1d_dat_i((b+1)*8-1 downto b*8) when l1d_sel_i(b) = '1' else r_tdat((b+1)*8-1 downto b*8);
+  end generate;
+  
+  s_fifo_adr <= std_logic_vector(r_widx-1) when s_combine = '1' else std_logic_vector(r_widx);
+  s_fifo_in  <= l1d_addr_i & s_msel & s_mdat when s_combine = '1' else l1d_addr_i & l1d_sel_i & l1d_dat_i;
 
   main : process(clk_i, rst_n_i) is
   begin
@@ -181,6 +257,14 @@ begin
       r_stall <= '0';
       r_cyc   <= '0';
       r_stb   <= '0';
+      r_lock  <= '0';
+      r_comb  <= '0';
+      r_vm    <= '0';
+      r_root  <= (others => '0');
+      r_flush <= '0';
+      r_trap  <= (others => '0');
+      r_twe   <= '0';
+      r_rpend <= '0';
     elsif rising_edge(clk_i) then
       r_ridx  <= s_ridx;
       r_widx  <= s_widx;
@@ -188,6 +272,37 @@ begin
       r_stall <= not f_opa_lt(r_widx - r_fidx, 2**c_fifo_deep-2);
       r_cyc   <= not f_opa_eq(s_widx, s_fidx) or r_lock;
       r_stb   <= s_exist or s_full;
+      if (s_ctl_wr and f_opa_eq(s_ctl_reg, "11") and l1d_sel_i(0)) = '1' then
+        r_lock <= l1d_dat_i(0);
+        r_comb <= l1d_dat_i(1);
+        r_vm   <= l1d_dat_i(2);
+      end if;
+      if (s_ctl_wr and f_opa_eq(s_ctl_reg, "11") and f_opa_and(l1d_sel_i)) = '1' then
+        r_root <= l1d_dat_i(r_root'range);
+      end if;
+      if (s_ctl_wr and f_opa_eq(s_ctl_reg, "10") and f_opa_and(l1d_sel_i)) = '1' then
+        r_trap <= l1d_dat_i(r_trap'range);
+      end if;
+      r_flush <= s_ctl_wr and f_opa_eq(s_ctl_reg, "11");
+      if s_push = '1' then
+        r_twe <= l1d_we_i;
+      end if;
+      r_rpend <= (r_rpend and not l1d_pop_i) or (s_push and not l1d_we_i) or s_ctl_rd;
+    end if;
+  end process;
+  
+  tail : process(clk_i) is
+  begin
+    if rising_edge(clk_i) then
+      if s_push = '1' then
+        r_tadr <= l1d_addr_i;
+        r_tsel <= l1d_sel_i;
+        r_tdat <= l1d_dat_i;
+      end if;
+      if s_combine = '1' then
+        r_tsel <= s_msel;
+        r_tdat <= s_mdat;
+      end if;
     end if;
   end process;
   
@@ -217,25 +332,57 @@ begin
     end if;
   end process;
   
-  -- !!! add a FIFO just like the above once we have prefetch => high throughput loads
+  -- Reads queue behind posted writes in the same FIFO and wishbone cycle.
+  -- Only one can be outstanding, as L1d serves I/O loads one at a time (oldest only).
   
   l1d_full_o <= r_full;
   l1d_err_o  <= r_err;
   l1d_dat_o  <= r_que;
   
+  l1d_vm_o    <= r_vm;
+  l1d_root_o  <= r_root;
+  l1d_flush_o <= r_flush;
+  l1d_trap_o  <= r_trap;
+  
+  fault : process(clk_i) is
+  begin
+    if rising_edge(clk_i) then
+      if l1d_fault_i = '1' then
+        r_fpage <= l1d_fpage_i;
+        r_fpc   <= l1d_fpc_i;
+      end if;
+    end if;
+  end process;
+  
   qmain : process(clk_i, rst_n_i) is
   begin
     if rst_n_i = '0' then
       r_full <= '0';
     elsif rising_edge(clk_i) then
-      r_full <= (r_full and not l1d_pop_i) or (s_fin and not r_we_q(to_integer(unsigned(r_fidx))));
+      r_full <= (r_full and not l1d_pop_i) or (s_fin and not r_we_q(to_integer(unsigned(r_fidx)))) or s_ctl_rd;
     end if;
   end process;
   
   qbus : process(clk_i) is
   begin
     if rising_edge(clk_i) then
-      if r_full = '0' then
+      if s_ctl_rd = '1' then
+        r_que  <= (others => '0');
+        case s_ctl_reg is
+          when "11" =>
+            r_que(0) <= r_lock;
+            r_que(1) <= r_comb;
+            r_que(2) <= r_vm;
+            r_que(r_root'range) <= r_root;
+          when "10" =>
+            r_que(r_trap'range) <= r_trap;
+          when "01" =>
+            r_que(r_fpage'range) <= r_fpage;
+          when others =>
+            r_que(r_fpc'range) <= r_fpc;
+        end case;
+        r_err  <= '0';
+      elsif r_full = '0' then
         r_que  <= p_data_i;
         r_err  <= p_err_i;
       end if;
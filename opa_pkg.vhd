@@ -34,6 +34,9 @@ package opa_pkg is
 
   -- Target Instruction Set Architecture
   type t_opa_isa is (T_OPA_RV32, T_OPA_LM32);
+  
+  -- How the L1d picks the way a refill replaces
+  type t_opa_repl is (T_OPA_RANDOM, T_OPA_PLRU, T_OPA_RRIP);
 
   type t_opa_config is record
     reg_width  : natural; -- Register width; must conform to ISA
@@ -41,27 +44,47 @@ package opa_pkg is
     num_fetch  : natural; -- # of instructions fetched concurrently
     num_rename : natural; -- # of instructions decoded concurrently
     num_stat   : natural; -- # of reservation stations
+    mv_elim    : boolean; -- Rename points readers of a move's result at the move's source
+    br_early   : boolean; -- Mispredicted branches redirect fetch before they are oldest (still flush when oldest)
+    fin_ready  : boolean; -- Ops which can neither fault nor retry go final with ready
+    fast_shift : boolean; -- Shifts and sign extension execute in the fast EUs, not the slow EUs
     num_fast   : natural; -- # of fast EUs (logic, add/sub, branch, ...)
     num_slow   : natural; -- # of slow EUs (load/store, mul, fp, ...)
+    num_clust  : natural; -- Fast EU clusters; results cross clusters a cycle late (1 = flat)
+    rf_banks   : natural; -- Register file read banks per operand, by backing register (0 = one port per EU)
     ieee_fp    : boolean; -- Floating point support
     ic_ways    : natural; -- Instruction cache ways (each is 4KB=page_size)
     iline_size : natural; -- Instruction cache line size (bytes)
     dc_ways    : natural; -- Data cache ways (each is 4KB=page_size)
     dline_size : natural; -- Data cache line size (bytes)
+    dc_wpred   : boolean; -- Predict the L1d way, aligning only its data before the tag compare
+    dc_repl    : t_opa_repl; -- L1d replacement policy (random, tree-PLRU or 2-bit SRRIP)
+    vc_size    : natural; -- Fully-associative victim cache lines behind the L1d (0 = none)
     dtlb_ways  : natural; -- Data TLB ways
+    pbus_fifo  : natural; -- Posted pbus requests in flight (power of 2 >= 4)
+    ftq_size   : natural; -- Fetch-target queue entries (predict runs ahead of icache)
+    dq_size    : natural; -- Decode queue entries (>= num_fetch + 2*num_rename - 1)
+    num_mshr   : natural; -- L1d misses queued behind the active line fill (0 = blocking)
+    dpf_size   : natural; -- Stride prefetcher entries, indexed by load PC (0 = none)
+    sb_size    : natural; -- Store buffer entries in front of the L1d (0 = none)
+    alias_tag  : natural; -- Page number bits folded into load/store alias checks (0 = page offset only)
+    lwt_size   : natural; -- Load-wait table entries, indexed by load PC (0 = none)
   end record;
   
   -- Tiny processor:  1-issue,  6 stations, 1+1 EU, 4+4KB i+dcache
-  constant c_opa_tiny  : t_opa_config := (32, 17, 1, 1,  6, 1, 1, false, 1,  8, 1,  8, 1);
+  constant c_opa_tiny  : t_opa_config := (32, 17, 1, 1,  6, false, false, false, false, 1, 1, 1, 0, false, 1,  8, 1,  8, false, T_OPA_RANDOM, 0, 1,  4, 2,  2, 0,  0, 0, 0,  0);
   
   -- Small processor: 2-issue, 18 stations, 1+1 EU, 8+8KB i+dcache
-  constant c_opa_small : t_opa_config := (32, 32, 2, 2, 18, 1, 1, false, 2, 16, 1, 16, 1);
+  constant c_opa_small : t_opa_config := (32, 32, 2, 2, 18, true,  false, true,  false, 1, 1, 1, 0, false, 2, 16, 1, 16, false, T_OPA_RANDOM, 2, 1, 16, 4,  6, 1,  4, 2, 4, 16);
   
   -- Large processor: 3-issue, 27 stations, 2+1 EU, 16+16KB i+dcache
-  constant c_opa_large : t_opa_config := (32, 32, 4, 3, 27, 2, 1, false, 2, 16, 2, 16, 2);
+  constant c_opa_large : t_opa_config := (32, 32, 4, 3, 27, true,  false, true,  false, 2, 1, 1, 0, false, 2, 16, 2, 16, true,  T_OPA_PLRU,   4, 2, 16, 4, 12, 2,  8, 4, 8, 32);
   
   -- Huge processor:  4-issue, 44 stations, 2+2 EU, 32+32KB i+dcache
-  constant c_opa_huge  : t_opa_config := (32, 32, 4, 4, 44, 2, 2, true,  8, 16, 8, 16, 4);
+  constant c_opa_huge  : t_opa_config := (32, 32, 4, 4, 44, true,  false, false, false, 2, 2, 1, 2, false, 8, 16, 8, 16, true,  T_OPA_PLRU,   4, 4, 16, 8, 16, 4, 16, 4, 8, 64);
+  
+  -- Wide processor:  6-issue, 60 stations, 4+2 EU in 2 fast clusters, 32+32KB i+dcache
+  constant c_opa_wide  : t_opa_config := (32, 32, 8, 6, 60, true,  false, false, false, 4, 2, 2, 2, false, 8, 32, 8, 16, true,  T_OPA_PLRU,   4, 4, 16, 8, 24, 4, 16, 8, 8, 64);
   
   type t_opa_target is record
     lut_width  : natural; -- How many inputs to combine at once
@@ -69,13 +92,16 @@ package opa_pkg is
     mul_width  : natural; -- Widest DSP multiplier block
     mem_depth  : natural; -- Minimum depth of a memory block
     post_adder : boolean; -- Can add two products (a*b)<<wide + (c*d)
+    mul_split  : boolean; -- Finish the multiplier's upper half after its output register
   end record;
+  -- The multiplier's reduction depth is not configurable beyond mul_split, a
+  -- single boolean which adds one stage for the upper half; only c_opa_asic sets it.
   
   -- FPGA flavors supported
-  constant c_opa_cyclone_iv : t_opa_target := (4, 2, 18, 256, true);
-  constant c_opa_arria_ii   : t_opa_target := (6, 2, 18, 256, true);
-  constant c_opa_cyclone_v  : t_opa_target := (6, 3, 27, 256, false);
-  constant c_opa_asic       : t_opa_target := (4, 2,  1,   1, false);
+  constant c_opa_cyclone_iv : t_opa_target := (4, 2, 18, 256, true,  false);
+  constant c_opa_arria_ii   : t_opa_target := (6, 2, 18, 256, true,  false);
+  constant c_opa_cyclone_v  : t_opa_target := (6, 3, 27, 256, false, false);
+  constant c_opa_asic       : t_opa_target := (4, 2,  1,   1, false, true);
   
   component opa is
     generic(
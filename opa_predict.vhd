@@ -71,6 +71,10 @@ architecture rtl of opa_predict is
   constant c_fetch_bytes : natural := f_opa_fetch_bytes(g_isa,g_config);
   constant c_rs_wide   : natural := 5; -- can maybe bump to 8 if IPC gain is substantial
   constant c_rs_deep   : natural := 2**c_rs_wide;
+  constant c_ftq_size  : natural := g_config.ftq_size;
+  constant c_ftq_wide  : natural := f_opa_log2(c_ftq_size);
+  constant c_pc_wide   : natural := c_adr_wide - c_op_align;
+  constant c_ent_wide  : natural := c_pc_wide + 1 + c_fetchers;
   
   constant c_fetch_adr : unsigned(c_adr_wide-1 downto 0) := to_unsigned(c_fetch_bytes, c_adr_wide);
   constant c_increment : unsigned(c_adr_wide-1 downto c_op_align) := c_fetch_adr(c_adr_wide-1 downto c_op_align);
@@ -87,6 +91,29 @@ architecture rtl of opa_predict is
   signal r_loop_pc   : unsigned(c_adr_wide-1 downto c_op_align) := (others => '0');
   signal r_loop_jump : std_logic_vector(c_fetchers-1 downto 0)  := (others => '0');
   signal r_loop_pcn  : unsigned(c_adr_wide-1 downto c_op_align) := c_increment;
+  
+  -- The fetch-target queue; indexes carry an extra bit to distinguish full/empty
+  signal r_widx   : unsigned(c_ftq_wide downto 0) := (others => '0');
+  signal r_ridx   : unsigned(c_ftq_wide downto 0) := (others => '0');
+  signal s_widx   : unsigned(c_ftq_wide downto 0);
+  signal s_ridx   : unsigned(c_ftq_wide downto 0);
+  signal s_empty  : std_logic;
+  signal s_full   : std_logic;
+  signal s_pop    : std_logic; -- icache accepts the head
+  signal s_push   : std_logic; -- prediction enters the queue
+  signal s_take   : std_logic; -- queue gives up its head
+  signal s_step   : std_logic; -- predictor advances
+  
+  -- A queue entry is the next PC plus the prediction made for the current PC
+  signal s_gen_pc   : unsigned(c_adr_wide-1 downto c_op_align);
+  signal s_gen_hit  : std_logic;
+  signal s_gen_jump : std_logic_vector(c_fetchers-1 downto 0);
+  signal s_fifo_in  : std_logic_vector(c_ent_wide-1 downto 0);
+  signal s_fifo_out : std_logic_vector(c_ent_wide-1 downto 0);
+  signal s_head     : std_logic_vector(c_ent_wide-1 downto 0);
+  signal s_head_pc  : unsigned(c_adr_wide-1 downto c_op_align);
+  signal s_head_hit : std_logic;
+  signal s_head_jump: std_logic_vector(c_fetchers-1 downto 0);
 
 begin
 
@@ -101,6 +128,9 @@ begin
       -- Check state
       assert (f_opa_safe(r_pc)     = '1') report "predict: r_pc has a metavalue" severity failure;
       assert (f_opa_safe(r_rs_idx) = '1') report "predict: r_rs_idx has a metavalue" severity failure;
+      assert (f_opa_safe(r_widx)   = '1') report "predict: r_widx has a metavalue" severity failure;
+      assert (f_opa_safe(r_ridx)   = '1') report "predict: r_ridx has a metavalue" severity failure;
+      assert (f_opa_lt(r_widx - r_ridx, c_ftq_size+1) = '1') report "predict: fetch-target queue overflow" severity failure;
     end if;
   end process;
 
@@ -139,11 +169,50 @@ begin
   decode_return_o <= std_logic_vector(s_return);
 
   -- World's simplest branch predictor!
+  -- It runs ahead of the icache, depositing its guesses in the fetch-target queue.
+  s_gen_pc <=
+    r_loop_pcn when r_pc=r_loop_pc else
+    (r_pc + c_increment) and c_mask;
+  s_gen_hit  <= f_opa_eq(r_pc, r_loop_pc);
+  s_gen_jump <= r_loop_jump when r_pc=r_loop_pc else (others => '0');
+  
+  s_empty <= f_opa_eq(r_widx, r_ridx);
+  s_full  <= f_opa_eq(r_widx - r_ridx, c_ftq_size);
+  s_pop   <= not icache_stall_i;
+  s_take  <= s_pop and not s_empty;
+  s_push  <= not s_full and not (s_empty and s_pop); -- empty => bypass the queue
+  s_step  <= not s_full or s_pop;
+  
+  s_widx <= r_widx + ("" & s_push);
+  s_ridx <= r_ridx + ("" & s_take);
+  s_fifo_in <= std_logic_vector(s_gen_pc) & s_gen_hit & s_gen_jump;
+  
+  ftq : opa_dpram
+    generic map(
+      g_width  => c_ent_wide,
+      g_size   => c_ftq_size,
+      g_equal  => OPA_NEW,
+      g_regin  => true,
+      g_regout => false)
+    port map(
+      clk_i    => clk_i,
+      rst_n_i  => rst_n_i,
+      r_addr_i => std_logic_vector(s_ridx(c_ftq_wide-1 downto 0)),
+      r_data_o => s_fifo_out,
+      w_en_i   => s_push,
+      w_addr_i => std_logic_vector(r_widx(c_ftq_wide-1 downto 0)),
+      w_data_i => s_fifo_in);
+  
+  s_head      <= s_fifo_in when s_empty='1' else s_fifo_out;
+  s_head_pc   <= unsigned(s_head(c_ent_wide-1 downto c_fetchers+1));
+  s_head_hit  <= s_head(c_fetchers);
+  s_head_jump <= s_head(c_fetchers-1 downto 0);
+  
+  -- Faults and returns bypass the queue entirely and restart prediction from the target
   s_pc <= 
     s_return                        when decode_return_i='1' else
     unsigned(decode_target_i)       when decode_fault_i ='1' else 
-    r_loop_pcn                      when r_pc=r_loop_pc      else
-    (r_pc + c_increment) and c_mask;
+    s_head_pc;
   
   main : process(clk_i, rst_n_i) is
   begin
@@ -152,6 +221,8 @@ begin
       r_loop_jump   <= (others => '0');
       r_loop_pcn    <= c_increment;
       r_pc          <= c_increment;
+      r_widx        <= (others => '0');
+      r_ridx        <= (others => '0');
       decode_jump_o <= (others => '0');
       decode_hit_o  <= '0';
     elsif rising_edge(clk_i) then
@@ -160,17 +231,21 @@ begin
         r_loop_jump <= decode_jump_i;
         r_loop_pcn  <= unsigned(decode_target_i);
       end if;
-      if decode_fault_i = '1' then
-        r_pc <= s_pc(r_pc'range);
-      elsif icache_stall_i = '0' then
-        r_pc <= s_pc(r_pc'range);
-        if r_pc = r_loop_pc then
-          decode_jump_o <= r_loop_jump;
-          decode_hit_o  <= '1';
-        else
-          decode_jump_o <= (others => '0');
-          decode_hit_o  <= '0';
+      if (decode_fault_i or decode_return_i) = '1' then
+        r_pc   <= s_pc(r_pc'range);
+        r_widx <= (others => '0');
+        r_ridx <= (others => '0');
+      else
+        if s_step = '1' then
+          r_pc <= s_gen_pc;
         end if;
+        r_widx <= s_widx;
+        r_ridx <= s_ridx;
+      end if;
+      -- The fetch in flight keeps its prediction, unless a fault discards it
+      if (s_pop and not decode_fault_i) = '1' then
+        decode_jump_o <= s_head_jump;
+        decode_hit_o  <= s_head_hit;
       end if;
     end if;
   end process;
@@ -0,0 +1,230 @@
+--  opa: Open Processor Architecture
+--  Copyright (C) 2014-2016  Wesley W. Terpstra
+--
+--  This program is free software: you can redistribute it and/or modify
+--  it under the terms of the GNU General Public License as published by
+--  the Free Software Foundation, either version 3 of the License, or
+--  (at your option) any later version.
+--
+--  This program is distributed in the hope that it will be useful,
+--  but WITHOUT ANY WARRANTY; without even the implied warranty of
+--  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+--  GNU General Public License for more details.
+--
+--  You should have received a copy of the GNU General Public License
+--  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+--
+--  To apply the GPL to my VHDL, please follow these definitions:
+--    Program        - The entire collection of VHDL in this project and any
+--                     netlist or floorplan derived from it.
+--    System Library - Any macro that translates directly to hardware
+--                     e.g. registers, IO pins, or memory blocks
+--    
+--  My intent is that if you include OPA into your project, all of the HDL
+--  and other design files that go into the same physical chip must also
+--  be released under the GPL. If this does not cover your usage, then you
+--  must consult me directly to receive the code under a different license.
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.opa_pkg.all;
+use work.opa_isa_base_pkg.all;
+use work.opa_functions_pkg.all;
+use work.opa_components_pkg.all;
+
+-- Iterative radix-4 divider, used by the slow EUs through retry.
+-- A request either collects the finished result for exactly these operands,
+-- or (re)starts the division and must be asked again later.
+-- Divides are not ordered, so several may take turns asking. A request which
+-- misses starts a division the cycle after, once old_i says whether it came
+-- from the oldest op. A division which is running or not yet collected is only
+-- abandoned for the oldest op, so the oldest always proceeds and no younger
+-- divide throws away another's work.
+entity opa_prim_div is
+  generic(
+    g_wide   : natural);
+  port(
+    clk_i    : in  std_logic;
+    rst_n_i  : in  std_logic;
+    stb_i    : in  std_logic;
+    old_i    : in  std_logic; -- 1 cycle after stb_i: the request is from the oldest op
+    sign_i   : in  std_logic; -- both operands are signed
+    a_i      : in  std_logic_vector(g_wide-1 downto 0);
+    b_i      : in  std_logic_vector(g_wide-1 downto 0);
+    done_o   : out std_logic; -- 1 cycle after stb_i; q_o and r_o answer the request
+    q_o      : out std_logic_vector(g_wide-1 downto 0);
+    r_o      : out std_logic_vector(g_wide-1 downto 0));
+end opa_prim_div;
+
+architecture rtl of opa_prim_div is
+
+  constant c_digits   : natural := g_wide/2;
+  constant c_cnt_wide : natural := f_opa_log2(c_digits+1);
+  
+  type t_div is (DIV_IDLE, DIV_ABS, DIV_PREP, DIV_RUN, DIV_FIX);
+  
+  function f_clz(x : unsigned) return natural is
+    alias y : unsigned(x'length-1 downto 0) is x;
+  begin
+    for i in y'range loop
+      if y(i) = '1' then return y'high - i; end if;
+    end loop;
+    return y'length;
+  end f_clz;
+  
+  function f_neg(x : unsigned; s : std_logic) return unsigned is
+  begin
+    if s = '1' then return 0 - x; else return x; end if;
+  end f_neg;
+  
+  signal r_state : t_div := DIV_IDLE;
+  signal r_valid : std_logic := '0';
+  signal r_done  : std_logic := '0';
+  signal r_sign  : std_logic;
+  signal r_a     : std_logic_vector(g_wide-1 downto 0);
+  signal r_b     : std_logic_vector(g_wide-1 downto 0);
+  signal s_hit   : std_logic;
+  signal s_take  : std_logic;
+  signal r_ask   : std_logic := '0';
+  signal r_asign : std_logic;
+  signal r_aa    : std_logic_vector(g_wide-1 downto 0);
+  signal r_ab    : std_logic_vector(g_wide-1 downto 0);
+  
+  signal r_nega  : std_logic;
+  signal r_negq  : std_logic;
+  signal r_na    : unsigned(g_wide-1 downto 0);
+  signal r_nb    : unsigned(g_wide-1 downto 0);
+  signal s_clza  : natural range 0 to g_wide;
+  signal s_clzb  : natural range 0 to g_wide;
+  signal s_m     : natural range 0 to c_digits;
+  signal r_cnt   : unsigned(c_cnt_wide-1 downto 0);
+  
+  signal r_d1    : unsigned(g_wide+2 downto 0);
+  signal r_d3    : unsigned(g_wide+2 downto 0);
+  signal r_p     : unsigned(g_wide-1 downto 0); -- partial remainder, always < divisor
+  signal r_x     : unsigned(g_wide-1 downto 0); -- dividend bits not yet used, then quotient
+  signal s_p4    : unsigned(g_wide+2 downto 0);
+  signal s_t1    : unsigned(g_wide+2 downto 0);
+  signal s_t2    : unsigned(g_wide+2 downto 0);
+  signal s_t3    : unsigned(g_wide+2 downto 0);
+  
+  signal r_q     : std_logic_vector(g_wide-1 downto 0);
+  signal r_r     : std_logic_vector(g_wide-1 downto 0);
+
+begin
+
+  check : process(clk_i) is
+  begin
+    if rising_edge(clk_i) then
+      assert (f_opa_safe(stb_i) = '1') report "prim_div: stb_i has metavalue" severity failure;
+      assert (g_wide mod 2 = 0) report "prim_div: g_wide must be even" severity failure;
+    end if;
+  end process;
+  
+  s_hit  <= r_valid and f_opa_eq(a_i, r_a) and f_opa_eq(b_i, r_b) and not (sign_i xor r_sign);
+  s_take <= r_ask and (old_i or not r_valid);
+  
+  -- Only digits which can be non-zero are computed, so small quotients finish early.
+  -- A zero divisor runs every digit, giving the all-ones quotient RISC-V expects.
+  s_clza <= f_clz(r_na);
+  s_clzb <= f_clz(r_nb);
+  s_m <= c_digits when s_clzb = g_wide else
+         0        when s_clzb < s_clza else
+         f_opa_choose((s_clzb-s_clza)/2+1 < c_digits, (s_clzb-s_clza)/2+1, c_digits);
+  
+  -- One radix-4 digit per cycle; the three subtractions run in parallel on the carry chains
+  s_p4 <= "0" & r_p & r_x(g_wide-1 downto g_wide-2);
+  s_t1 <= s_p4 - r_d1;
+  s_t2 <= s_p4 - (r_d1(g_wide+1 downto 0) & "0");
+  s_t3 <= s_p4 - r_d3;
+  
+  main : process(clk_i, rst_n_i) is
+  begin
+    if rst_n_i = '0' then
+      r_state <= DIV_IDLE;
+      r_valid <= '0';
+      r_done  <= '0';
+      r_ask   <= '0';
+    elsif rising_edge(clk_i) then
+      r_done <= stb_i and s_hit and f_opa_bit(r_state = DIV_IDLE);
+      r_ask  <= stb_i and not s_hit;
+      
+      -- Once collected, the divider is free for any request
+      if (stb_i and s_hit and f_opa_bit(r_state = DIV_IDLE)) = '1' then
+        r_valid <= '0';
+      end if;
+      
+      case r_state is
+        when DIV_IDLE =>
+          null;
+        when DIV_ABS =>
+          r_nega  <= r_sign and r_a(g_wide-1);
+          r_negq  <= r_sign and (r_a(g_wide-1) xor r_b(g_wide-1)) and f_opa_or(r_b);
+          r_na    <= f_neg(unsigned(r_a), r_sign and r_a(g_wide-1));
+          r_nb    <= f_neg(unsigned(r_b), r_sign and r_b(g_wide-1));
+          r_state <= DIV_PREP;
+        when DIV_PREP =>
+          r_d1  <= "000" & r_nb;
+          r_d3  <= ("00" & r_nb & "0") + ("000" & r_nb);
+          r_p   <= shift_right(r_na, 2*s_m);
+          r_x   <= shift_left (r_na, g_wide-2*s_m);
+          r_cnt <= to_unsigned(s_m, c_cnt_wide);
+          if s_m = 0 then
+            r_state <= DIV_FIX;
+          else
+            r_state <= DIV_RUN;
+          end if;
+        when DIV_RUN =>
+          if s_t3(g_wide+2) = '0' then
+            r_p <= s_t3(g_wide-1 downto 0);
+            r_x <= r_x(g_wide-3 downto 0) & "11";
+          elsif s_t2(g_wide+2) = '0' then
+            r_p <= s_t2(g_wide-1 downto 0);
+            r_x <= r_x(g_wide-3 downto 0) & "10";
+          elsif s_t1(g_wide+2) = '0' then
+            r_p <= s_t1(g_wide-1 downto 0);
+            r_x <= r_x(g_wide-3 downto 0) & "01";
+          else
+            r_p <= s_p4(g_wide-1 downto 0);
+            r_x <= r_x(g_wide-3 downto 0) & "00";
+          end if;
+          r_cnt <= r_cnt - 1;
+          if r_cnt = 1 then
+            r_state <= DIV_FIX;
+          end if;
+        when DIV_FIX =>
+          r_q     <= std_logic_vector(f_neg(r_x, r_negq));
+          r_r     <= std_logic_vector(f_neg(r_p, r_nega));
+          r_state <= DIV_IDLE;
+      end case;
+      
+      -- A missed request takes over a free divider; the oldest op takes any
+      if s_take = '1' then
+        r_valid <= '1';
+        r_state <= DIV_ABS;
+      end if;
+    end if;
+  end process;
+  
+  tag : process(clk_i) is
+  begin
+    if rising_edge(clk_i) then
+      r_asign <= sign_i;
+      r_aa    <= a_i;
+      r_ab    <= b_i;
+      if s_take = '1' then
+        r_sign <= r_asign;
+        r_a    <= r_aa;
+        r_b    <= r_ab;
+      end if;
+    end if;
+  end process;
+  
+  done_o <= r_done;
+  q_o    <= r_q;
+  r_o    <= r_r;
+
+end rtl;
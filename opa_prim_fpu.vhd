@@ -0,0 +1,476 @@
+--  opa: Open Processor Architecture
+--  Copyright (C) 2014-2016  Wesley W. Terpstra
+--
+--  This program is free software: you can redistribute it and/or modify
+--  it under the terms of the GNU General Public License as published by
+--  the Free Software Foundation, either version 3 of the License, or
+--  (at your option) any later version.
+--
+--  This program is distributed in the hope that it will be useful,
+--  but WITHOUT ANY WARRANTY; without even the implied warranty of
+--  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+--  GNU General Public License for more details.
+--
+--  You should have received a copy of the GNU General Public License
+--  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+--
+--  To apply the GPL to my VHDL, please follow these definitions:
+--    Program        - The entire collection of VHDL in this project and any
+--                     netlist or floorplan derived from it.
+--    System Library - Any macro that translates directly to hardware
+--                     e.g. registers, IO pins, or memory blocks
+--    
+--  My intent is that if you include OPA into your project, all of the HDL
+--  and other design files that go into the same physical chip must also
+--  be released under the GPL. If this does not cover your usage, then you
+--  must consult me directly to receive the code under a different license.
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library work;
+use work.opa_pkg.all;
+use work.opa_isa_base_pkg.all;
+use work.opa_functions_pkg.all;
+use work.opa_components_pkg.all;
+
+-- Single precision IEEE 754 unit for the slow EUs; one cycle longer than opa_prim_mul.
+-- Stage 1 unpacks, aligns and resolves everything that needs no rounding.
+-- Stage 2 adds; the multiplier registers its mantissa product alongside.
+-- Stage 3 normalizes, rounds and packs.
+entity opa_prim_fpu is
+  generic(
+    g_target : t_opa_target);
+  port(
+    clk_i    : in  std_logic;
+    op_i     : in  std_logic_vector(2 downto 0);
+    fn_i     : in  std_logic_vector(1 downto 0);
+    rm_i     : in  std_logic_vector(2 downto 0);
+    a_i      : in  std_logic_vector(31 downto 0);
+    b_i      : in  std_logic_vector(31 downto 0);
+    x_o      : out std_logic_vector(31 downto 0)); -- 4 cycles later
+end opa_prim_fpu;
+
+architecture rtl of opa_prim_fpu is
+
+  constant c_rtz  : std_logic_vector(2 downto 0) := "001";
+  constant c_rdn  : std_logic_vector(2 downto 0) := "010";
+  constant c_rup  : std_logic_vector(2 downto 0) := "011";
+  constant c_rmm  : std_logic_vector(2 downto 0) := "100";
+  constant c_qnan : std_logic_vector(31 downto 0) := x"7fc00000";
+  constant c_inf  : std_logic_vector(30 downto 0) := "1111111100000000000000000000000";
+  constant c_huge : std_logic_vector(30 downto 0) := "1111111011111111111111111111111";
+  constant c_pad  : unsigned(14 downto 0) := (others => '0');
+  
+  -- An unpacked exponent, biased like the packed one
+  subtype t_exp is integer range -512 to 511;
+  
+  -- Does rounding move the magnitude up?
+  function f_round(rm : std_logic_vector(2 downto 0); sign, lsb, guard, sticky : std_logic) return std_logic is
+  begin
+    case rm is
+      when c_rtz  => return '0';
+      when c_rdn  => return sign and (guard or sticky);
+      when c_rup  => return not sign and (guard or sticky);
+      when c_rmm  => return guard;
+      when others => return guard and (sticky or lsb); -- to nearest even, also dynamic
+    end case;
+  end f_round;
+  
+  -- Does an overflow become infinity (or the largest finite number)?
+  function f_ovf_inf(rm : std_logic_vector(2 downto 0); sign : std_logic) return std_logic is
+  begin
+    case rm is
+      when c_rtz  => return '0';
+      when c_rdn  => return sign;
+      when c_rup  => return not sign;
+      when others => return '1';
+    end case;
+  end f_ovf_inf;
+  
+  function f_clz(x : unsigned) return natural is
+    alias y : unsigned(x'length-1 downto 0) is x;
+  begin
+    for i in y'range loop
+      if y(i) = '1' then return y'high - i; end if;
+    end loop;
+    return y'length;
+  end f_clz;
+  
+  -- Shift right, folding everything shifted out into the lowest bit
+  function f_shr_sticky(x : unsigned; n : natural) return unsigned is
+    alias y : unsigned(x'length-1 downto 0) is x;
+    constant c_ones : unsigned(x'length-1 downto 0) := (others => '1');
+    variable result : unsigned(x'length-1 downto 0);
+  begin
+    result := shift_right(y, n);
+    if (y and not shift_left(c_ones, n)) /= 0 then
+      result(0) := '1';
+    end if;
+    return result;
+  end f_shr_sticky;
+  
+  -- Value is m/2**47 * 2**(e-127); normalize, round and pack it
+  function f_pack(m : unsigned(47 downto 0); e : t_exp; sign, zsign : std_logic; rm : std_logic_vector(2 downto 0)) 
+    return std_logic_vector is
+    variable lz     : natural range 0 to 48;
+    variable n      : unsigned(47 downto 0);
+    variable x      : t_exp;
+    variable q      : unsigned(24 downto 0);
+    variable result : std_logic_vector(31 downto 0);
+  begin
+    result := (others => '0');
+    if m = 0 then
+      result(31) := zsign;
+      return result;
+    end if;
+    
+    -- Normalize, but never below the smallest exponent; that is a subnormal
+    lz := f_clz(m);
+    if e - lz >= 1 then
+      n := shift_left(m, lz);
+      x := e - lz;
+    elsif e >= 1 then
+      n := shift_left(m, e-1);
+      x := 1;
+    else
+      n := f_shr_sticky(m, 1-e);
+      x := 1;
+    end if;
+    
+    q := "0" & n(47 downto 24);
+    if f_round(rm, sign, n(24), n(23), f_opa_or(std_logic_vector(n(22 downto 0)))) = '1' then
+      q := q + 1;
+    end if;
+    if q(24) = '1' then
+      q := "0" & q(24 downto 1);
+      x := x + 1;
+    end if;
+    
+    result(31) := sign;
+    if x >= 255 then
+      if f_ovf_inf(rm, sign) = '1' then
+        result(30 downto 0) := c_inf;
+      else
+        result(30 downto 0) := c_huge;
+      end if;
+    else
+      if q(23) = '1' then
+        result(30 downto 23) := std_logic_vector(to_unsigned(x, 8));
+      end if;
+      result(22 downto 0) := std_logic_vector(q(22 downto 0));
+    end if;
+    return result;
+  end f_pack;
+  
+  signal s_ma0    : std_logic_vector(23 downto 0);
+  signal s_mb0    : std_logic_vector(23 downto 0);
+  signal s_prod   : std_logic_vector(47 downto 0); -- available in stage 3
+  
+  signal r_op     : std_logic_vector(2 downto 0);
+  signal r_fn     : std_logic_vector(1 downto 0);
+  signal r_rm     : std_logic_vector(2 downto 0);
+  signal r_a      : std_logic_vector(31 downto 0);
+  signal r_b      : std_logic_vector(31 downto 0);
+  
+  signal r2_op    : std_logic_vector(2 downto 0);
+  signal r2_fn    : std_logic_vector(1 downto 0);
+  signal r2_rm    : std_logic_vector(2 downto 0);
+  signal r2_spec  : std_logic; -- r2_x is the result
+  signal r2_x     : std_logic_vector(31 downto 0);
+  signal r2_big   : unsigned(32 downto 0);
+  signal r2_small : unsigned(32 downto 0);
+  signal r2_sub   : std_logic;
+  signal r2_sign  : std_logic;
+  signal r2_zsign : std_logic; -- sign of an exact zero result
+  signal r2_e     : t_exp;
+  signal r2_int   : unsigned(31 downto 0);
+  signal r2_guard : std_logic;
+  signal r2_stick : std_logic;
+  signal r2_ovf   : std_logic;
+  signal r2_nan   : std_logic;
+  
+  signal r3_op    : std_logic_vector(2 downto 0);
+  signal r3_fn    : std_logic_vector(1 downto 0);
+  signal r3_rm    : std_logic_vector(2 downto 0);
+  signal r3_spec  : std_logic;
+  signal r3_x     : std_logic_vector(31 downto 0);
+  signal r3_sum   : unsigned(32 downto 0);
+  signal r3_sign  : std_logic;
+  signal r3_zsign : std_logic;
+  signal r3_e     : t_exp;
+  signal r3_mag   : unsigned(32 downto 0);
+  signal r3_ovf   : std_logic;
+  signal r3_nan   : std_logic;
+  signal r_x      : std_logic_vector(31 downto 0);
+
+begin
+
+  -- The mantissa product comes from the integer multiplier; it is ready for stage 3
+  s_ma0 <= f_opa_or(a_i(30 downto 23)) & a_i(22 downto 0);
+  s_mb0 <= f_opa_or(b_i(30 downto 23)) & b_i(22 downto 0);
+  
+  mul : opa_prim_mul
+    generic map(
+      g_wide   => 24,
+      g_regout => true,
+      g_regwal => false,
+      g_split  => false,
+      g_target => g_target)
+    port map(
+      clk_i    => clk_i,
+      sexta_i  => '0',
+      sextb_i  => '0',
+      a_i      => s_ma0,
+      b_i      => s_mb0,
+      x_o      => s_prod);
+  
+  edge1 : process(clk_i) is
+  begin
+    if rising_edge(clk_i) then
+      r_op <= op_i;
+      r_fn <= fn_i;
+      r_rm <= rm_i;
+      r_a  <= a_i;
+      r_b  <= b_i;
+    end if;
+  end process;
+  
+  stage1 : process(clk_i) is
+    variable sa, sb, sbe   : std_logic;
+    variable ea, eb        : unsigned(7 downto 0);
+    variable ma, mb        : unsigned(23 downto 0);
+    variable xa, xb        : t_exp;
+    variable a_zero, b_zero: std_logic;
+    variable a_inf,  b_inf : std_logic;
+    variable a_nan,  b_nan : std_logic;
+    variable a_sub         : std_logic;
+    variable lt_mag, gt_mag: std_logic;
+    variable lt, eq        : std_logic;
+    variable neg           : std_logic;
+    variable mag           : unsigned(31 downto 0);
+    variable fix           : unsigned(33 downto 0);
+    variable class         : std_logic_vector(9 downto 0);
+  begin
+    if rising_edge(clk_i) then
+      sa := r_a(31);
+      sb := r_b(31);
+      ea := unsigned(r_a(30 downto 23));
+      eb := unsigned(r_b(30 downto 23));
+      ma := unsigned(f_opa_or(r_a(30 downto 23)) & r_a(22 downto 0));
+      mb := unsigned(f_opa_or(r_b(30 downto 23)) & r_b(22 downto 0));
+      -- subnormals share the exponent of the smallest normals
+      xa := to_integer(ea); if ea = 0 then xa := 1; end if;
+      xb := to_integer(eb); if eb = 0 then xb := 1; end if;
+      
+      a_zero := f_opa_bit(ea = 0) and not f_opa_or(r_a(22 downto 0));
+      b_zero := f_opa_bit(eb = 0) and not f_opa_or(r_b(22 downto 0));
+      a_sub  := f_opa_bit(ea = 0) and f_opa_or(r_a(22 downto 0));
+      a_inf  := f_opa_and(r_a(30 downto 23)) and not f_opa_or(r_a(22 downto 0));
+      b_inf  := f_opa_and(r_b(30 downto 23)) and not f_opa_or(r_b(22 downto 0));
+      a_nan  := f_opa_and(r_a(30 downto 23)) and f_opa_or(r_a(22 downto 0));
+      b_nan  := f_opa_and(r_b(30 downto 23)) and f_opa_or(r_b(22 downto 0));
+      
+      -- Magnitudes order like the integers formed by exponent and mantissa
+      lt_mag := f_opa_bit(unsigned(r_a(30 downto 0)) < unsigned(r_b(30 downto 0)));
+      gt_mag := f_opa_bit(unsigned(r_a(30 downto 0)) > unsigned(r_b(30 downto 0)));
+      -- For min/max, -0 < +0
+      lt := (sa and not sb) or (not sa and not sb and lt_mag) or (sa and sb and gt_mag);
+      eq := f_opa_bit(r_a = r_b) or (a_zero and b_zero);
+      
+      r2_op    <= r_op;
+      r2_fn    <= r_fn;
+      r2_rm    <= r_rm;
+      r2_spec  <= '1';
+      r2_x     <= c_qnan;
+      r2_big   <= (others => '0');
+      r2_small <= (others => '0');
+      r2_sub   <= '0';
+      r2_sign  <= '0';
+      r2_zsign <= '0';
+      r2_e     <= 0;
+      r2_nan   <= a_nan;
+      r2_ovf   <= f_opa_bit(xa > 158);
+      
+      case r_op is
+        when c_opa_fp_arith =>
+          if r_fn(1) = '1' then -- multiply
+            r2_sign  <= sa xor sb;
+            r2_zsign <= sa xor sb;
+            r2_e     <= xa + xb - 126;
+            if (a_nan or b_nan or (a_inf and b_zero) or (a_zero and b_inf)) = '1' then
+              r2_x <= c_qnan;
+            elsif (a_inf or b_inf) = '1' then
+              r2_x <= (sa xor sb) & c_inf;
+            else
+              r2_spec <= '0';
+            end if;
+          else -- add/subtract; the larger magnitude goes first and the other is aligned to it
+            sbe := sb xor r_fn(0);
+            r2_sub   <= sa xor sbe;
+            r2_zsign <= (sa and sbe) or ((sa xor sbe) and f_opa_eq(r_rm, c_rdn));
+            if lt_mag = '1' then
+              r2_sign  <= sbe;
+              r2_e     <= xb + 1;
+              r2_big   <= "0" & mb & x"00";
+              r2_small <= f_shr_sticky("0" & ma & x"00", xb - xa);
+            else
+              r2_sign  <= sa;
+              r2_e     <= xa + 1;
+              r2_big   <= "0" & ma & x"00";
+              r2_small <= f_shr_sticky("0" & mb & x"00", xa - xb);
+            end if;
+            if (a_nan or b_nan or (a_inf and b_inf and (sa xor sbe))) = '1' then
+              r2_x <= c_qnan;
+            elsif a_inf = '1' then
+              r2_x <= sa  & c_inf;
+            elsif b_inf = '1' then
+              r2_x <= sbe & c_inf;
+            else
+              r2_spec <= '0';
+            end if;
+          end if;
+        when c_opa_fp_i2f =>
+          neg := not r_fn(0) and r_a(31);
+          mag := unsigned(r_a);
+          if neg = '1' then mag := 0 - mag; end if;
+          r2_spec <= '0';
+          r2_sign <= neg;
+          r2_e    <= 159;
+          r2_big  <= "0" & mag;
+        when c_opa_fp_f2i =>
+          -- two fraction bits: guard and sticky
+          fix := ma & "0000000000";
+          if xa <= 158 then
+            fix := f_shr_sticky(fix, 158 - xa);
+          end if;
+          r2_spec  <= '0';
+          r2_sign  <= sa;
+          r2_int   <= fix(33 downto 2);
+          r2_guard <= fix(1);
+          r2_stick <= fix(0);
+        when c_opa_fp_sgnj =>
+          case r_fn is
+            when "00"   => r2_x <= sb & r_a(30 downto 0);
+            when "01"   => r2_x <= not sb & r_a(30 downto 0);
+            when others => r2_x <= (sa xor sb) & r_a(30 downto 0);
+          end case;
+        when c_opa_fp_minmax =>
+          if (a_nan and b_nan) = '1' then
+            r2_x <= c_qnan;
+          elsif a_nan = '1' then
+            r2_x <= r_b;
+          elsif b_nan = '1' then
+            r2_x <= r_a;
+          elsif (lt xor r_fn(0)) = '1' then
+            r2_x <= r_a;
+          else
+            r2_x <= r_b;
+          end if;
+        when c_opa_fp_cmp =>
+          r2_x <= (others => '0');
+          if (a_nan or b_nan) = '0' then
+            case r_fn is
+              when "00"   => r2_x(0) <= (lt and not (a_zero and b_zero)) or eq;
+              when "01"   => r2_x(0) <= lt and not eq;
+              when others => r2_x(0) <= eq;
+            end case;
+          end if;
+        when c_opa_fp_class =>
+          class(0) := sa and a_inf;
+          class(1) := sa and not (a_zero or a_sub or a_inf or a_nan);
+          class(2) := sa and a_sub;
+          class(3) := sa and a_zero;
+          class(4) := not sa and a_zero;
+          class(5) := not sa and a_sub;
+          class(6) := not sa and not (a_zero or a_sub or a_inf or a_nan);
+          class(7) := not sa and a_inf;
+          class(8) := a_nan and not r_a(22);
+          class(9) := a_nan and r_a(22);
+          r2_x <= (others => '0');
+          r2_x(9 downto 0) <= class;
+        when others =>
+          r2_x <= (others => 'X');
+      end case;
+    end if;
+  end process;
+  
+  -- Each path through here has a single carry chain
+  stage2 : process(clk_i) is
+    variable mag : unsigned(32 downto 0);
+  begin
+    if rising_edge(clk_i) then
+      if r2_sub = '1' then
+        r3_sum <= r2_big - r2_small;
+      else
+        r3_sum <= r2_big + r2_small;
+      end if;
+      
+      mag := "0" & r2_int;
+      if f_round(r2_rm, r2_sign, r2_int(0), r2_guard, r2_stick) = '1' then
+        mag := mag + 1;
+      end if;
+      r3_mag <= mag;
+      
+      r3_op    <= r2_op;
+      r3_fn    <= r2_fn;
+      r3_rm    <= r2_rm;
+      r3_spec  <= r2_spec;
+      r3_x     <= r2_x;
+      r3_sign  <= r2_sign;
+      r3_zsign <= r2_zsign;
+      r3_e     <= r2_e;
+      r3_ovf   <= r2_ovf;
+      r3_nan   <= r2_nan;
+    end if;
+  end process;
+  
+  stage3 : process(clk_i) is
+    variable m : unsigned(47 downto 0);
+  begin
+    if rising_edge(clk_i) then
+      if f_opa_eq(r3_op, c_opa_fp_arith) = '1' and r3_fn(1) = '1' then
+        m := unsigned(s_prod);
+      else
+        m := r3_sum & c_pad;
+      end if;
+      
+      if r3_spec = '1' then
+        r_x <= r3_x;
+      elsif f_opa_eq(r3_op, c_opa_fp_f2i) = '1' then
+        -- out of range saturates; NaN counts as positive
+        if r3_fn(0) = '0' then
+          if (r3_nan or not r3_sign) = '1' then
+            if (r3_nan or r3_ovf or r3_mag(32) or r3_mag(31)) = '1' then
+              r_x <= x"7fffffff";
+            else
+              r_x <= std_logic_vector(r3_mag(31 downto 0));
+            end if;
+          else
+            if (r3_ovf or r3_mag(32) or (r3_mag(31) and f_opa_or(std_logic_vector(r3_mag(30 downto 0))))) = '1' then
+              r_x <= x"80000000";
+            else
+              r_x <= std_logic_vector(0 - r3_mag(31 downto 0));
+            end if;
+          end if;
+        else
+          if (r3_nan or not r3_sign) = '1' then
+            if (r3_nan or r3_ovf or r3_mag(32)) = '1' then
+              r_x <= x"ffffffff";
+            else
+              r_x <= std_logic_vector(r3_mag(31 downto 0));
+            end if;
+          else
+            r_x <= (others => '0');
+          end if;
+        end if;
+      else
+        r_x <= f_pack(m, r3_e, r3_sign, r3_zsign, r3_rm);
+      end if;
+    end if;
+  end process;
+  
+  x_o <= r_x;
+
+end rtl;
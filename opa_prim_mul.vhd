@@ -41,9 +41,12 @@ entity opa_prim_mul is
     g_wide   : natural;
     g_regout : boolean;
     g_regwal : boolean;
+    g_split  : boolean; -- with g_regout, the upper half is summed after the register
     g_target : t_opa_target);
   port(
     clk_i    : in  std_logic;
+    sexta_i  : in  std_logic; -- a_i is signed
+    sextb_i  : in  std_logic; -- b_i is signed
     a_i      : in  std_logic_vector(  g_wide-1 downto 0);
     b_i      : in  std_logic_vector(  g_wide-1 downto 0);
     x_o      : out std_logic_vector(2*g_wide-1 downto 0));
@@ -189,7 +192,9 @@ architecture rtl of opa_prim_mul is
   constant c_add_wide     : natural := c_add_mul_wide*c_add_parts;
   constant c_wallace      : natural := f_opa_choose(c_post_adder, c_add_wallace, c_raw_wallace);
   constant c_wide         : natural := f_opa_choose(c_post_adder, c_add_wide,    c_raw_wide);
-  constant c_num_sum      : natural := f_opa_choose(c_wallace<c_add_width, c_wallace, c_add_width);
+  constant c_rows         : natural := c_wallace + 3; -- plus the signed correction
+  constant c_num_sum      : natural := f_opa_choose(c_rows<c_add_width, c_rows, c_add_width);
+  constant c_carry_wide   : natural := f_opa_log2(c_num_sum);
   
   constant c_zeros : unsigned(c_add_mul_wide-1 downto 0) := (others => '0');
   
@@ -197,14 +202,19 @@ architecture rtl of opa_prim_mul is
   type t_raw_mul_out is array(c_raw_parts*c_raw_parts  -1 downto 0) of unsigned(2*c_raw_mul_wide-1 downto 0);
   type t_add_mul_out is array(c_add_parts*c_add_parts/2-1 downto 0) of unsigned(3*c_add_mul_wide-1 downto 0);
   type t_sum_in      is array(c_num_sum-1                 downto 0) of unsigned(2*c_wide-1         downto 0);
+  type t_cor         is array(2 downto 0)                   of unsigned(2*c_wide-1         downto 0);
   signal r_a     : unsigned(c_wide-1 downto 0);
   signal r_b     : unsigned(c_wide-1 downto 0);
+  signal r_nega  : std_logic;
+  signal r_negb  : std_logic;
+  signal s_cor   : t_cor;
+  signal r_cor   : t_cor; -- optional register (g_regwal)
   signal s_mul_a : t_add_mul_out;
   signal s_mul_r : t_raw_mul_out;
   signal r_mul_a : t_add_mul_out; -- optional register (g_regwal)
   signal r_mul_r : t_raw_mul_out; -- optional register (g_regwal)
   
-  signal s_wal_i : t_opa_matrix(c_wallace  -1 downto 0, 2*c_wide-1 downto 0) := (others => (others => '0'));
+  signal s_wal_i : t_opa_matrix(c_rows     -1 downto 0, 2*c_wide-1 downto 0) := (others => (others => '0'));
   signal s_wal_o : t_opa_matrix(c_add_width-1 downto 0, 2*c_wide-1 downto 0);
   signal r_wal   : t_sum_in; -- result of wallace tree
   signal s_sum3  : unsigned(2*c_wide-1 downto 0);
@@ -232,9 +242,43 @@ begin
       r_b <= (others => '0');
       r_a(a_i'range) <= unsigned(a_i);
       r_b(b_i'range) <= unsigned(b_i);
+      -- A low multiply leaves the signs as don't care; treat those as unsigned
+      r_nega <= '0';
+      r_negb <= '0';
+      if sexta_i = '1' then r_nega <= a_i(g_wide-1); end if;
+      if sextb_i = '1' then r_negb <= b_i(g_wide-1); end if;
     end if;
   end process;
   
+  -- Signed operands: a*b = ua*ub - 2**g_wide*(nega*ub + negb*ua)  (mod 2**(2*g_wide))
+  -- Each subtraction becomes an inverted row plus one; both ones share the last row.
+  cor : process(r_a, r_b, r_nega, r_negb) is
+    variable ya : unsigned(g_wide-1 downto 0);
+    variable yb : unsigned(g_wide-1 downto 0);
+  begin
+    ya := (others => '0');
+    yb := (others => '0');
+    if r_nega = '1' then ya := r_b(ya'range); end if;
+    if r_negb = '1' then yb := r_a(yb'range); end if;
+    s_cor <= (others => (others => '0'));
+    s_cor(0)(2*g_wide-1 downto g_wide) <= not ya;
+    s_cor(1)(2*g_wide-1 downto g_wide) <= not yb;
+    s_cor(2)(g_wide+1) <= '1';
+  end process;
+  
+  edge2c : process(clk_i) is
+  begin
+    if rising_edge(clk_i) then
+      r_cor <= s_cor;
+    end if;
+  end process;
+  
+  cor_rows : for i in 0 to 2 generate
+    bits : for b in 0 to 2*c_wide-1 generate
+      s_wal_i(c_wallace+i, b) <= r_cor(i)(b) when g_regwal else s_cor(i)(b);
+    end generate;
+  end generate;
+  
   -- Deal with simple DSP hardware
   raw_mul : if not c_post_adder generate
     mul_rows : for i in 0 to c_raw_parts-1 generate
@@ -364,14 +408,60 @@ begin
   
   s_sum <= s_sum3 when c_num_sum=3 else s_sumx;
   
-  reg : process(clk_i) is
-  begin
-    if rising_edge(clk_i) then
-      r_sum <= s_sum;
-    end if;
-  end process;
+  whole : if not (g_regout and g_split) generate
+    reg : process(clk_i) is
+    begin
+      if rising_edge(clk_i) then
+        r_sum <= s_sum;
+      end if;
+    end process;
+    
+    x_o <= std_logic_vector(r_sum(x_o'range)) when g_regout else
+           std_logic_vector(s_sum(x_o'range));
+  end generate;
   
-  x_o <= std_logic_vector(r_sum(x_o'range)) when g_regout else
-         std_logic_vector(s_sum(x_o'range));
+  -- Halve the carry chain in front of the output register; the upper half
+  -- (and its carry in) is finished after it, where the consumer only muxes.
+  split : if g_regout and g_split generate
+    type t_half is array(c_num_sum-1 downto 0) of unsigned(g_wide-1 downto 0);
+    signal s_lo    : unsigned(g_wide+c_carry_wide-1 downto 0);
+    signal r_lo    : unsigned(g_wide-1 downto 0);
+    signal r_carry : unsigned(c_carry_wide-1 downto 0);
+    signal r_hi    : t_half;
+    signal s_hi    : unsigned(g_wide-1 downto 0);
+  begin
+    lo : process(r_wal) is
+      variable acc : unsigned(s_lo'range);
+    begin
+      acc := (others => '0');
+      for i in 0 to c_num_sum-1 loop
+        acc := acc + r_wal(i)(g_wide-1 downto 0);
+      end loop;
+      s_lo <= acc;
+    end process;
+    
+    reg : process(clk_i) is
+    begin
+      if rising_edge(clk_i) then
+        r_lo    <= s_lo(g_wide-1 downto 0);
+        r_carry <= s_lo(s_lo'high downto g_wide);
+        for i in 0 to c_num_sum-1 loop
+          r_hi(i) <= r_wal(i)(2*g_wide-1 downto g_wide);
+        end loop;
+      end if;
+    end process;
+    
+    hi : process(r_hi, r_carry) is
+      variable acc : unsigned(s_hi'range);
+    begin
+      acc := resize(r_carry, g_wide);
+      for i in 0 to c_num_sum-1 loop
+        acc := acc + r_hi(i);
+      end loop;
+      s_hi <= acc;
+    end process;
+    
+    x_o <= std_logic_vector(s_hi & r_lo);
+  end generate;
 
 end rtl;
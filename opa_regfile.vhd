@@ -61,6 +61,8 @@ entity opa_regfile is
     issue_dec_i  : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_ren_wide  (g_config)-1 downto 0);
     issue_baka_i : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide (g_isa,g_config)-1 downto 0);
     issue_bakb_i : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide (g_isa,g_config)-1 downto 0);
+    issue_long_i : in  std_logic_vector(f_opa_executers(g_config)-1 downto 0); -- result one cycle late
+    issue_stat_i : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_stat_wide (g_config)-1 downto 0); -- lower is older
     
     -- Feed the EUs one cycle later (they register this => result is two cycles later)
     eu_stb_o     : out std_logic_vector(f_opa_executers(g_config)-1 downto 0);
@@ -77,7 +79,10 @@ entity opa_regfile is
     issue_bakx_i : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_back_wide(g_isa,g_config)-1 downto 0);
     
     -- The results arrive two cycles after the issue said they would
-    eu_regx_i    : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0));
+    eu_regx_i    : in  t_opa_matrix(f_opa_executers(g_config)-1 downto 0, f_opa_reg_wide(g_config)-1 downto 0);
+    
+    -- A read bank was busy; the EU did not run, so issue must re-run it (with the EU retry)
+    issue_retry_o : out std_logic_vector(f_opa_executers(g_config)-1 downto 0));
 end opa_regfile;
 
 architecture rtl of opa_regfile is
@@ -227,12 +232,30 @@ architecture rtl of opa_regfile is
   constant c_reg_indexes : t_opa_matrix := f_indexes(c_executers*1);
   constant c_mem_indexes : t_opa_matrix := f_indexes(c_executers*2);
   
+  -- Which mux inputs come from a memory block
+  function f_mem_mask return std_logic_vector is
+    variable result : std_logic_vector(c_num_mux-1 downto 0) := (others => '0');
+  begin
+    for i in f_mem(0) to f_mem(c_executers)-1 loop
+      result(i) := '1';
+    end loop;
+    return result;
+  end f_mem_mask;
+  constant c_mem_mask : std_logic_vector(c_num_mux-1 downto 0) := f_mem_mask;
+  
   signal r_rstb0       : std_logic_vector(c_executers-1 downto 0);
   signal r_wstb0       : std_logic_vector(c_executers-1 downto 0);
   signal r_wstb1       : std_logic_vector(c_executers-1 downto 0);
   signal r_bakx0       : t_opa_matrix(c_executers-1 downto 0, c_back_wide-1 downto 0);
   signal r_bakx1       : t_opa_matrix(c_executers-1 downto 0, c_back_wide-1 downto 0);
   signal r_regx        : t_opa_matrix(c_executers-1 downto 0, c_reg_wide -1 downto 0);
+  signal s_conf        : std_logic_vector(c_executers-1 downto 0);
+  signal r_conf0       : std_logic_vector(c_executers-1 downto 0);
+  signal r_conf1       : std_logic_vector(c_executers-1 downto 0);
+  signal r_conf2       : std_logic_vector(c_executers-1 downto 0);
+  signal r_long0       : std_logic_vector(c_executers-1 downto 0);
+  signal r_long1       : std_logic_vector(c_executers-1 downto 0);
+  signal r_late        : std_logic_vector(c_executers-1 downto 0);
   
   signal s_map_set     : std_logic_vector(c_num_back-1 downto 0);
   signal s_map_match   : t_opa_matrix(c_num_back-1 downto 0, c_executers-1 downto 0);
@@ -287,6 +310,8 @@ architecture rtl of opa_regfile is
   type t_mux is array(c_executers*c_reg_wide-1 downto 0) of std_logic_vector(c_num_mux-1 downto 0);
   signal s_mux_a     : t_mux;
   signal s_mux_b     : t_mux;
+  signal s_mux_idx_a : t_opa_matrix(c_executers-1 downto 0, c_mux_wide-1 downto 0);
+  signal s_mux_idx_b : t_opa_matrix(c_executers-1 downto 0, c_mux_wide-1 downto 0);
   signal r_mux_idx_a : t_opa_matrix(c_executers-1 downto 0, c_mux_wide-1 downto 0);
   signal r_mux_idx_b : t_opa_matrix(c_executers-1 downto 0, c_mux_wide-1 downto 0);
 
@@ -317,6 +342,28 @@ begin
     end if;
   end process;
   
+  -- Conflicts are reported alongside the EU retry, two cycles after the EU would start.
+  -- Issue finalizes a long op one cycle later, so its conflict is held back a cycle.
+  conflict : process(clk_i, rst_n_i) is
+  begin
+    if rst_n_i = '0' then
+      r_conf0 <= (others => '0');
+      r_conf1 <= (others => '0');
+      r_conf2 <= (others => '0');
+      r_long0 <= (others => '0');
+      r_long1 <= (others => '0');
+      r_late  <= (others => '0');
+    elsif rising_edge(clk_i) then
+      r_conf0 <= s_conf and issue_rstb_i;
+      r_conf1 <= r_conf0;
+      r_long0 <= issue_long_i and issue_rstb_i;
+      r_long1 <= r_long0;
+      r_late  <= r_conf1 and r_long1;
+      r_conf2 <= (r_conf1 and not r_long1) or r_late;
+    end if;
+  end process;
+  issue_retry_o <= r_conf2;
+  
   -- !!! the strobe line is a real bummer. much nicer would be if we had a 'bad' reg
   -- we would be able to compress 6:1 reg match, 5:1 EU decode w/ aged as +1
   -- result: 2 levels to compute s_map, in line with 2-levels for 18-stat bak[ab]
@@ -340,11 +387,14 @@ begin
     end if;
   end process;
   
+  s_mux_idx_a <= f_opa_compose(r_map, issue_baka_i) or not f_opa_dup_col(c_mux_wide, issue_geta_i);
+  s_mux_idx_b <= f_opa_compose(r_map, issue_bakb_i) or not f_opa_dup_col(c_mux_wide, issue_getb_i);
+  
   mux_idx : process(clk_i) is
   begin
     if rising_edge(clk_i) then
-      r_mux_idx_a <= f_opa_compose(r_map, issue_baka_i) or not f_opa_dup_col(c_mux_wide, issue_geta_i);
-      r_mux_idx_b <= f_opa_compose(r_map, issue_bakb_i) or not f_opa_dup_col(c_mux_wide, issue_getb_i);
+      r_mux_idx_a <= s_mux_idx_a;
+      r_mux_idx_b <= s_mux_idx_b;
     end if;
   end process;
   
@@ -446,41 +496,195 @@ begin
     s_w_data(u)  <= f_opa_select_row(eu_regx_i, u);
   end generate;
 
-  ramsw : for w in 0 to c_executers-1 generate
-    ramsr : for r in 0 to c_executers-1 generate
-      rama : opa_dpram
-        generic map(
-          g_width  => c_reg_wide,
-          g_size   => c_num_back,
-          g_equal  => OPA_UNDEF,
-          g_regin  => true,
-          g_regout => false)
-        port map(
-          clk_i    => clk_i,
-          rst_n_i  => rst_n_i,
-          r_addr_i => s_ra_addr(r),
-          r_data_o => s_ra_data(f_idx(r, w)),
-          w_en_i   => r_wstb1(w),
-          w_addr_i => s_w_addr(w),
-          w_data_i => s_w_data(w));
-      ramb : opa_dpram
-        generic map(
-          g_width  => c_reg_wide,
-          g_size   => c_num_back,
-          g_equal  => OPA_UNDEF,
-          g_regin  => true,
-          g_regout => false)
-        port map(
-          clk_i    => clk_i,
-          rst_n_i  => rst_n_i,
-          r_addr_i => s_rb_addr(r),
-          r_data_o => s_rb_data(f_idx(r, w)),
-          w_en_i   => r_wstb1(w),
-          w_addr_i => s_w_addr(w),
-          w_data_i => s_w_data(w));
+  -- Every EU gets a private copy of every EU's results: 2*executers^2 memory blocks
+  full : if g_config.rf_banks = 0 generate
+    s_conf <= (others => '0');
+    ramsw : for w in 0 to c_executers-1 generate
+      ramsr : for r in 0 to c_executers-1 generate
+        rama : opa_dpram
+          generic map(
+            g_width  => c_reg_wide,
+            g_size   => c_num_back,
+            g_equal  => OPA_UNDEF,
+            g_regin  => true,
+            g_regout => false)
+          port map(
+            clk_i    => clk_i,
+            rst_n_i  => rst_n_i,
+            r_addr_i => s_ra_addr(r),
+            r_data_o => s_ra_data(f_idx(r, w)),
+            w_en_i   => r_wstb1(w),
+            w_addr_i => s_w_addr(w),
+            w_data_i => s_w_data(w));
+        ramb : opa_dpram
+          generic map(
+            g_width  => c_reg_wide,
+            g_size   => c_num_back,
+            g_equal  => OPA_UNDEF,
+            g_regin  => true,
+            g_regout => false)
+          port map(
+            clk_i    => clk_i,
+            rst_n_i  => rst_n_i,
+            r_addr_i => s_rb_addr(r),
+            r_data_o => s_rb_data(f_idx(r, w)),
+            w_en_i   => r_wstb1(w),
+            w_addr_i => s_w_addr(w),
+            w_data_i => s_w_data(w));
+      end generate;
     end generate;
   end generate;
-  
+
+  -- Split the reads of each operand into banks, selected by backing register.
+  -- Each bank keeps a block per EU, holding only its registers: 2*rf_banks*executers
+  -- memory blocks. Only reads which the mux takes from a block use a bank; bypassed
+  -- operands and immediates are free. The oldest instruction reading a bank (lowest
+  -- station, which issue reports with the schedule) picks the register; an EU which
+  -- wants a different register of the same bank is not run and issue retries it.
+  -- The oldest instruction in flight therefore never loses a bank.
+  banked : if g_config.rf_banks > 0 generate
+    constant c_banks      : natural := g_config.rf_banks;
+    constant c_bank_wide  : natural := f_opa_log2(c_banks);
+    constant c_ports      : natural := 2*c_executers; -- operand a of EU u is port u, b is u+executers
+    constant c_stat_wide  : natural := f_opa_stat_wide(g_config);
+
+    type t_port_addr is array(natural range <>) of std_logic_vector(c_back_wide-1 downto 0);
+    type t_bank_data is array(natural range <>) of std_logic_vector(c_reg_wide-1 downto 0);
+
+    function f_bank(x : std_logic_vector) return natural is
+    begin
+      if f_opa_safe(x) = '1' then
+        return to_integer(unsigned(x)) mod c_banks;
+      else
+        return 0;
+      end if;
+    end f_bank;
+
+    function f_bidx(o, k, w : natural) return natural is
+    begin
+      return (o*c_banks + k)*c_executers + w;
+    end f_bidx;
+
+    signal s_want : std_logic_vector(c_ports-1 downto 0);
+    signal s_addr : t_port_addr(c_ports-1 downto 0);
+    signal s_lose : std_logic_vector(c_ports-1 downto 0);
+    signal s_sel  : t_opa_matrix(c_ports-1 downto 0, c_banks-1 downto 0);
+    signal r_sel  : t_opa_matrix(c_ports-1 downto 0, c_banks-1 downto 0);
+    signal s_bidx : t_port_addr(2*c_banks-1 downto 0);
+    signal s_data : t_bank_data(2*c_banks*c_executers-1 downto 0);
+  begin
+    ports : for u in 0 to c_executers-1 generate
+      s_want(u)             <= issue_rstb_i(u) and f_opa_index(c_mem_mask, unsigned(f_opa_select_row(s_mux_idx_a, u)));
+      s_want(u+c_executers) <= issue_rstb_i(u) and f_opa_index(c_mem_mask, unsigned(f_opa_select_row(s_mux_idx_b, u)));
+      s_addr(u)             <= s_ra_addr(u);
+      s_addr(u+c_executers) <= s_rb_addr(u);
+      s_conf(u) <= s_lose(u) or s_lose(u+c_executers);
+    end generate;
+
+    arbitrate : process(s_want, s_addr, issue_stat_i) is
+      variable v_bidx  : t_port_addr(2*c_banks-1 downto 0);
+      variable v_taken : std_logic;
+      variable v_age   : unsigned(c_stat_wide-1 downto 0);
+      variable v_stat  : unsigned(c_stat_wide-1 downto 0);
+      variable v_sel   : t_opa_matrix(c_ports-1 downto 0, c_banks-1 downto 0);
+      variable v_lose  : std_logic_vector(c_ports-1 downto 0);
+      variable v_p     : natural;
+      variable v_b     : natural;
+    begin
+      v_bidx  := (others => (others => '0'));
+      v_sel   := (others => (others => '0'));
+      v_lose  := (others => '0');
+      for o in 0 to 1 loop
+        for k in 0 to c_banks-1 loop
+          v_b     := o*c_banks + k;
+          v_taken := '0';
+          v_age   := (others => '1');
+          -- Find the oldest reader of this bank
+          for u in 0 to c_executers-1 loop
+            v_p    := o*c_executers + u;
+            v_stat := unsigned(f_opa_select_row(issue_stat_i, u));
+            if s_want(v_p) = '1' and f_bank(s_addr(v_p)) = k then
+              if v_taken = '0' or v_stat < v_age then
+                v_bidx(v_b) := s_addr(v_p);
+                v_taken     := '1';
+                v_age       := v_stat;
+              end if;
+            end if;
+          end loop;
+          -- Everyone who wants that same register shares the read
+          for u in 0 to c_executers-1 loop
+            v_p := o*c_executers + u;
+            if s_want(v_p) = '1' and f_bank(s_addr(v_p)) = k then
+              if f_opa_eq(v_bidx(v_b), s_addr(v_p)) = '1' then
+                v_sel(v_p,k) := '1';
+              else
+                v_lose(v_p)  := '1';
+              end if;
+            end if;
+          end loop;
+        end loop;
+      end loop;
+      s_bidx <= v_bidx;
+      s_sel  <= v_sel;
+      s_lose <= v_lose;
+    end process;
+
+    operands : for o in 0 to 1 generate
+      banks : for k in 0 to c_banks-1 generate
+        signal s_bwe : std_logic_vector(c_executers-1 downto 0);
+      begin
+        writers : for w in 0 to c_executers-1 generate
+          s_bwe(w) <= r_wstb1(w) and f_opa_bit(f_bank(s_w_addr(w)) = k);
+          ram : opa_dpram
+            generic map(
+              g_width  => c_reg_wide,
+              g_size   => 2**(c_back_wide-c_bank_wide),
+              g_equal  => OPA_UNDEF,
+              g_regin  => true,
+              g_regout => false)
+            port map(
+              clk_i    => clk_i,
+              rst_n_i  => rst_n_i,
+              r_addr_i => s_bidx(o*c_banks+k)(c_back_wide-1 downto c_bank_wide),
+              r_data_o => s_data(f_bidx(o, k, w)),
+              w_en_i   => s_bwe(w),
+              w_addr_i => s_w_addr(w)(c_back_wide-1 downto c_bank_wide),
+              w_data_i => s_w_data(w));
+        end generate;
+      end generate;
+    end generate;
+
+    main : process(clk_i) is
+    begin
+      if rising_edge(clk_i) then
+        r_sel <= s_sel;
+      end if;
+    end process;
+
+    -- Hand each EU the output of the bank it was granted
+    route : process(r_sel, s_data) is
+      variable v_a : std_logic_vector(c_reg_wide-1 downto 0);
+      variable v_b : std_logic_vector(c_reg_wide-1 downto 0);
+    begin
+      for u in 0 to c_executers-1 loop
+        for w in 0 to c_executers-1 loop
+          v_a := (others => '0');
+          v_b := (others => '0');
+          for k in 0 to c_banks-1 loop
+            if r_sel(u,k) = '1' then
+              v_a := v_a or s_data(f_bidx(0, k, w));
+            end if;
+            if r_sel(u+c_executers,k) = '1' then
+              v_b := v_b or s_data(f_bidx(1, k, w));
+            end if;
+          end loop;
+          s_ra_data(f_idx(u, w)) <= v_a;
+          s_rb_data(f_idx(u, w)) <= v_b;
+        end loop;
+      end loop;
+    end process;
+  end generate;
+
   -- Create the mux and demux it
   bypass : for u in 0 to c_executers-1 generate
     bits : for b in 0 to c_reg_wide-1 generate
@@ -497,10 +701,16 @@ begin
         s_mux_b(f_idx(u,b))(f_reg(v+1)-1 downto f_reg(v)) <= (others => r_regx(v,b));
       end generate;
       
-      -- Select from other EUs
+      -- Select from other EUs; issue never bypasses across fast clusters
       eu : for v in 0 to c_executers-1 generate
-        s_mux_a(f_idx(u,b))(f_eu(v+1)-1 downto f_eu(v)) <= (others => eu_regx_i(v,b));
-        s_mux_b(f_idx(u,b))(f_eu(v+1)-1 downto f_eu(v)) <= (others => eu_regx_i(v,b));
+        near : if f_opa_bypass(g_config, u, v) generate
+          s_mux_a(f_idx(u,b))(f_eu(v+1)-1 downto f_eu(v)) <= (others => eu_regx_i(v,b));
+          s_mux_b(f_idx(u,b))(f_eu(v+1)-1 downto f_eu(v)) <= (others => eu_regx_i(v,b));
+        end generate;
+        far : if not f_opa_bypass(g_config, u, v) generate
+          s_mux_a(f_idx(u,b))(f_eu(v+1)-1 downto f_eu(v)) <= (others => '-');
+          s_mux_b(f_idx(u,b))(f_eu(v+1)-1 downto f_eu(v)) <= (others => '-');
+        end generate;
       end generate;
       
       -- Select from PC+immediate, preventing synthesis from rearranging higher muxes
@@ -513,7 +723,7 @@ begin
     end generate;
   end generate;
   
-  eu_stb_o  <= r_rstb0;
+  eu_stb_o  <= r_rstb0 and not r_conf0;
   eu_rega_o <= f_opa_mux(r_rstb0, s_rega, c_undef_reg);
   eu_regb_o <= f_opa_mux(r_rstb0, s_regb, c_undef_reg);
   eu_arg_o  <= f_opa_mux(r_rstb0, s_arg,  c_undef_arg);
@@ -50,20 +50,26 @@ entity opa_rename is
     decode_fast_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     decode_slow_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     decode_order_i : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    decode_safe_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    decode_long_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     decode_setx_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    decode_move_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0); -- result is rega
     decode_geta_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     decode_getb_i  : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     decode_aux_i   : in  std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
-    decode_archx_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
-    decode_archa_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
-    decode_archb_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa)-1 downto 0);
+    decode_archx_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
+    decode_archa_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
+    decode_archb_i : in  t_opa_matrix(f_opa_renamers(g_config)-1 downto 0, f_opa_arch_wide(g_isa,g_config)-1 downto 0);
     
     -- Values we provide to the issuer
     issue_stb_o    : out std_logic;
     issue_stall_i  : in  std_logic;
+    issue_drain_i  : in  std_logic; -- progress without decode; the group holds no ops
     issue_fast_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     issue_slow_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     issue_order_o  : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    issue_safe_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
+    issue_long_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     issue_geta_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     issue_getb_o   : out std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     issue_aux_o    : out std_logic_vector(f_opa_aux_wide(g_config)-1 downto 0);
@@ -76,6 +82,8 @@ entity opa_rename is
     
     -- Feed faults back up the pipeline
     issue_fault_i  : in  std_logic;
+    issue_resume_i : in  std_logic; -- fault lands where an earlier redirect already sent fetch
+    issue_redir_i  : in  std_logic; -- restart fetch early; the window is not flushed
     issue_mask_i   : in  std_logic_vector(f_opa_renamers(g_config)-1 downto 0);
     issue_pc_i     : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     issue_pcf_i    : in  std_logic_vector(f_opa_fet_wide(g_config)-1 downto 0);
@@ -88,11 +96,11 @@ end opa_rename;
 
 architecture rtl of opa_rename is
 
-  constant c_num_arch  : natural := f_opa_num_arch(g_isa);
+  constant c_num_arch  : natural := f_opa_num_arch(g_isa,g_config);
   constant c_num_stat  : natural := f_opa_num_stat(g_config);
   constant c_num_back  : natural := f_opa_num_back(g_isa,g_config);
   constant c_renamers  : natural := f_opa_renamers(g_config);
-  constant c_arch_wide : natural := f_opa_arch_wide(g_isa);
+  constant c_arch_wide : natural := f_opa_arch_wide(g_isa,g_config);
   constant c_back_wide : natural := f_opa_back_wide(g_isa,g_config);
   constant c_stat_wide : natural := f_opa_stat_wide(g_config);
   constant c_data_wide : natural := (c_arch_wide + c_back_wide) * c_renamers;
@@ -134,10 +142,12 @@ architecture rtl of opa_rename is
   constant c_stat_labels     : t_opa_matrix := f_fill_top_row(c_pre_stat_labels);
   
   constant c_arch_init : t_opa_matrix := f_opa_labels(c_num_arch, c_back_wide, 0);
+  constant c_root_init : t_opa_matrix := f_opa_labels(c_num_arch, c_arch_wide, 0);
   constant c_free_init : t_opa_matrix := f_opa_labels(c_renamers, c_back_wide, c_num_arch+c_num_stat);
 
   signal r_pre_stat    : t_opa_matrix(c_num_arch-1 downto 0, c_stat_wide-1 downto 0) := (others => (others => '1'));
   signal r_pre_bak     : t_opa_matrix(c_num_arch-1 downto 0, c_back_wide-1 downto 0) := c_arch_init;
+  signal r_pre_root    : t_opa_matrix(c_num_arch-1 downto 0, c_arch_wide-1 downto 0) := c_root_init;
   signal r_com_bak     : t_opa_matrix(c_num_arch-1 downto 0, c_back_wide-1 downto 0) := c_arch_init;
   signal r_free_bak    : t_opa_matrix(c_renamers-1 downto 0, c_back_wide-1 downto 0) := c_free_init;
   signal r_q_setx      : std_logic_vector(c_num_stat-1 downto 0)                     := (others => '0');
@@ -151,6 +161,7 @@ architecture rtl of opa_rename is
   signal s_pre_new_bak : t_opa_matrix(c_num_arch-1 downto 0, c_back_wide-1 downto 0);
   signal s_pre_mux_stat: t_opa_matrix(c_num_arch-1 downto 0, c_stat_wide-1 downto 0);
   signal s_pre_mux_bak : t_opa_matrix(c_num_arch-1 downto 0, c_back_wide-1 downto 0);
+  signal s_pre_mux_root: t_opa_matrix(c_num_arch-1 downto 0, c_arch_wide-1 downto 0);
   
   signal s_com_setx    : std_logic_vector(c_renamers-1 downto 0);
   signal s_com_archx   : t_opa_matrix(c_renamers-1 downto 0, c_arch_wide-1 downto 0);       
@@ -166,10 +177,14 @@ architecture rtl of opa_rename is
   signal s_free_bak    : t_opa_matrix(c_renamers-1 downto 0, c_back_wide-1 downto 0);
 
   signal s_progress    : std_logic;
+  signal s_setx        : std_logic_vector(c_renamers-1 downto 0);
+  signal s_move        : std_logic_vector(c_renamers-1 downto 0);
   
   signal s_not_get_a   : t_opa_matrix(c_renamers-1 downto 0, c_renamers-1  downto 0) := (others => (others => '0'));
   signal s_not_get_b   : t_opa_matrix(c_renamers-1 downto 0, c_renamers-1  downto 0) := (others => (others => '0'));
   
+  signal s_effa        : t_opa_matrix(c_renamers-1 downto 0, c_arch_wide-1 downto 0);
+  signal s_effb        : t_opa_matrix(c_renamers-1 downto 0, c_arch_wide-1 downto 0);
   signal s_old_baka    : t_opa_matrix(c_renamers-1 downto 0, c_back_wide-1 downto 0);
   signal s_old_bakb    : t_opa_matrix(c_renamers-1 downto 0, c_back_wide-1 downto 0);
   signal s_old_stata   : t_opa_matrix(c_renamers-1 downto 0, c_stat_wide-1 downto 0);
@@ -197,6 +212,7 @@ begin
       assert (f_opa_safe(decode_stb_i)  = '1') report "rename: decode_stb_i has metavalue" severity failure;
       assert (f_opa_safe(issue_stall_i) = '1') report "rename: issue_stall_i has metavalue" severity failure;
       assert (f_opa_safe(issue_fault_i) = '1') report "rename: issue_fault_i has metavalue" severity failure;
+      assert (f_opa_safe(issue_drain_i) = '1') report "rename: issue_drain_i has metavalue" severity failure;
       assert (f_opa_safe(s_progress)    = '1') report "rename: s_progress has metavalue" severity failure;
     end if;
   end process;
@@ -205,6 +221,7 @@ begin
     variable v_pre : std_logic_vector(c_num_back-1 downto 0);
     variable v_com : std_logic_vector(c_num_back-1 downto 0);
     variable v_bak : unsigned(c_back_wide-1 downto 0);
+    variable v_root: unsigned(c_arch_wide-1 downto 0);
     variable v_idx : integer;
   begin
     if rising_edge(clk_i) then
@@ -227,6 +244,16 @@ begin
         v_com(v_idx) := '1';
       end loop;
       
+      -- Roots are never aliases themselves
+      for i in 0 to c_num_arch-1 loop
+        v_root := unsigned(f_opa_select_row(r_pre_root, i));
+        assert (f_opa_safe(v_root) = '1') report "rename: r_pre_root has a metavalue" severity failure;
+        v_idx := to_integer(v_root);
+        assert (v_idx < c_num_arch) report "rename: r_pre_root contains an invalid register" severity failure;
+        assert (f_opa_eq(unsigned(f_opa_select_row(r_pre_root, v_idx)), v_root) = '1')
+        report "rename: r_pre_root aliases an alias" severity failure;
+      end loop;
+      
       for i in 0 to c_renamers-1 loop
         v_bak := unsigned(f_opa_select_row(r_free_bak, i));
         assert (f_opa_safe(v_bak) = '1') report "rename: r_free_bak has a metavalue" severity failure;
@@ -239,7 +266,7 @@ begin
   end process;
 
   -- Compute the new architectural state, predicting these operations run
-  s_pre_writers <= f_opa_match_index(c_num_arch, decode_archx_i) and f_opa_dup_row(c_num_arch, decode_setx_i);
+  s_pre_writers <= f_opa_match_index(c_num_arch, decode_archx_i) and f_opa_dup_row(c_num_arch, s_setx);
   s_pre_mux     <= f_opa_product(s_pre_writers, c_decode_ones);
   s_pre_source  <= f_opa_pick_big(s_pre_writers);
   s_pre_dec_stat<= f_opa_decrement(r_pre_stat, c_renamers);
@@ -248,6 +275,48 @@ begin
   s_pre_mux_stat<= f_opa_mux(s_pre_mux, s_pre_new_stat, s_pre_dec_stat);
   s_pre_mux_bak <= f_opa_mux(s_pre_mux, s_pre_new_bak,  r_pre_bak);
   
+  -- Move elimination. Every op still gets its station and backing register, so the
+  -- committed map and the free list are untouched, and a move still runs to fill its
+  -- register. But readers renamed after a move are pointed at the move's source (its
+  -- root), so they no longer wait for the move. r_pre_root(a) names the architectural
+  -- register whose backing register holds a's value; normally a itself.
+  --
+  -- The source's backing register is freed when the next write to the root commits.
+  -- So once the root is renamed again, its aliases fall back to their own registers.
+  -- A reader never looks through a root written in its own group; it might be older.
+  -- Roots are never aliases themselves, so chains of moves collapse to one step.
+  elim : if g_config.mv_elim generate
+    roots : block is
+      signal s_pre_kill     : std_logic_vector(c_num_arch-1 downto 0);
+      signal s_pre_new_root : t_opa_matrix(c_num_arch-1 downto 0, c_arch_wide-1 downto 0);
+      signal s_pre_old_root : t_opa_matrix(c_num_arch-1 downto 0, c_arch_wide-1 downto 0);
+      signal s_roota        : t_opa_matrix(c_renamers-1 downto 0, c_arch_wide-1 downto 0);
+      signal s_rootb        : t_opa_matrix(c_renamers-1 downto 0, c_arch_wide-1 downto 0);
+      signal s_move_ok      : std_logic_vector(c_renamers-1 downto 0);
+      signal s_move_arch    : t_opa_matrix(c_renamers-1 downto 0, c_arch_wide-1 downto 0);
+    begin
+      s_roota <= f_opa_compose(r_pre_root, decode_archa_i);
+      s_rootb <= f_opa_compose(r_pre_root, decode_archb_i);
+      s_effa  <= f_opa_mux(f_opa_compose(s_pre_mux, s_roota), decode_archa_i, s_roota);
+      s_effb  <= f_opa_mux(f_opa_compose(s_pre_mux, s_rootb), decode_archb_i, s_rootb);
+      
+      -- A move whose source was not written earlier in its group aliases that root
+      s_move_ok   <= s_move and not s_mux_a and not f_opa_compose(s_pre_mux, s_roota);
+      s_move_arch <= f_opa_mux(s_move_ok, s_roota, decode_archx_i);
+      
+      s_pre_kill     <= f_opa_compose(s_pre_mux, r_pre_root);
+      s_pre_new_root <= f_opa_product(s_pre_source, s_move_arch);
+      s_pre_old_root <= f_opa_mux(s_pre_kill, c_root_init, r_pre_root);
+      s_pre_mux_root <= f_opa_mux(s_pre_mux, s_pre_new_root, s_pre_old_root);
+    end block;
+  end generate;
+  
+  noelim : if not g_config.mv_elim generate
+    s_pre_mux_root <= c_root_init;
+    s_effa <= decode_archa_i;
+    s_effb <= decode_archb_i;
+  end generate;
+  
   s_com_setx <= r_q_setx(c_renamers-1 downto 0) and issue_mask_i;
   archx : for i in 0 to c_renamers-1 generate
     bits : for b in 0 to c_arch_wide-1 generate
@@ -268,13 +337,20 @@ begin
   s_useless    <= f_opa_product(s_overwrites, s_com_setx) or not s_com_setx;
   s_free_bak   <= f_opa_mux(s_useless, issue_bakx_i, s_old_bakx);
   
-  s_progress <= (decode_stb_i and not issue_stall_i) or issue_fault_i;
+  -- While an early redirect is outstanding, issue drains the window by itself.
+  -- The group inserted on a drain holds no ops, so it must not touch the maps.
+  s_progress <= (decode_stb_i and not issue_stall_i) or issue_fault_i or issue_drain_i;
+  drain : for i in 0 to c_renamers-1 generate
+    s_setx(i) <= decode_setx_i(i) and not issue_drain_i;
+    s_move(i) <= decode_move_i(i) and not issue_drain_i;
+  end generate;
   main : process(rst_n_i, clk_i) is
     variable value : std_logic_vector(r_pre_bak'range(2));
   begin
     if rst_n_i = '0' then
       r_pre_stat <= (others => (others => '1'));
       r_pre_bak  <= c_arch_init;
+      r_pre_root <= c_root_init;
       r_com_bak  <= c_arch_init;
       r_free_bak <= c_free_init;
       r_q_setx   <= (others => '0');
@@ -283,10 +359,12 @@ begin
         if issue_fault_i = '1' then -- load enable
           r_q_setx     <= (others => '0');
           r_pre_bak    <= s_com_mux_bak;
+          r_pre_root   <= c_root_init;
           r_pre_stat   <= (others => (others => '1'));
         else
-          r_q_setx     <= decode_setx_i & r_q_setx(c_num_stat-1 downto c_renamers);
+          r_q_setx     <= s_setx & r_q_setx(c_num_stat-1 downto c_renamers);
           r_pre_bak    <= s_pre_mux_bak;
+          r_pre_root   <= s_pre_mux_root;
           r_pre_stat   <= s_pre_mux_stat;
         end if;
         r_com_bak    <= s_com_mux_bak;
@@ -319,10 +397,10 @@ begin
   end generate;
   
   -- Rename the inputs, watching out for same-cycle dependencies
-  s_old_baka <= f_opa_compose(r_pre_bak, decode_archa_i);
-  s_old_bakb <= f_opa_compose(r_pre_bak, decode_archb_i);
-  s_old_stata<= f_opa_compose(r_pre_stat,decode_archa_i);
-  s_old_statb<= f_opa_compose(r_pre_stat,decode_archb_i);
+  s_old_baka <= f_opa_compose(r_pre_bak, s_effa);
+  s_old_bakb <= f_opa_compose(r_pre_bak, s_effb);
+  s_old_stata<= f_opa_compose(r_pre_stat,s_effa);
+  s_old_statb<= f_opa_compose(r_pre_stat,s_effb);
   s_match_a  <= (f_opa_match(decode_archa_i, decode_archx_i) and f_opa_dup_row(c_renamers, decode_setx_i) and c_UR_triangle) or s_not_get_a;
   s_match_b  <= (f_opa_match(decode_archb_i, decode_archx_i) and f_opa_dup_row(c_renamers, decode_setx_i) and c_UR_triangle) or s_not_get_b;
   s_mux_a    <= f_opa_product(s_match_a, c_decode_ones);
@@ -344,6 +422,8 @@ begin
   issue_fast_o   <= decode_fast_i;
   issue_slow_o   <= decode_slow_i;
   issue_order_o  <= decode_order_i;
+  issue_safe_o   <= decode_safe_i;
+  issue_long_o   <= decode_long_i;
   issue_geta_o   <= decode_geta_i;
   issue_getb_o   <= decode_getb_i;
   issue_aux_o    <= decode_aux_i;
@@ -353,7 +433,7 @@ begin
   issue_stata_o  <= s_stata;
   issue_statb_o  <= s_statb;
   
-  decode_fault_o <= issue_fault_i;
+  decode_fault_o <= (issue_fault_i and not issue_resume_i) or issue_redir_i;
   decode_pc_o    <= issue_pc_i;
   decode_pcf_o   <= issue_pcf_i;
   decode_pcn_o   <= issue_pcn_i;
@@ -39,18 +39,21 @@ package opa_riscv_pkg is
   constant c_opa_rv32 : t_opa_isa_info := (
     big_endian => false,
     num_arch   => 32,
+    num_fp     => 32,
     imm_wide   => 32,
     op_wide    => 32,
     page_size  => 4096);
 
   function f_opa_accept_rv32(config : t_opa_config) return std_logic;
   function f_opa_decode_rv32(config : t_opa_config; x : std_logic_vector) return t_opa_op;
+  function f_opa_fuse_rv32  (config : t_opa_config; x, y : std_logic_vector) return t_opa_op;
 
 end package;
 
 package body opa_riscv_pkg is
 
   constant c_arch_wide : natural := f_opa_log2(c_opa_rv32.num_arch);
+  -- With ieee_fp, architectural register c_arch_wide selects f0-f31 over x0-x31
   
   function f_zero(x : std_logic_vector) return std_logic is
   begin
@@ -65,12 +68,12 @@ package body opa_riscv_pkg is
   function f_parse_rtype (x : std_logic_vector) return t_opa_op is
     variable result : t_opa_op := c_opa_op_undef;
   begin
-    result.archb(c_arch_wide-1 downto 0) := x(24 downto 20);
-    result.archa(c_arch_wide-1 downto 0) := x(19 downto 15);
-    result.archx(c_arch_wide-1 downto 0) := x(11 downto  7);
+    result.archb(c_arch_wide downto 0) := '0' & x(24 downto 20);
+    result.archa(c_arch_wide downto 0) := '0' & x(19 downto 15);
+    result.archx(c_arch_wide downto 0) := '0' & x(11 downto  7);
     result.geta  := '1'; -- use both input registers
     result.getb  := '1';
-    result.setx  := not f_zero(x);
+    result.setx  := not f_zero(result.archx);
     result.bad   := '0';
     result.jump  := '0';
     result.take  := '0';
@@ -82,8 +85,8 @@ package body opa_riscv_pkg is
   function f_parse_itype (x : std_logic_vector) return t_opa_op is
     variable result : t_opa_op := c_opa_op_undef;
   begin
-    result.archa(c_arch_wide-1 downto 0) := x(19 downto 15);
-    result.archx(c_arch_wide-1 downto 0) := x(11 downto  7);
+    result.archa(c_arch_wide downto 0) := '0' & x(19 downto 15);
+    result.archx(c_arch_wide downto 0) := '0' & x(11 downto  7);
     result.getb  := '0'; -- immediate
     result.geta  := '1';
     result.setx  := not f_zero(result.archx);
@@ -100,8 +103,8 @@ package body opa_riscv_pkg is
   function f_parse_stype (x : std_logic_vector) return t_opa_op is
     variable result : t_opa_op := c_opa_op_undef;
   begin
-    result.archb(c_arch_wide-1 downto 0) := x(24 downto 20);
-    result.archa(c_arch_wide-1 downto 0) := x(19 downto 15);
+    result.archb(c_arch_wide downto 0) := '0' & x(24 downto 20);
+    result.archa(c_arch_wide downto 0) := '0' & x(19 downto 15);
     result.getb  := '1';
     result.geta  := '1';
     result.setx  := '0';
@@ -119,7 +122,7 @@ package body opa_riscv_pkg is
   function f_parse_utype (x : std_logic_vector) return t_opa_op is
     variable result : t_opa_op := c_opa_op_undef;
   begin
-    result.archx(c_arch_wide-1 downto 0) := x(11 downto  7);
+    result.archx(c_arch_wide downto 0) := '0' & x(11 downto  7);
     result.geta  := '0';
     result.getb  := '0';
     result.setx  := not f_zero(result.archx);
@@ -136,8 +139,8 @@ package body opa_riscv_pkg is
   function f_parse_sbtype(x : std_logic_vector) return t_opa_op is
     variable result : t_opa_op := c_opa_op_undef;
   begin
-    result.archb(c_arch_wide-1 downto 0) := x(24 downto 20);
-    result.archa(c_arch_wide-1 downto 0) := x(19 downto 15);
+    result.archb(c_arch_wide downto 0) := '0' & x(24 downto 20);
+    result.archa(c_arch_wide downto 0) := '0' & x(19 downto 15);
     result.getb  := '1';
     result.geta  := '1';
     result.setx  := '0';
@@ -161,7 +164,7 @@ package body opa_riscv_pkg is
   function f_decode_jal  (x : std_logic_vector) return t_opa_op is
     variable op : t_opa_op := c_opa_op_undef;
   begin
-    op.archx(c_arch_wide-1 downto 0)    := x(11 downto  7);
+    op.archx(c_arch_wide downto 0)    := '0' & x(11 downto  7);
     op.getb     := '0'; -- imm
     op.geta     := '0'; -- PC
     op.setx     := not f_zero(op.archx);
@@ -184,7 +187,7 @@ package body opa_riscv_pkg is
     op.arg.adder.nota  := '0';
     op.arg.adder.notb  := '0';
     op.arg.adder.cin   := '0';
-    op.arg.adder.sign  := '-';
+    op.arg.adder.sign  := '0'; -- plain link
     op.arg.adder.fault := '-';
     op.arg.fmode       := c_opa_fast_jump;
     op.fast            := '1';
@@ -207,7 +210,7 @@ package body opa_riscv_pkg is
     op.arg.adder.nota  := '0';
     op.arg.adder.notb  := '0';
     op.arg.adder.cin   := '0';
-    op.arg.adder.sign  := '-';
+    op.arg.adder.sign  := '0'; -- plain link
     op.arg.adder.fault := '-';
     op.arg.fmode       := c_opa_fast_jump;
     op.fast            := '1';
@@ -327,6 +330,7 @@ package body opa_riscv_pkg is
     op.arg.ldst.store := '0';
     op.arg.ldst.sext  := '1';
     op.arg.ldst.size  := c_opa_ldst_byte;
+    op.arg.ldst.pref  := not op.setx; -- load to x0
     op.arg.smode      := c_opa_slow_ldst;
     op.fast           := '0';
     return op;
@@ -338,6 +342,7 @@ package body opa_riscv_pkg is
     op.arg.ldst.store := '0';
     op.arg.ldst.sext  := '1';
     op.arg.ldst.size  := c_opa_ldst_half;
+    op.arg.ldst.pref  := not op.setx; -- load to x0
     op.arg.smode      := c_opa_slow_ldst;
     op.fast           := '0';
     return op;
@@ -349,6 +354,7 @@ package body opa_riscv_pkg is
     op.arg.ldst.store := '0';
     op.arg.ldst.sext  := '1';
     op.arg.ldst.size  := c_opa_ldst_word;
+    op.arg.ldst.pref  := not op.setx; -- load to x0
     op.arg.smode      := c_opa_slow_ldst;
     op.fast           := '0';
     return op;
@@ -360,6 +366,7 @@ package body opa_riscv_pkg is
     op.arg.ldst.store := '0';
     op.arg.ldst.sext  := '0';
     op.arg.ldst.size  := c_opa_ldst_byte;
+    op.arg.ldst.pref  := not op.setx; -- load to x0
     op.arg.smode      := c_opa_slow_ldst;
     op.fast           := '0';
     return op;
@@ -371,6 +378,7 @@ package body opa_riscv_pkg is
     op.arg.ldst.store := '0';
     op.arg.ldst.sext  := '0';
     op.arg.ldst.size  := c_opa_ldst_half;
+    op.arg.ldst.pref  := not op.setx; -- load to x0
     op.arg.smode      := c_opa_slow_ldst;
     op.fast           := '0';
     return op;
@@ -382,6 +390,7 @@ package body opa_riscv_pkg is
     op.arg.ldst.store := '1';
     op.arg.ldst.sext  := '-';
     op.arg.ldst.size  := c_opa_ldst_byte;
+    op.arg.ldst.pref  := '0';
     op.arg.smode      := c_opa_slow_ldst;
     op.fast           := '0';
     return op;
@@ -393,6 +402,7 @@ package body opa_riscv_pkg is
     op.arg.ldst.store := '1';
     op.arg.ldst.sext  := '-';
     op.arg.ldst.size  := c_opa_ldst_half;
+    op.arg.ldst.pref  := '0';
     op.arg.smode      := c_opa_slow_ldst;
     op.fast           := '0';
     return op;
@@ -404,6 +414,7 @@ package body opa_riscv_pkg is
     op.arg.ldst.store := '1';
     op.arg.ldst.sext  := '-';
     op.arg.ldst.size  := c_opa_ldst_word;
+    op.arg.ldst.pref  := '0';
     op.arg.smode      := c_opa_slow_ldst;
     op.fast           := '0';
     return op;
@@ -672,7 +683,7 @@ package body opa_riscv_pkg is
   function f_decode_div  (x : std_logic_vector) return t_opa_op is
     variable op : t_opa_op := f_parse_rtype(x);
   begin
-    op.arg.mul.sexta  := '-';
+    op.arg.mul.sexta  := '1';
     op.arg.mul.sextb  := '1';
     op.arg.mul.high   := '0';
     op.arg.mul.divide := '1';
@@ -684,7 +695,7 @@ package body opa_riscv_pkg is
   function f_decode_divu (x : std_logic_vector) return t_opa_op is
     variable op : t_opa_op := f_parse_rtype(x);
   begin
-    op.arg.mul.sexta  := '-';
+    op.arg.mul.sexta  := '0';
     op.arg.mul.sextb  := '0';
     op.arg.mul.high   := '0';
     op.arg.mul.divide := '1';
@@ -717,6 +728,109 @@ package body opa_riscv_pkg is
     return op;
   end f_decode_remu;
   
+  -- Single precision (RV32F) minus FMADD & co, which would need a third operand,
+  -- and FDIV/FSQRT. There is no fcsr: dynamic rounding rounds to nearest even
+  -- and fflags are never recorded, so no preset enables ieee_fp yet.
+  function f_decode_flw  (x : std_logic_vector) return t_opa_op is
+    variable op : t_opa_op := f_decode_lw(x);
+  begin
+    op.archx(c_arch_wide) := '1';
+    op.setx               := '1';
+    op.arg.ldst.pref      := '0';
+    return op;
+  end f_decode_flw;
+  
+  function f_decode_fsw  (x : std_logic_vector) return t_opa_op is
+    variable op : t_opa_op := f_decode_sw(x);
+  begin
+    op.archb(c_arch_wide) := '1';
+    return op;
+  end f_decode_fsw;
+  
+  -- FMV.X.W, FMV.W.X and FMV.S just copy the bits, so rename may eliminate them
+  function f_decode_fmv  (x : std_logic_vector; fx, fa : std_logic) return t_opa_op is
+    variable op : t_opa_op := f_decode_addi(x);
+  begin
+    op.archx(c_arch_wide) := fx;
+    op.archa(c_arch_wide) := fa;
+    op.setx := fx or not f_zero(op.archx);
+    op.imm  := (others => '0');
+    return op;
+  end f_decode_fmv;
+  
+  function f_decode_fpu  (x : std_logic_vector; fx, fa, fb : std_logic;
+                          fop : std_logic_vector(2 downto 0); fn : std_logic_vector(1 downto 0)) return t_opa_op is
+    variable op : t_opa_op := f_parse_rtype(x);
+  begin
+    op.archx(c_arch_wide) := fx;
+    op.archa(c_arch_wide) := fa;
+    op.archb(c_arch_wide) := fb;
+    op.setx := fx or not f_zero(op.archx);
+    op.arg.fp.op := fop;
+    op.arg.fp.fn := fn;
+    op.arg.fp.rm := x(14 downto 12);
+    op.arg.smode := c_opa_slow_fp;
+    op.fast      := '0';
+    return op;
+  end f_decode_fpu;
+  
+  -- rs2 selects the variant of these, so the FPU sees zero for its b operand
+  function f_decode_fpu1 (x : std_logic_vector; fx, fa : std_logic;
+                          fop : std_logic_vector(2 downto 0); fn : std_logic_vector(1 downto 0)) return t_opa_op is
+    variable op : t_opa_op := f_decode_fpu(x, fx, fa, '-', fop, fn);
+  begin
+    op.archb := (others => '-');
+    op.getb  := '0';
+    op.imm   := (others => '0');
+    return op;
+  end f_decode_fpu1;
+  
+  function f_decode_opfp (x : std_logic_vector) return t_opa_op is
+    constant c_funct3 : std_logic_vector(2 downto 0) := x(14 downto 12);
+    constant c_funct7 : std_logic_vector(6 downto 0) := x(31 downto 25);
+    constant c_rs2    : std_logic_vector(4 downto 0) := x(24 downto 20);
+    constant c_rm_ok  : boolean := c_funct3 /= "101" and c_funct3 /= "110";
+  begin
+    case c_funct7 is
+      when "0000000" => -- FADD.S
+        if c_rm_ok then return f_decode_fpu(x, '1', '1', '1', c_opa_fp_arith, "00"); end if;
+      when "0000100" => -- FSUB.S
+        if c_rm_ok then return f_decode_fpu(x, '1', '1', '1', c_opa_fp_arith, "01"); end if;
+      when "0001000" => -- FMUL.S
+        if c_rm_ok then return f_decode_fpu(x, '1', '1', '1', c_opa_fp_arith, "10"); end if;
+      when "0010000" => -- FSGNJ.S, FSGNJN.S, FSGNJX.S
+        if c_funct3 = "000" and c_rs2 = x(19 downto 15) then return f_decode_fmv(x, '1', '1'); end if;
+        if c_funct3(2) = '0' and c_funct3 /= "011" then
+          return f_decode_fpu(x, '1', '1', '1', c_opa_fp_sgnj, c_funct3(1 downto 0));
+        end if;
+      when "0010100" => -- FMIN.S, FMAX.S
+        if c_funct3(2 downto 1) = "00" then
+          return f_decode_fpu(x, '1', '1', '1', c_opa_fp_minmax, c_funct3(1 downto 0));
+        end if;
+      when "1010000" => -- FLE.S, FLT.S, FEQ.S
+        if c_funct3(2) = '0' and c_funct3 /= "011" then
+          return f_decode_fpu(x, '0', '1', '1', c_opa_fp_cmp, c_funct3(1 downto 0));
+        end if;
+      when "1100000" => -- FCVT.W.S, FCVT.WU.S
+        if c_rm_ok and c_rs2(4 downto 1) = "0000" then
+          return f_decode_fpu1(x, '0', '1', c_opa_fp_f2i, '0' & c_rs2(0));
+        end if;
+      when "1101000" => -- FCVT.S.W, FCVT.S.WU
+        if c_rm_ok and c_rs2(4 downto 1) = "0000" then
+          return f_decode_fpu1(x, '1', '0', c_opa_fp_i2f, '0' & c_rs2(0));
+        end if;
+      when "1110000" => -- FMV.X.W, FCLASS.S
+        if c_rs2 = "00000" and c_funct3 = "000" then return f_decode_fmv(x, '0', '1'); end if;
+        if c_rs2 = "00000" and c_funct3 = "001" then
+          return f_decode_fpu1(x, '0', '1', c_opa_fp_class, "00");
+        end if;
+      when "1111000" => -- FMV.W.X
+        if c_rs2 = "00000" and c_funct3 = "000" then return f_decode_fmv(x, '1', '0'); end if;
+      when others => null;
+    end case;
+    return c_opa_op_bad;
+  end f_decode_opfp;
+  
   function f_opa_accept_rv32(config : t_opa_config) return std_logic is
   begin
     assert (config.reg_width = 32) report "RV32 requires 32-bit registers" severity failure;
@@ -763,6 +877,15 @@ package body opa_riscv_pkg is
           when "010"  => return f_decode_sw(x);
           when others => return c_opa_op_bad;
         end case;
+      when "0000111"  => --
+        if config.ieee_fp and c_funct3 = "010" then return f_decode_flw(x); end if;
+        return c_opa_op_bad;
+      when "0100111"  => --
+        if config.ieee_fp and c_funct3 = "010" then return f_decode_fsw(x); end if;
+        return c_opa_op_bad;
+      when "1010011"  => --
+        if config.ieee_fp then return f_decode_opfp(x); end if;
+        return c_opa_op_bad;
       when "0010011"  => --
         case c_funct3 is
           when "000"  => return f_decode_addi(x);
@@ -821,4 +944,55 @@ package body opa_riscv_pkg is
       when others         => return c_opa_op_bad;
     end case;
   end f_opa_decode_rv32;
+  
+  -- Pairs that decode fuses into a single op; x is the first op, y the second.
+  -- The fused op takes the place (and PC) of x. Result has fuse='0' otherwise.
+  --   lui   rd, hi ; addi rd, rd, lo => rd = hi+lo
+  --   auipc rd, hi ; jalr rd, rd, lo => direct call; rd = PC+8
+  function f_opa_fuse_rv32(config : t_opa_config; x, y : std_logic_vector) return t_opa_op is
+    constant c_opx : std_logic_vector(6 downto 0) := x( 6 downto  0);
+    constant c_opy : std_logic_vector(6 downto 0) := y( 6 downto  0);
+    constant c_f3y : std_logic_vector(2 downto 0) := y(14 downto 12);
+    variable same  : std_logic;
+    variable lo    : std_logic_vector(31 downto 0);
+    variable op    : t_opa_op := c_opa_op_undef;
+  begin
+    -- y reads and overwrites the register x wrote, so nothing else sees x's result
+    same := f_opa_and(not (x(11 downto 7) xor y(11 downto 7))) and
+            f_opa_and(not (x(11 downto 7) xor y(19 downto 15)));
+    lo := (others => y(31));
+    lo(10 downto 0) := y(30 downto 20);
+    op.fuse := '0';
+    
+    if c_opx = "0110111" and c_opy = "0010011" and c_f3y = "000" and same = '1' then
+      op := f_decode_lui(x);
+      op.imm(31 downto 0) := std_logic_vector(unsigned(op.imm(31 downto 0)) + unsigned(lo));
+      op.fuse := '1';
+    end if;
+    
+    -- x0 cannot be fused; jalr would then be absolute
+    if c_opx = "0010111" and c_opy = "1100111" and c_f3y = "000" and same = '1' and f_opa_or(x(11 downto 7)) = '1' then
+      op := f_parse_utype(x);
+      op.imm(31 downto 0) := std_logic_vector(unsigned(op.imm(31 downto 0)) + unsigned(lo));
+      op.immb  := op.imm;
+      op.jump  := '1';
+      op.take  := '1';
+      op.force := '1';
+      op.pop   := '0';
+      op.push  := f_one(op.archx);
+      
+      op.arg.adder.eq    := '0';
+      op.arg.adder.nota  := '0';
+      op.arg.adder.notb  := '0';
+      op.arg.adder.cin   := '0';
+      op.arg.adder.sign  := '1'; -- link over the jalr
+      op.arg.adder.fault := '-';
+      op.arg.fmode       := c_opa_fast_jump;
+      op.fast            := '1';
+      op.fuse            := '1';
+    end if;
+    
+    return op;
+  end f_opa_fuse_rv32;
+  
 end opa_riscv_pkg;
@@ -41,7 +41,8 @@ use work.opa_components_pkg.all; -- for opa_lfsr
 
 entity opa_sim_tb is
   generic (
-    init_file : string := "");
+    init_file : string  := "";
+    d_latency : natural := 1); -- cycles from an accepted d_stb to its d_ack
 end opa_sim_tb;
 
 architecture rtl of opa_sim_tb is
@@ -81,6 +82,11 @@ architecture rtl of opa_sim_tb is
   signal p_data_o : std_logic_vector(c_config.reg_width  -1 downto 0);
   signal p_data_i : std_logic_vector(c_config.reg_width  -1 downto 0);
   
+  -- Data bus replies travel down this pipeline to model memory latency
+  type t_data_pipe is array(natural range <>) of std_logic_vector(c_config.reg_width-1 downto 0);
+  signal r_dack : std_logic_vector(d_latency-1 downto 0);
+  signal r_ddat : t_data_pipe(d_latency-1 downto 0);
+  
   shared variable ram : t_word_array(c_demo_ram'range) := c_demo_ram;
   
 begin
@@ -160,20 +166,26 @@ begin
       p_data_o  => p_data_o,
       p_data_i  => p_data_i);
   
+  assert (d_latency >= 1)
+  report "opa_sim_tb: d_latency must be at least 1"
+  severity failure;
+  
   memory : process(clk, rstn) is
     variable da, ia : integer;
+    variable dack   : std_logic;
+    variable ddat   : std_logic_vector(c_config.reg_width-1 downto 0);
   begin
     if rstn = '0' then
       i_ack    <= '0';
       i_data   <= (others => '0');
-      d_ack    <= '0';
-      d_data_i <= (others => '0');
+      r_dack   <= (others => '0');
+      r_ddat   <= (others => (others => '0'));
     elsif rising_edge(clk) then
       i_ack    <= i_cyc and i_stb and not i_stall;
-      d_ack    <= d_cyc and d_stb and not d_stall;
+      dack     := d_cyc and d_stb and not d_stall;
       
       i_data   <= (others => 'X');
-      d_data_i <= (others => 'X');
+      ddat     := (others => 'X');
       
       assert (f_opa_safe(i_cyc) = '1') report "Meta-value on i_cyc" severity failure;
       assert (f_opa_safe(i_stb) = '1') report "Meta-value on i_stb" severity failure;
@@ -203,7 +215,7 @@ begin
           severity warning;
         else
           if d_we = '0' then
-            d_data_i <= ram(da);
+            ddat := ram(da);
           else
             for b in d_sel'range loop
               if d_sel(b) = '1' then
@@ -213,9 +225,15 @@ begin
           end if;
         end if;
       end if;
+      
+      r_dack <= r_dack(d_latency-2 downto 0) & dack;
+      r_ddat <= r_ddat(d_latency-2 downto 0) & ddat;
     end if;
   end process;
   
+  d_ack    <= r_dack(d_latency-1);
+  d_data_i <= r_ddat(d_latency-1);
+  
   pbus : process(clk) is
     variable bufo : line;
     variable bufi : line;
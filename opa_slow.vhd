@@ -58,10 +58,14 @@ entity opa_slow is
     l1d_we_o       : out std_logic;
     l1d_sext_o     : out std_logic;
     l1d_size_o     : out std_logic_vector(1 downto 0);
+    l1d_pref_o     : out std_logic;
+    l1d_pc_o       : out std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     l1d_addr_o     : out std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0);
     l1d_data_o     : out std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0);
     l1d_oldest_o   : out std_logic; -- delivered 1 cycle after stb
     l1d_retry_i    : in  std_logic; -- valid 1 cycle after stb_o 
+    l1d_fault_i    : in  std_logic; -- valid 1 cycle after stb_o
+    l1d_trap_i     : in  std_logic_vector(f_opa_adr_wide(g_config)-1 downto f_opa_op_align(g_isa));
     l1d_data_i     : in  std_logic_vector(f_opa_reg_wide(g_config)-1 downto 0); -- 2 cycles
     
     issue_oldest_i : in  std_logic;
@@ -87,9 +91,14 @@ architecture rtl of opa_slow is
   signal r_rega    : std_logic_vector(c_reg_wide-1 downto 0);
   signal r_regb    : std_logic_vector(c_reg_wide-1 downto 0);
   signal r_imm     : std_logic_vector(c_imm_wide-1 downto 0);
-  signal r_mode1   : std_logic_vector(1 downto 0);
-  signal r_mode2   : std_logic_vector(1 downto 0);
-  signal r_mode3   : std_logic_vector(1 downto 0);
+  signal r_pc      : std_logic_vector(c_adr_wide-1 downto f_opa_op_align(g_isa));
+  signal r_pc2     : std_logic_vector(c_adr_wide-1 downto f_opa_op_align(g_isa));
+  signal r_pcf1    : std_logic_vector(regfile_pcf_i'range);
+  signal r_pcf2    : std_logic_vector(regfile_pcf_i'range);
+  signal r_mode1   : std_logic_vector(2 downto 0);
+  signal r_mode2   : std_logic_vector(2 downto 0);
+  signal r_mode3   : std_logic_vector(2 downto 0);
+  signal s_regx    : std_logic_vector(c_reg_wide-1 downto 0);
   
   signal s_mul     : t_opa_mul;
   signal s_product : std_logic_vector(2*c_reg_wide-1 downto 0);
@@ -97,6 +106,15 @@ architecture rtl of opa_slow is
   signal r_high1   : std_logic;
   signal r_high2   : std_logic;
   signal r_high3   : std_logic;
+  
+  signal r_mul1    : t_opa_mul;
+  signal s_div_stb : std_logic;
+  signal s_div_done: std_logic;
+  signal s_div_q   : std_logic_vector(c_reg_wide-1 downto 0);
+  signal s_div_r   : std_logic_vector(c_reg_wide-1 downto 0);
+  signal r_div2    : std_logic := '0';
+  signal r_div3    : std_logic := '0';
+  signal r_div_out : std_logic_vector(c_reg_wide-1 downto 0);
 
   signal s_ldst    : t_opa_ldst;
   signal r_ldst    : t_opa_ldst;
@@ -115,27 +133,48 @@ architecture rtl of opa_slow is
   signal s_sext_a  : std_logic_vector(c_reg_wide-1 downto 0);
   signal r_sext_a  : std_logic_vector(c_reg_wide-1 downto 0);
   signal r_sext_o  : std_logic_vector(c_reg_wide-1 downto 0);
+  
+  signal s_fp      : t_opa_fp;
+  signal s_fp_out  : std_logic_vector(c_reg_wide-1 downto 0);
+  signal r_fp2     : std_logic := '0';
+  signal r_fp3     : std_logic := '0';
+  signal r_fp4     : std_logic := '0';
 
 begin
 
-  issue_retry_o   <= l1d_retry_i;
-  issue_fault_o   <= '0';
-  issue_pc_o      <= (others => '0');
-  issue_pcf_o     <= (others => '0');
-  issue_pcn_o     <= (others => '0');
+  -- A divide retries until the divider holds its result. Divides are not ordered;
+  -- opa_prim_div lets the oldest op take the divider, so none can starve.
+  issue_retry_o   <= l1d_retry_i or (r_div2 and not s_div_done);
+  -- A page fault is taken like a mispredicted branch, once the op is oldest:
+  -- the op does not commit and fetch continues at the trap vector.
+  issue_fault_o   <= l1d_fault_i and issue_oldest_i;
+  issue_pc_o      <= r_pc2;
+  issue_pcf_o     <= r_pcf2;
+  issue_pcn_o     <= l1d_trap_i;
   
   s_arg  <= f_opa_arg_from_vec(regfile_arg_i);
   s_mul  <= s_arg.mul;
   s_ldst <= s_arg.ldst;
   s_shift<= s_arg.shift;
   s_sext <= s_arg.sext;
+  s_fp   <= s_arg.fp;
   
   control : process(clk_i, rst_n_i) is
   begin
     if rst_n_i = '0' then
-      r_stb <= '0';
+      r_stb  <= '0';
+      r_div2 <= '0';
+      r_div3 <= '0';
+      r_fp2  <= '0';
+      r_fp3  <= '0';
+      r_fp4  <= '0';
     elsif rising_edge(clk_i) then
-      r_stb <= regfile_stb_i;
+      r_stb  <= regfile_stb_i;
+      r_div2 <= s_div_stb;
+      r_div3 <= r_div2;
+      r_fp2  <= r_stb and f_opa_eq(r_mode1, c_opa_slow_fp);
+      r_fp3  <= r_fp2;
+      r_fp4  <= r_fp3;
     end if;
   end process;
   
@@ -145,6 +184,10 @@ begin
       r_rega  <= regfile_rega_i;
       r_regb  <= regfile_regb_i;
       r_imm   <= regfile_imm_i;
+      r_pc    <= regfile_pc_i;
+      r_pc2   <= r_pc;
+      r_pcf1  <= regfile_pcf_i;
+      r_pcf2  <= r_pcf1;
       r_ldst  <= s_ldst;
       r_mode1 <= s_arg.smode;
       r_mode2 <= r_mode1;
@@ -152,6 +195,12 @@ begin
       r_high1 <= s_mul.high;
       r_high2 <= r_high1;
       r_high3 <= r_high2;
+      r_mul1  <= s_mul;
+      if r_high2 = '1' then
+        r_div_out <= s_div_r;
+      else
+        r_div_out <= s_div_q;
+      end if;
     end if;
   end process;
   
@@ -160,24 +209,45 @@ begin
       g_wide   => c_reg_wide,
       g_regout => true,
       g_regwal => false,
+      g_split  => g_target.mul_split,
       g_target => g_target)
     port map(
       clk_i    => clk_i,
+      sexta_i  => s_mul.sexta,
+      sextb_i  => s_mul.sextb,
       a_i      => regfile_rega_i,
       b_i      => regfile_regb_i,
       x_o      => s_product);
 
-  with r_high3 select
+  s_div_stb <= r_stb and f_opa_eq(r_mode1, c_opa_slow_mul) and r_mul1.divide;
+  div : opa_prim_div
+    generic map(
+      g_wide   => c_reg_wide)
+    port map(
+      clk_i    => clk_i,
+      rst_n_i  => rst_n_i,
+      stb_i    => s_div_stb,
+      old_i    => issue_oldest_i,
+      sign_i   => r_mul1.sextb,
+      a_i      => r_rega,
+      b_i      => r_regb,
+      done_o   => s_div_done,
+      q_o      => s_div_q,
+      r_o      => s_div_r);
+  
   s_mul_out <= 
-    s_product(  c_reg_wide-1 downto          0) when '0',
-    s_product(2*c_reg_wide-1 downto c_reg_wide) when '1',
-    (others => 'X') when others;
+    r_div_out                                   when r_div3  = '1' else
+    s_product(  c_reg_wide-1 downto          0) when r_high3 = '0' else
+    s_product(2*c_reg_wide-1 downto c_reg_wide) when r_high3 = '1' else
+    (others => 'X');
   
   -- Hand over memory accesses to the L1d
   l1d_stb_o    <= r_stb and f_opa_eq(r_mode1, c_opa_slow_ldst);
   l1d_we_o     <= r_ldst.store;
   l1d_sext_o   <= r_ldst.sext;
   l1d_size_o   <= r_ldst.size;
+  l1d_pref_o   <= r_ldst.pref;
+  l1d_pc_o     <= r_pc;
   l1d_addr_o   <= std_logic_vector(signed(r_rega) + signed(r_imm));
   l1d_data_o   <= r_regb;
   l1d_oldest_o <= issue_oldest_i;
@@ -226,13 +296,34 @@ begin
     end if;
   end process;
   
+  -- Single precision takes one cycle more than the multiplier. Issue schedules
+  -- these as long ops: nothing enters this EU right after one, so the result
+  -- can take the output slot that follower would have used.
+  fpu : if f_opa_support_fp(g_config) generate
+    prim : opa_prim_fpu
+      generic map(
+        g_target => g_target)
+      port map(
+        clk_i    => clk_i,
+        op_i     => s_fp.op,
+        fn_i     => s_fp.fn,
+        rm_i     => s_fp.rm,
+        a_i      => regfile_rega_i,
+        b_i      => regfile_regb_i,
+        x_o      => s_fp_out);
+  end generate;
+  nofpu : if not f_opa_support_fp(g_config) generate
+    s_fp_out <= (others => 'X');
+  end generate;
+  
   -- pick the output
   with r_mode3 select
-  regfile_regx_o <=
+  s_regx <=
     s_mul_out       when c_opa_slow_mul,
     l1d_data_i      when c_opa_slow_ldst,
     r_shout         when c_opa_slow_shift,
     r_sext_o        when c_opa_slow_sext,
     (others => 'X') when others;
+  regfile_regx_o <= s_fp_out when r_fp4 = '1' else s_regx;
 
 end rtl;
@@ -22,6 +22,8 @@ for i in 				\
 	opa_lcell.vhd			\
 	opa_prim_ternary.vhd		\
 	opa_prim_mul.vhd		\
+	opa_prim_div.vhd		\
+	opa_prim_fpu.vhd		\
 	opa_lfsr.vhd			\
 	opa_prefixsum.vhd		\
 	opa_predict.vhd			\
@@ -45,6 +47,6 @@ echo link
 ghdl -e --std=93 --ieee=standard --syn-binding opa_sim_tb
 
 echo run
-./opa_sim_tb --stop-time=80us --wave=testbench.ghw
+./opa_sim_tb -gd_latency="${latency:-1}" --stop-time=80us --wave=testbench.ghw
 
 gtkwave testbench.ghw wave.gtkw